@@ -0,0 +1,385 @@
+#include "ContractionHierarchy.h"
+#include <queue>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+const double CH_INF = 1e18;
+const int WITNESS_SETTLE_LIMIT = 500;   // 见证搜索最多确定的点数，超过就当作没找到（多加一条捷径，结果仍正确）
+const char CH_MAGIC[4] = {'C', 'H', 'v', '1'};
+
+typedef ContractionHierarchy::Edge Edge;
+
+// 在边表里找到 to 相同的边就取较小的权重，否则追加；返回是否追加了新边
+bool addOrRelax(vector<Edge>& edges, const Edge& e) {
+    for (auto& x : edges) {
+        if (x.to == e.to) {
+            if (e.weight < x.weight) x = e;
+            return false;
+        }
+    }
+    edges.push_back(e);
+    return true;
+}
+
+bool hasEdge(const vector<Edge>& edges, int to) {
+    for (const auto& x : edges) {
+        if (x.to == to) return true;
+    }
+    return false;
+}
+
+// 预处理期间的图：每个点的出边和入边（入边的 to 存的是起点）
+struct Builder {
+    int n;
+    vector<vector<Edge>> out, in;
+    vector<bool> contracted;
+    vector<int> deletedNeighbors;
+    vector<int> level;              // 层次深度：收缩邻居后至少比它高一层
+
+    // 见证搜索的工作区
+    vector<double> dist;
+    vector<int> touched;
+
+    // 从 src 出发、不经过 skip 的有限 Dijkstra，超过 bound 或确定够 WITNESS_SETTLE_LIMIT 个点就停
+    void witnessSearch(int src, int skip, double bound) {
+        for (int v : touched) dist[v] = CH_INF;
+        touched.clear();
+        typedef pair<double, int> Item;
+        priority_queue<Item, vector<Item>, greater<Item>> pq;
+        dist[src] = 0;
+        touched.push_back(src);
+        pq.push({0, src});
+        int settled = 0;
+        while (!pq.empty()) {
+            auto [d, u] = pq.top();
+            pq.pop();
+            if (d > dist[u]) continue;
+            if (d > bound || ++settled > WITNESS_SETTLE_LIMIT) break;
+            for (const auto& e : out[u]) {
+                if (e.to == skip || contracted[e.to]) continue;
+                double nd = d + e.weight;
+                if (nd < dist[e.to]) {
+                    if (dist[e.to] == CH_INF) touched.push_back(e.to);
+                    dist[e.to] = nd;
+                    pq.push({nd, e.to});
+                }
+            }
+        }
+    }
+
+    // 收缩 v 新增的捷径数（已有 u->w 边只是改小权重，不算）；apply 为 true 时真的加进图里
+    int contract(int v, bool apply) {
+        int added = 0;
+        for (const auto& in_e : in[v]) {
+            int u = in_e.to;
+            if (contracted[u]) continue;
+            double maxOut = 0;
+            for (const auto& e : out[v]) {
+                if (!contracted[e.to] && e.to != u) maxOut = max(maxOut, e.weight);
+            }
+            if (maxOut == 0) continue;
+            witnessSearch(u, v, in_e.weight + maxOut);
+            for (const auto& e : out[v]) {
+                int w = e.to;
+                if (contracted[w] || w == u) continue;
+                double via = in_e.weight + e.weight;
+                if (dist[w] <= via) continue;   // 有不经过 v 的路不比它长，不用捷径
+                if (apply) {
+                    if (addOrRelax(out[u], {w, via, v})) added++;
+                    addOrRelax(in[w], {u, via, v});
+                } else if (!hasEdge(out[u], w)) {
+                    added++;
+                }
+            }
+        }
+        return added;
+    }
+
+    // 重要度：边差（新增捷径 - 删掉的边）+ 已收缩的邻居数，让收缩在图上均匀铺开
+    int priority(int v) {
+        int removed = 0;
+        for (const auto& e : in[v]) if (!contracted[e.to]) removed++;
+        for (const auto& e : out[v]) if (!contracted[e.to]) removed++;
+        return 2 * (contract(v, false) - removed) + deletedNeighbors[v] + level[v];
+    }
+};
+
+}
+
+ContractionHierarchy::ContractionHierarchy() : n(0), shortcuts(0) {}
+
+void ContractionHierarchy::build(const vector<vector<pair<int, double>>>& adj) {
+    Builder b;
+    b.n = n = adj.size();
+    b.out.assign(n, {});
+    b.in.assign(n, {});
+    b.contracted.assign(n, false);
+    b.deletedNeighbors.assign(n, 0);
+    b.level.assign(n, 0);
+    b.dist.assign(n, CH_INF);
+    for (int u = 0; u < n; u++) {
+        for (const auto& [v, w] : adj[u]) {
+            if (v == u) continue;
+            addOrRelax(b.out[u], {v, w, -1});
+            addOrRelax(b.in[v], {u, w, -1});
+        }
+    }
+
+    // 懒更新：弹出时重新算一次重要度，比堆里下一个大就放回去
+    typedef pair<int, int> Item;
+    priority_queue<Item, vector<Item>, greater<Item>> pq;
+    for (int v = 0; v < n; v++) pq.push({b.priority(v), v});
+    rank.assign(n, -1);
+    shortcuts = 0;
+    int order = 0;
+    while (!pq.empty()) {
+        int v = pq.top().second;
+        pq.pop();
+        if (b.contracted[v]) continue;
+        int p = b.priority(v);
+        if (!pq.empty() && p > pq.top().first) {
+            pq.push({p, v});
+            continue;
+        }
+        shortcuts += b.contract(v, true);
+        b.contracted[v] = true;
+        rank[v] = order++;
+        for (const auto& e : b.in[v]) {
+            if (b.contracted[e.to]) continue;
+            b.deletedNeighbors[e.to]++;
+            b.level[e.to] = max(b.level[e.to], b.level[v] + 1);
+        }
+        for (const auto& e : b.out[v]) {
+            if (b.contracted[e.to]) continue;
+            b.deletedNeighbors[e.to]++;
+            b.level[e.to] = max(b.level[e.to], b.level[v] + 1);
+        }
+    }
+
+    // 每条边只放一次：终点更重要的放 up[起点]，起点更重要的放 down[终点]
+    up.assign(n, {});
+    down.assign(n, {});
+    for (int u = 0; u < n; u++) {
+        for (const auto& e : b.out[u]) {
+            if (rank[e.to] > rank[u]) up[u].push_back(e);
+            else down[e.to].push_back({u, e.weight, e.mid});
+        }
+    }
+    resetWorkspace();
+}
+
+void ContractionHierarchy::resetWorkspace() const {
+    distF.assign(n, CH_INF);
+    distB.assign(n, CH_INF);
+    prevF.assign(n, -1);
+    prevB.assign(n, -1);
+    viaF.assign(n, {-1, 0, -1});
+    viaB.assign(n, {-1, 0, -1});
+    touched.clear();
+}
+
+const ContractionHierarchy::Edge* ContractionHierarchy::findEdge(int u, int v) const {
+    if (rank[u] < rank[v]) {
+        for (const auto& e : up[u]) if (e.to == v) return &e;
+    } else {
+        for (const auto& e : down[v]) if (e.to == u) return &e;
+    }
+    return nullptr;
+}
+
+// 把 u -> e.to 展开成原始路径（不含 u）追加到 path
+void ContractionHierarchy::unpack(int u, const Edge& e, vector<int>& path) const {
+    if (e.mid == -1) {
+        path.push_back(e.to);
+        return;
+    }
+    const Edge* first = findEdge(u, e.mid);
+    const Edge* second = findEdge(e.mid, e.to);
+    unpack(u, {e.mid, first->weight, first->mid}, path);
+    unpack(e.mid, {e.to, second->weight, second->mid}, path);
+}
+
+pair<vector<int>, double> ContractionHierarchy::query(int src, int dest) const {
+    if (n == 0 || src < 0 || dest < 0 || src >= n || dest >= n) return {{}, -1};
+    if (src == dest) return {{src}, 0};
+
+    for (int v : touched) {
+        distF[v] = distB[v] = CH_INF;
+        prevF[v] = prevB[v] = -1;
+    }
+    touched.clear();
+
+    typedef pair<double, int> Item;
+    priority_queue<Item, vector<Item>, greater<Item>> pqF, pqB;
+    distF[src] = 0;
+    distB[dest] = 0;
+    touched.push_back(src);
+    touched.push_back(dest);
+    pqF.push({0, src});
+    pqB.push({0, dest});
+    double best = CH_INF;
+    int meet = -1;
+
+    // 两边交替，各自只往更重要的点走；队首都不小于当前最优时就不可能更好了
+    // stall-on-demand：若从某个更重要的点沿反方向的边过来比 d 还短，u 不在最短路上，不必往外扩
+    auto step = [&](priority_queue<Item, vector<Item>, greater<Item>>& pq,
+                    const vector<vector<Edge>>& edges, const vector<vector<Edge>>& reverseEdges,
+                    vector<double>& dist, vector<double>& other,
+                    vector<int>& prev, vector<Edge>& via) {
+        auto [d, u] = pq.top();
+        pq.pop();
+        if (d > dist[u]) return;
+        if (other[u] < CH_INF && d + other[u] < best) {
+            best = d + other[u];
+            meet = u;
+        }
+        for (const auto& e : reverseEdges[u]) {
+            if (dist[e.to] + e.weight < d) return;
+        }
+        for (const auto& e : edges[u]) {
+            double nd = d + e.weight;
+            if (nd < dist[e.to]) {
+                if (distF[e.to] == CH_INF && distB[e.to] == CH_INF) touched.push_back(e.to);
+                dist[e.to] = nd;
+                prev[e.to] = u;
+                via[e.to] = e;
+                pq.push({nd, e.to});
+            }
+        }
+    };
+    while (!pqF.empty() || !pqB.empty()) {
+        double topF = pqF.empty() ? CH_INF : pqF.top().first;
+        double topB = pqB.empty() ? CH_INF : pqB.top().first;
+        if (min(topF, topB) >= best) break;
+        if (topF <= topB) step(pqF, up, down, distF, distB, prevF, viaF);
+        else step(pqB, down, up, distB, distF, prevB, viaB);
+    }
+    if (meet == -1) return {{}, -1};
+
+    // 正向部分：从相遇点沿 prevF 回到起点，再逐段展开
+    vector<int> chain;
+    for (int v = meet; v != src; v = prevF[v]) chain.push_back(v);
+    reverse(chain.begin(), chain.end());
+    vector<int> path = {src};
+    int cur = src;
+    for (int v : chain) {
+        unpack(cur, viaF[v], path);
+        cur = v;
+    }
+    // 反向部分：viaB[v] 是 v -> prevB[v] 这条边（存成 down[prevB[v]] 里的 to = v）
+    for (int v = meet; v != dest; v = prevB[v]) {
+        const Edge& e = viaB[v];
+        unpack(v, {prevB[v], e.weight, e.mid}, path);
+    }
+    return {path, best};
+}
+
+uint64_t ContractionHierarchy::fingerprint(const vector<vector<pair<int, double>>>& adj) {
+    // FNV-1a
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&](const void* p, size_t len) {
+        const unsigned char* s = static_cast<const unsigned char*>(p);
+        for (size_t i = 0; i < len; i++) {
+            h ^= s[i];
+            h *= 1099511628211ULL;
+        }
+    };
+    int64_t count = adj.size();
+    mix(&count, sizeof(count));
+    for (size_t u = 0; u < adj.size(); u++) {
+        for (const auto& [v, w] : adj[u]) {
+            int32_t from = u, to = v;
+            mix(&from, sizeof(from));
+            mix(&to, sizeof(to));
+            mix(&w, sizeof(w));
+        }
+    }
+    return h;
+}
+
+// 文件格式（本机字节序）：魔数 "CHv1"、指纹、节点数、捷径数、rank[n]，
+// 然后每个点的 up 边数 + 边、down 边数 + 边，边为 (int32 to, double weight, int32 mid)
+bool ContractionHierarchy::save(const string& filename, uint64_t graphFingerprint) const {
+    ofstream file(filename, ios::binary);
+    if (!file.is_open()) return false;
+    auto put = [&](const auto& x) { file.write(reinterpret_cast<const char*>(&x), sizeof(x)); };
+    auto putEdges = [&](const vector<Edge>& edges) {
+        put(int32_t(edges.size()));
+        for (const auto& e : edges) {
+            put(int32_t(e.to));
+            put(e.weight);
+            put(int32_t(e.mid));
+        }
+    };
+    file.write(CH_MAGIC, sizeof(CH_MAGIC));
+    put(graphFingerprint);
+    put(int32_t(n));
+    put(int32_t(shortcuts));
+    for (int r : rank) put(int32_t(r));
+    for (int v = 0; v < n; v++) {
+        putEdges(up[v]);
+        putEdges(down[v]);
+    }
+    return bool(file);
+}
+
+bool ContractionHierarchy::load(const string& filename, uint64_t graphFingerprint) {
+    ifstream file(filename, ios::binary);
+    if (!file.is_open()) return false;
+    auto get = [&](auto& x) { return bool(file.read(reinterpret_cast<char*>(&x), sizeof(x))); };
+
+    char magic[4];
+    uint64_t fp;
+    int32_t count, sc;
+    if (!file.read(magic, sizeof(magic)) || memcmp(magic, CH_MAGIC, sizeof(magic)) != 0) return false;
+    if (!get(fp) || fp != graphFingerprint) return false;
+    if (!get(count) || !get(sc) || count < 0) return false;
+
+    // rank 必须是 [0, count) 的一个排列，否则上行/下行搜索的前提不成立
+    vector<int> r(count);
+    vector<bool> seen(count, false);
+    for (auto& x : r) {
+        int32_t v;
+        if (!get(v) || v < 0 || v >= count || seen[v]) return false;
+        seen[v] = true;
+        x = v;
+    }
+    auto getEdges = [&](vector<Edge>& edges) {
+        int32_t m;
+        if (!get(m) || m < 0) return false;
+        edges.resize(m);
+        for (auto& e : edges) {
+            int32_t to, mid;
+            if (!get(to) || !get(e.weight) || !get(mid)) return false;
+            if (to < 0 || to >= count || mid < -1 || mid >= count) return false;
+            e.to = to;
+            e.mid = mid;
+        }
+        return true;
+    };
+    // up[v] 和 down[v] 的另一端都必须比 v 的层次高
+    auto higher = [&](int v, const vector<Edge>& edges) {
+        for (const auto& e : edges) {
+            if (r[e.to] <= r[v]) return false;
+        }
+        return true;
+    };
+    vector<vector<Edge>> u(count), d(count);
+    for (int v = 0; v < count; v++) {
+        if (!getEdges(u[v]) || !getEdges(d[v])) return false;
+        if (!higher(v, u[v]) || !higher(v, d[v])) return false;
+    }
+
+    n = count;
+    shortcuts = sc;
+    rank.swap(r);
+    up.swap(u);
+    down.swap(d);
+    resetWorkspace();
+    return true;
+}
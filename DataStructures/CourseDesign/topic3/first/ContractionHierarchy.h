@@ -0,0 +1,59 @@
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <cstdint>
+using namespace std;
+
+// 收缩层次（Contraction Hierarchies）
+// 预处理：按"重要度"从低到高依次收缩节点，收缩 v 时若 u->v->w 是 u 到 w 的唯一最短路，
+// 就加一条捷径 u->w（记下中间点 v），保证去掉 v 后剩下的图距离不变。
+// 查询：起点只沿"通往更高层"的边正向搜，终点只沿"来自更高层"的边反向搜，两边相遇处取最小，
+// 每边只看到很小的一块图，全国规模的路网也是毫秒以内；捷径按中间点递归展开还原真实路径。
+// 支持有向图，预处理结果可以存盘，下次直接加载。
+class ContractionHierarchy {
+public:
+    struct Edge {
+        int to;
+        double weight;
+        int mid;    // 捷径的中间点，原始边为 -1
+    };
+
+    ContractionHierarchy();
+
+    // adj[u] 为 u 的出边 (v, w)，w > 0
+    void build(const vector<vector<pair<int, double>>>& adj);
+    bool isBuilt() const { return n > 0; }
+    int nodeCount() const { return n; }
+    int shortcutCount() const { return shortcuts; }
+
+    // 返回 (路径, 距离)，不可达时路径为空、距离为 -1
+    pair<vector<int>, double> query(int src, int dest) const;
+
+    // 输入图的指纹（节点数、边数、边权），用来判断磁盘上的预处理结果是否过期
+    static uint64_t fingerprint(const vector<vector<pair<int, double>>>& adj);
+    bool save(const string& filename, uint64_t graphFingerprint) const;
+    // 文件不存在、格式不对或指纹不符都返回 false
+    bool load(const string& filename, uint64_t graphFingerprint);
+
+private:
+    int n;
+    int shortcuts;
+    vector<int> rank;               // 收缩顺序，越大越重要
+    vector<vector<Edge>> up;        // up[u]：u -> v 且 rank[v] > rank[u]
+    vector<vector<Edge>> down;      // down[v]：u -> v 且 rank[u] > rank[v]，反向搜索用
+
+    // 查询用的工作区，只清理访问过的点，避免每次 O(n) 初始化
+    mutable vector<double> distF, distB;
+    mutable vector<int> prevF, prevB;
+    mutable vector<Edge> viaF, viaB;
+    mutable vector<int> touched;
+
+    void resetWorkspace() const;
+    void unpack(int u, const Edge& e, vector<int>& path) const;
+    const Edge* findEdge(int u, int v) const;
+};
+
+#endif
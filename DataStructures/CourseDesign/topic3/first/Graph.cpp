@@ -7,6 +7,11 @@
 #include <cmath>
 #include <iomanip>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+#include <climits>
 
 using namespace std;
 
@@ -37,11 +42,9 @@ bool Graph::loadFromCSV(const string& filename) {
     // 初始化邻接矩阵
     int n = cities.size();
     adjMatrix.resize(n, vector<double>(n, INF));
-    next.resize(n, vector<int>(n, -1));
     
     for (int i = 0; i < n; i++) {
         adjMatrix[i][i] = 0;
-        next[i][i] = i;
     }
     
     // 读取距离数据
@@ -58,7 +61,6 @@ bool Graph::loadFromCSV(const string& filename) {
                     double dist = stod(cell);
                     if (dist > 0) {
                         adjMatrix[row][col] = dist;
-                        next[row][col] = col;
                         cities[row].neighbors.push_back({col, dist});
                     }
                 } catch (...) {
@@ -71,6 +73,8 @@ bool Graph::loadFromCSV(const string& filename) {
     }
     
     floydComputed = false;
+    ch = ContractionHierarchy();
+    chCacheFile = filename + ".ch";
     cout << "成功加载 " << cities.size() << " 个城市" << endl;
     return true;
 }
@@ -156,13 +160,136 @@ vector<int> Graph::dijkstra(int src, int dest) {
     return path;
 }
 
+// 分块大小：一块 64×64 个 double 是 32KB，三块（i 行块、k 行块、结果块）基本能留在 L2
+static const int FLOYD_BLOCK = 64;
+
+// 块数少于它时整个 Floyd 在当前线程跑：矩阵小，线程同步的开销比省下的计算还多
+static const int FLOYD_PARALLEL_MIN_BLOCKS = 4;
+
+static int floydThreads(int n) {
+    int blocks = (n + FLOYD_BLOCK - 1) / FLOYD_BLOCK;
+    if (blocks < FLOYD_PARALLEL_MIN_BLOCKS) return 1;
+    return min<int>(max(1u, thread::hardware_concurrency()), blocks);
+}
+
+// 可重复使用的屏障（C++17 还没有 std::barrier）：凑齐 count 个线程才一起往下走
+class FloydBarrier {
+public:
+    explicit FloydBarrier(int count) : count(count), waiting(0), generation(0) {}
+    void wait() {
+        unique_lock<mutex> lock(m);
+        int gen = generation;
+        if (++waiting == count) {
+            waiting = 0;
+            generation++;
+            cv.notify_all();
+            return;
+        }
+        cv.wait(lock, [&]() { return gen != generation; });
+    }
+
+private:
+    mutex m;
+    condition_variable cv;
+    int count, waiting, generation;
+};
+
+// 最小加内核：用第 kb 块的中转点更新块 (ib, jb)
+// 最内层 j 循环没有分支（比较结果选值），用 -O3（最好再加 -march=native）编译时 GCC 会向量化
+void Graph::floydBlock(int n, int ib, int jb, int kb) {
+    int i0 = ib * FLOYD_BLOCK, i1 = min(n, i0 + FLOYD_BLOCK);
+    int j0 = jb * FLOYD_BLOCK, j1 = min(n, j0 + FLOYD_BLOCK);
+    int k0 = kb * FLOYD_BLOCK, k1 = min(n, k0 + FLOYD_BLOCK);
+    double* d = floydMatrix.data();
+    int* nx = next.data();
+    
+    for (int k = k0; k < k1; k++) {
+        const double* __restrict dk = d + (size_t)k * n;
+        for (int i = i0; i < i1; i++) {
+            if (i == k) continue; // dist[k][k] = 0，不会更新，跳过也避免 di 和 dk 指向同一行
+            double dik = d[(size_t)i * n + k];
+            if (dik >= INF) continue;
+            int nik = nx[(size_t)i * n + k];
+            double* __restrict di = d + (size_t)i * n;
+            int* __restrict ni = nx + (size_t)i * n;
+            // 分成两趟：先按比较结果改 next，再取 min 改距离；合在一个循环里 GCC 不做向量化
+            for (int j = j0; j < j1; j++) {
+                ni[j] = dik + dk[j] < di[j] ? nik : ni[j];
+            }
+            for (int j = j0; j < j1; j++) {
+                double via = dik + dk[j];
+                di[j] = via < di[j] ? via : di[j];
+            }
+        }
+    }
+}
+
+// 分块 Floyd：对每个中转块 kb 按依赖分三步
+// 1. 对角块 (kb, kb) 自己做一遍；
+// 2. 同一行、同一列的块只依赖对角块，互相独立，并行；
+// 3. 其余块 (ib, jb) 只依赖第 2 步的 (ib, kb) 和 (kb, jb)，按块行并行。
+// 和逐行扫的三重循环结果相同，但每块数据读进缓存后会被反复使用
 void Graph::computeFloyd() {
     if (floydComputed) return;
     
     int n = cities.size();
-    vector<vector<double>> dist = adjMatrix;
+    floydMatrix.assign((size_t)n * n, INF);
+    next.assign((size_t)n * n, -1);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (adjMatrix[i][j] < INF) {
+                floydMatrix[(size_t)i * n + j] = adjMatrix[i][j];
+                next[(size_t)i * n + j] = j;
+            }
+        }
+    }
+    
+    // 工作线程每次 computeFloyd 只创建一次，各阶段之间用屏障同步；
+    // 块按步长交错分给线程（负载比较均匀），线程 0 就是当前线程
+    int blocks = (n + FLOYD_BLOCK - 1) / FLOYD_BLOCK;
+    int threads = floydThreads(n);
+    FloydBarrier barrier(threads);
+    auto worker = [&](int t) {
+        for (int kb = 0; kb < blocks; kb++) {
+            if (t == 0) floydBlock(n, kb, kb, kb);
+            barrier.wait();
+            
+            for (int x = t; x < 2 * blocks; x += threads) {
+                int b = x / 2;
+                if (b == kb) continue;
+                if (x % 2 == 0) floydBlock(n, kb, b, kb);
+                else floydBlock(n, b, kb, kb);
+            }
+            barrier.wait();
+            
+            for (int ib = t; ib < blocks; ib += threads) {
+                if (ib == kb) continue;
+                for (int jb = 0; jb < blocks; jb++) {
+                    if (jb != kb) floydBlock(n, ib, jb, kb);
+                }
+            }
+            barrier.wait();
+        }
+    };
+    vector<thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+    
+    floydComputed = true;
+}
+
+// 原来的三重循环（二维 vector），compareAlgorithms 里用来对照分块版本的结果和耗时
+void Graph::computeFloydReference(vector<vector<double>>& dist, vector<vector<int>>& nxt) const {
+    int n = cities.size();
+    dist = adjMatrix;
+    nxt.assign(n, vector<int>(n, -1));
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (dist[i][j] < INF) nxt[i][j] = j;
+        }
+    }
     
-    // Floyd算法核心
     for (int k = 0; k < n; k++) {
         for (int i = 0; i < n; i++) {
             if (dist[i][k] == INF) continue;
@@ -170,19 +297,18 @@ void Graph::computeFloyd() {
                 if (dist[k][j] == INF) continue;
                 if (dist[i][k] + dist[k][j] < dist[i][j]) {
                     dist[i][j] = dist[i][k] + dist[k][j];
-                    next[i][j] = next[i][k];
+                    nxt[i][j] = nxt[i][k];
                 }
             }
         }
     }
-    
-    floydComputed = true;
 }
 
 vector<int> Graph::floydWarshall(int src, int dest) {
     computeFloyd();
     
-    if (next[src][dest] == -1) {
+    int n = cities.size();
+    if (next[(size_t)src * n + dest] == -1) {
         return {};
     }
     
@@ -191,13 +317,42 @@ vector<int> Graph::floydWarshall(int src, int dest) {
     path.push_back(u);
     
     while (u != dest) {
-        u = next[u][dest];
+        u = next[(size_t)u * n + dest];
         path.push_back(u);
     }
     
     return path;
 }
 
+vector<vector<pair<int, double>>> Graph::adjacencyList() const {
+    vector<vector<pair<int, double>>> adj(cities.size());
+    for (size_t i = 0; i < cities.size(); i++) {
+        adj[i] = cities[i].neighbors;
+    }
+    return adj;
+}
+
+// 收缩层次只需预处理一次：先尝试加载 CSV 旁边的 .ch 文件，指纹对不上（数据变了）再重建并存盘
+void Graph::prepareCH() {
+    if (ch.isBuilt()) return;
+
+    auto adj = adjacencyList();
+    uint64_t fp = ContractionHierarchy::fingerprint(adj);
+    if (ch.load(chCacheFile, fp)) {
+        cout << "已加载收缩层次预处理结果: " << chCacheFile << endl;
+        return;
+    }
+
+    auto start = chrono::high_resolution_clock::now();
+    ch.build(adj);
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+    cout << "收缩层次预处理: " << duration << " ms, 新增捷径 " << ch.shortcutCount() << " 条" << endl;
+    if (!ch.save(chCacheFile, fp)) {
+        cout << "无法保存预处理结果: " << chCacheFile << endl;
+    }
+}
+
 pair<vector<int>, double> Graph::getShortestPath(int src, int dest, int algorithm) {
     vector<int> path;
     double distance = 0;
@@ -211,6 +366,14 @@ pair<vector<int>, double> Graph::getShortestPath(int src, int dest, int algorith
         auto duration = chrono::duration_cast<chrono::microseconds>(end - start).count();
         distance = calculateDistance(path);
         cout << "Dijkstra算法时间: " << duration << " μs" << endl;
+    } else if (algorithm == 2) { // 收缩层次
+        prepareCH();
+        start = chrono::high_resolution_clock::now();
+        path = ch.query(src, dest).first;
+        end = chrono::high_resolution_clock::now();
+        auto duration = chrono::duration_cast<chrono::microseconds>(end - start).count();
+        distance = calculateDistance(path);
+        cout << "收缩层次查询时间: " << duration << " μs" << endl;
     } else { // Floyd
         start = chrono::high_resolution_clock::now();
         path = floydWarshall(src, dest);
@@ -240,6 +403,39 @@ void Graph::compareAlgorithms(int src, int dest) {
     auto floydTime = chrono::duration_cast<chrono::microseconds>(end - start).count();
     double floydDist = calculateDistance(floydPath);
     
+    // 收缩层次（预处理不计入查询时间）
+    prepareCH();
+    start = chrono::high_resolution_clock::now();
+    auto chPath = ch.query(src, dest).first;
+    end = chrono::high_resolution_clock::now();
+    auto chTime = chrono::duration_cast<chrono::microseconds>(end - start).count();
+    double chDist = calculateDistance(chPath);
+    
+    // Floyd 全源预处理：原来的三重循环 vs 分块多线程版本
+    vector<vector<double>> refDist;
+    vector<vector<int>> refNext;
+    start = chrono::high_resolution_clock::now();
+    computeFloydReference(refDist, refNext);
+    end = chrono::high_resolution_clock::now();
+    auto floydRefTime = chrono::duration_cast<chrono::microseconds>(end - start).count();
+    
+    floydComputed = false;
+    start = chrono::high_resolution_clock::now();
+    computeFloyd();
+    end = chrono::high_resolution_clock::now();
+    auto floydBlockTime = chrono::duration_cast<chrono::microseconds>(end - start).count();
+    
+    int n = cities.size();
+    bool floydSame = true;
+    for (int i = 0; i < n && floydSame; i++) {
+        for (int j = 0; j < n; j++) {
+            if (abs(refDist[i][j] - floydMatrix[(size_t)i * n + j]) > 1e-6) {
+                floydSame = false;
+                break;
+            }
+        }
+    }
+    
     cout << "Dijkstra算法:\n";
     cout << "  路径: ";
     printPath(dijkstraPath);
@@ -252,11 +448,22 @@ void Graph::compareAlgorithms(int src, int dest) {
     cout << "  距离: " << floydDist << " km\n";
     cout << "  时间: " << floydTime << " μs\n\n";
     
+    cout << "收缩层次:\n";
+    cout << "  路径: ";
+    printPath(chPath);
+    cout << "  距离: " << chDist << " km\n";
+    cout << "  时间: " << chTime << " μs\n\n";
+    
+    cout << "Floyd预处理（" << n << "个城市，" << floydThreads(n) << "个线程）:\n";
+    cout << "  三重循环: " << floydRefTime << " μs\n";
+    cout << "  分块并行: " << floydBlockTime << " μs\n";
+    cout << (floydSame ? "  ✓ 距离矩阵一致\n\n" : "  ✗ 距离矩阵不一致\n\n");
+    
     cout << "比较结果:\n";
-    if (abs(dijkstraDist - floydDist) < 0.01) {
-        cout << "✓ 两种算法距离一致\n";
+    if (abs(dijkstraDist - floydDist) < 0.01 && abs(dijkstraDist - chDist) < 0.01) {
+        cout << "✓ 三种算法距离一致\n";
     } else {
-        cout << "✗ 两种算法距离不一致\n";
+        cout << "✗ 算法距离不一致\n";
     }
     
     if (dijkstraTime < floydTime) {
@@ -318,53 +525,16 @@ bool Graph::verifyWuhanCenter() {
     return true;
 }
 
-void Graph::dfsFindPaths(int current, int dest, int maxDepth,
-                        vector<bool>& visited,
-                        vector<int>& currentPath,
-                        vector<Path>& allPaths,
-                        double currentDist) {
-    if (currentPath.size() > maxDepth) return;
-    
-    if (current == dest) {
-        Path path;
-        path.nodes = currentPath;
-        path.totalDistance = currentDist;
-        path.nodeCount = currentPath.size();
-        allPaths.push_back(path);
-        return;
-    }
-    
-    for (const auto& [next, weight] : cities[current].neighbors) {
-        if (!visited[next]) {
-            visited[next] = true;
-            currentPath.push_back(next);
-            
-            dfsFindPaths(next, dest, maxDepth, visited, 
-                        currentPath, allPaths, currentDist + weight);
-            
-            currentPath.pop_back();
-            visited[next] = false;
-        }
-    }
+PathEnumerator Graph::enumeratePaths(int src, int dest, int maxNodes, double maxDistance) {
+    return PathEnumerator(cities, src, dest, maxNodes, maxDistance, distancesTo(dest));
 }
 
-vector<Path> Graph::getAllPaths(int src, int dest, int maxNodes) {
+vector<Path> Graph::getAllPaths(int src, int dest, int maxNodes, int limit) {
     vector<Path> allPaths;
     if (src == dest || src < 0 || dest < 0) return allPaths;
     
-    vector<bool> visited(cities.size(), false);
-    vector<int> currentPath;
-    currentPath.push_back(src);
-    visited[src] = true;
-    
-    dfsFindPaths(src, dest, maxNodes, visited, currentPath, allPaths, 0);
-    
-    // 快速排序
-    if (!allPaths.empty()) {
-        quickSort(allPaths, 0, allPaths.size() - 1);
-    }
-    
-    return allPaths;
+    // 按距离从短到长产出，取够 limit 条就停，不用先枚举全部再排序
+    return enumeratePaths(src, dest, maxNodes).take(limit);
 }
 
 void Graph::quickSort(vector<Path>& paths, int left, int right) {
@@ -433,12 +603,108 @@ vector<int> Graph::bypassCity(int src, int dest, const string& bypassCity) {
     return path;
 }
 
+// 反向 Dijkstra：所有城市到 dest 的最短距离，到不了为 INF
+vector<double> Graph::distancesTo(int dest) {
+    int n = cities.size();
+    vector<vector<pair<int, double>>> reverseAdj(n);
+    for (int u = 0; u < n; u++) {
+        for (const auto& [v, w] : cities[u].neighbors) {
+            reverseAdj[v].push_back({u, w});
+        }
+    }
+    
+    vector<double> dist(n, INF);
+    using Pair = pair<double, int>;
+    priority_queue<Pair, vector<Pair>, greater<Pair>> pq;
+    dist[dest] = 0;
+    pq.push({0, dest});
+    while (!pq.empty()) {
+        auto [d, v] = pq.top();
+        pq.pop();
+        if (d > dist[v]) continue;
+        for (const auto& [u, w] : reverseAdj[v]) {
+            if (d + w < dist[u]) {
+                dist[u] = d + w;
+                pq.push({dist[u], u});
+            }
+        }
+    }
+    return dist;
+}
+
+// 带禁用点、禁用边的 src -> dest 最短路（A*）
+// toDest 是不禁用任何东西时到 dest 的精确距离，禁用只会让距离变长，所以它是一致的下界，
+// 搜索几乎直奔终点，只在被禁用的地方绕一下
+vector<int> Graph::searchAvoiding(int src, int dest, const vector<double>& toDest,
+                                  const vector<char>& bannedNode,
+                                  const vector<pair<int, int>>& bannedEdges) {
+    int n = cities.size();
+    if (searchDist.size() != (size_t)n) {
+        searchDist.assign(n, INF);
+        searchPrev.assign(n, -1);
+        searchTouched.clear();
+    }
+    for (int v : searchTouched) {
+        searchDist[v] = INF;
+        searchPrev[v] = -1;
+    }
+    searchTouched.clear();
+    if (toDest[src] >= INF) return {};
+    
+    // 禁用边按起点排好，弹出 u 时二分出 u 的那一段，松弛时只看这一段
+    vector<pair<int, int>> banned(bannedEdges);
+    sort(banned.begin(), banned.end());
+    
+    using Pair = pair<double, int>;
+    priority_queue<Pair, vector<Pair>, greater<Pair>> pq;
+    searchDist[src] = 0;
+    searchTouched.push_back(src);
+    pq.push({toDest[src], src});
+    
+    while (!pq.empty()) {
+        auto [f, u] = pq.top();
+        pq.pop();
+        if (f > searchDist[u] + toDest[u]) continue;
+        if (u == dest) break;
+        
+        auto lo = lower_bound(banned.begin(), banned.end(), make_pair(u, INT_MIN));
+        auto hi = lower_bound(lo, banned.end(), make_pair(u + 1, INT_MIN));
+        for (const auto& [v, w] : cities[u].neighbors) {
+            if (bannedNode[v] || toDest[v] >= INF) continue;
+            if (lo != hi && binary_search(lo, hi, make_pair(u, v))) continue;
+            double nd = searchDist[u] + w;
+            if (nd < searchDist[v]) {
+                if (searchDist[v] >= INF) searchTouched.push_back(v);
+                searchDist[v] = nd;
+                searchPrev[v] = u;
+                pq.push({nd + toDest[v], v});
+            }
+        }
+    }
+    
+    vector<int> path;
+    if (searchDist[dest] >= INF) return path;
+    for (int at = dest; at != -1; at = searchPrev[at]) {
+        path.push_back(at);
+    }
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+// Yen 算法：第 k 条最短的无环路径是在前 k-1 条的某个偏离点（spur）处岔开的。
+// 对上一条路径的每个偏离点：根路径上的点禁用（保证无环），
+// 已找到的、根路径相同的路径在偏离点的下一条边禁用（保证不重复），
+// 从偏离点求一条最短路接在根路径后面作为候选；每轮取候选里最短的一条
 vector<Path> Graph::getKShortestPaths(int src, int dest, int k) {
     vector<Path> result;
     if (src == dest || src < 0 || dest < 0 || k <= 0) return result;
     
-    // 获取最短路径
-    auto firstPath = dijkstra(src, dest);
+    int n = cities.size();
+    vector<double> toDest = distancesTo(dest);
+    vector<char> bannedNode(n, 0);
+    vector<pair<int, int>> bannedEdges;
+    
+    auto firstPath = searchAvoiding(src, dest, toDest, bannedNode, bannedEdges);
     if (firstPath.empty()) return result;
     
     Path first;
@@ -447,14 +713,58 @@ vector<Path> Graph::getKShortestPaths(int src, int dest, int k) {
     first.nodeCount = firstPath.size();
     result.push_back(first);
     
-    // 简化的K短路径：获取所有路径然后取前K条
-    if (k > 1) {
-        auto allPaths = getAllPaths(src, dest, 10);
-        if (allPaths.size() > 1) {
-            for (size_t i = 1; i < allPaths.size() && result.size() < k; i++) {
-                result.push_back(allPaths[i]);
+    // 候选按距离排序，距离相同按路径本身，set 顺便去重
+    set<pair<double, vector<int>>> candidates;
+    
+    while ((int)result.size() < k) {
+        const vector<int>& last = result.back().nodes;
+        double rootDist = 0;
+        
+        for (size_t i = 0; i + 1 < last.size(); i++) {
+            int spur = last[i];
+            
+            bannedEdges.clear();
+            for (const auto& p : result) {
+                if (p.nodes.size() > i + 1 && equal(last.begin(), last.begin() + i + 1, p.nodes.begin())) {
+                    bannedEdges.push_back({spur, p.nodes[i + 1]});
+                }
+            }
+            
+            auto spurPath = searchAvoiding(spur, dest, toDest, bannedNode, bannedEdges);
+            if (!spurPath.empty()) {
+                vector<int> nodes(last.begin(), last.begin() + i);
+                nodes.insert(nodes.end(), spurPath.begin(), spurPath.end());
+                candidates.insert({rootDist + calculateDistance(spurPath), nodes});
+            }
+            
+            bannedNode[spur] = 1;
+            rootDist += adjMatrix[spur][last[i + 1]];
+        }
+        for (size_t i = 0; i + 1 < last.size(); i++) {
+            bannedNode[last[i]] = 0;
+        }
+        
+        // 已经取过的路径可能又被别的偏离点生成出来，跳过
+        bool found = false;
+        while (!candidates.empty() && !found) {
+            auto best = *candidates.begin();
+            candidates.erase(candidates.begin());
+            found = true;
+            for (const auto& p : result) {
+                if (p.nodes == best.second) {
+                    found = false;
+                    break;
+                }
+            }
+            if (found) {
+                Path path;
+                path.nodes = best.second;
+                path.totalDistance = best.first;
+                path.nodeCount = best.second.size();
+                result.push_back(path);
             }
         }
+        if (!found) break;
     }
     
     return result;
@@ -2,6 +2,8 @@
 #define GRAPH_H
 
 #include "City.h"
+#include "ContractionHierarchy.h"
+#include "PathEnumerator.h"
 #include <vector>
 #include <string>
 #include <map>
@@ -12,20 +14,30 @@ class Graph {
 private:
     vector<City> cities;
     vector<vector<double>> adjMatrix;
-    vector<vector<int>> next;
+    vector<double> floydMatrix; // Floyd 结果，扁平 n*n：floydMatrix[i*n+j]
+    vector<int> next;           // 扁平 n*n：next[i*n+j] 为 i 到 j 最短路上的下一个城市，-1 表示不可达
     map<string, int> cityIndexMap;
     const double INF = 1e9;
     bool floydComputed;
+    // searchAvoiding 的工作区，只重置访问过的点
+    vector<double> searchDist;
+    vector<int> searchPrev;
+    vector<int> searchTouched;
+    ContractionHierarchy ch;
+    string chCacheFile;
     
     // 私有算法
     vector<int> dijkstra(int src, int dest);
+    vector<double> distancesTo(int dest);
+    vector<int> searchAvoiding(int src, int dest, const vector<double>& toDest,
+                               const vector<char>& bannedNode,
+                               const vector<pair<int, int>>& bannedEdges);
     vector<int> floydWarshall(int src, int dest);
     void computeFloyd();
-    void dfsFindPaths(int current, int dest, int maxDepth,
-                     vector<bool>& visited,
-                     vector<int>& currentPath,
-                     vector<Path>& allPaths,
-                     double currentDist);
+    void floydBlock(int n, int ib, int jb, int kb);
+    void computeFloydReference(vector<vector<double>>& dist, vector<vector<int>>& nxt) const;
+    void prepareCH();
+    vector<vector<pair<int, double>>> adjacencyList() const;
     void quickSort(vector<Path>& paths, int left, int right);
     
 public:
@@ -35,7 +47,10 @@ public:
     // 核心功能
     bool verifyWuhanCenter();
     pair<vector<int>, double> getShortestPath(int src, int dest, int algorithm);
-    vector<Path> getAllPaths(int src, int dest, int maxNodes);
+    // 最多 maxNodes 个城市的路径，按距离升序；limit > 0 时只取最短的 limit 条
+    vector<Path> getAllPaths(int src, int dest, int maxNodes, int limit = 0);
+    // 逐条取路径的迭代器，调用方决定取多少，不会一次把所有路径放进内存
+    PathEnumerator enumeratePaths(int src, int dest, int maxNodes, double maxDistance = 1e9);
     vector<int> bypassCity(int src, int dest, const string& bypassCity);
     vector<Path> getKShortestPaths(int src, int dest, int k);
     vector<Path> getAllPathsSimple(int src, int dest, int maxNodes);
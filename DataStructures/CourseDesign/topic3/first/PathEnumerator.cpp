@@ -0,0 +1,89 @@
+#include "PathEnumerator.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+const double UNREACHABLE = 1e9;
+}
+
+PathEnumerator::PathEnumerator(const vector<City>& cities, int src, int dest, int maxNodes,
+                               double maxDistance, vector<double> toDest)
+    : cities(cities), dest(dest), maxNodes(maxNodes), maxDistance(maxDistance),
+      toDest(move(toDest)), expanded(0) {
+    int n = cities.size();
+
+    // 反向 BFS 求到终点的最少边数，用来按城市数剪枝
+    vector<vector<int>> reverseAdj(n);
+    for (int u = 0; u < n; u++) {
+        for (const auto& [v, w] : cities[u].neighbors) {
+            reverseAdj[v].push_back(u);
+        }
+    }
+    hopsTo.assign(n, n);
+    queue<int> q;
+    hopsTo[dest] = 0;
+    q.push(dest);
+    while (!q.empty()) {
+        int v = q.front();
+        q.pop();
+        for (int u : reverseAdj[v]) {
+            if (hopsTo[u] == n) {
+                hopsTo[u] = hopsTo[v] + 1;
+                q.push(u);
+            }
+        }
+    }
+
+    if (src >= 0 && src < n && src != dest && this->toDest[src] < UNREACHABLE
+        && 1 + hopsTo[src] <= maxNodes && this->toDest[src] <= maxDistance) {
+        tree.push_back({src, -1, 1, 0});
+        open.push({this->toDest[src], 0});
+    }
+}
+
+bool PathEnumerator::onPath(int node, int city) const {
+    for (; node != -1; node = tree[node].parent) {
+        if (tree[node].city == city) return true;
+    }
+    return false;
+}
+
+bool PathEnumerator::next(Path& path) {
+    while (!open.empty()) {
+        int idx = open.top().second;
+        open.pop();
+        // 拷一份，下面 push_back 可能让 tree 重新分配
+        Node cur = tree[idx];
+
+        if (cur.city == dest) {
+            path.nodes.resize(cur.depth);
+            for (int i = idx, pos = cur.depth - 1; i != -1; i = tree[i].parent, pos--) {
+                path.nodes[pos] = tree[i].city;
+            }
+            path.totalDistance = cur.dist;
+            path.nodeCount = cur.depth;
+            return true;
+        }
+
+        expanded++;
+        for (const auto& [v, w] : cities[cur.city].neighbors) {
+            double bound = cur.dist + w + toDest[v];
+            if (toDest[v] >= UNREACHABLE || bound > maxDistance) continue;
+            if (cur.depth + 1 + hopsTo[v] > maxNodes) continue;
+            if (onPath(idx, v)) continue;
+            tree.push_back({v, idx, cur.depth + 1, cur.dist + w});
+            open.push({bound, (int)tree.size() - 1});
+        }
+    }
+    return false;
+}
+
+vector<Path> PathEnumerator::take(int count) {
+    vector<Path> paths;
+    Path path;
+    while ((count <= 0 || (int)paths.size() < count) && next(path)) {
+        paths.push_back(path);
+    }
+    return paths;
+}
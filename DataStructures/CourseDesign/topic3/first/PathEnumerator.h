@@ -0,0 +1,50 @@
+#ifndef PATHENUMERATOR_H
+#define PATHENUMERATOR_H
+
+#include "City.h"
+#include <vector>
+#include <queue>
+#include <utility>
+using namespace std;
+
+// 按距离从短到长逐条产出 src 到 dest 的简单路径（最多 maxNodes 个城市、总长不超过 maxDistance）
+// 最优优先：部分路径按 "已走距离 + 到终点的下界" 排队，终点的下界是 0，
+// 所以弹出的完整路径一定不比队里剩下的任何延伸更长，取一条算一条，不用先把所有路径找出来再排序。
+// 下界到不了终点、距离或城市数肯定超限的分支直接剪掉。
+// 部分路径存成父指针树，扩展一步只多一个节点，不复制整条路径。
+// 持有 cities 的引用，使用期间图不能被修改。
+class PathEnumerator {
+public:
+    // toDest：各城市到 dest 的最短距离（不可达为 >= 1e9）
+    PathEnumerator(const vector<City>& cities, int src, int dest, int maxNodes,
+                   double maxDistance, vector<double> toDest);
+
+    // 取下一条路径，没有了返回 false
+    bool next(Path& path);
+    // 最多取 count 条（count <= 0 表示取完）
+    vector<Path> take(int count);
+    // 已经展开过的部分路径数，衡量剪枝效果
+    size_t expandedCount() const { return expanded; }
+
+private:
+    struct Node {
+        int city;
+        int parent;     // 树里父节点的下标，起点为 -1
+        int depth;      // 路径上的城市数
+        double dist;
+    };
+
+    const vector<City>& cities;
+    int dest;
+    int maxNodes;
+    double maxDistance;
+    vector<double> toDest;
+    vector<int> hopsTo;     // 到终点至少还要走几条边
+    vector<Node> tree;
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> open;
+    size_t expanded;
+
+    bool onPath(int node, int city) const;
+};
+
+#endif
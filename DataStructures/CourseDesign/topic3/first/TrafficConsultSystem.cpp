@@ -25,7 +25,7 @@ void TrafficConsultSystem::initialize() {
 void TrafficConsultSystem::showMenu() {
     cout << "\n=== 主菜单 ===\n";
     cout << "1. 验证武汉中心位置\n";
-    cout << "2. 查询最短路径（两种算法）\n";
+    cout << "2. 查询最短路径（三种算法）\n";
     cout << "3. 绕过城市的最短路径\n";
     cout << "4. 第K短路径\n";
     cout << "0. 退出\n";
@@ -36,13 +36,14 @@ int TrafficConsultSystem::getAlgorithmChoice() {
     cout << "\n请选择算法：\n";
     cout << "0. Dijkstra算法（适合单次查询）\n";
     cout << "1. Floyd算法（适合多次查询）\n";
-    cout << "2. 两种算法都使用并比较\n";
+    cout << "2. 收缩层次（预处理一次，查询最快）\n";
+    cout << "3. 三种算法都使用并比较\n";
     
     int choice;
     while (true) {
-        cout << "选择 [0-2]: ";
+        cout << "选择 [0-3]: ";
         cin >> choice;
-        if (cin.fail() || choice < 0 || choice > 2) {
+        if (cin.fail() || choice < 0 || choice > 3) {
             cin.clear();
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
             cout << "输入无效，请重试\n";
@@ -126,7 +127,7 @@ void TrafficConsultSystem::handleFunction1() {
 
 void TrafficConsultSystem::handleFunction2() {
     cout << "\n=== 功能2：最短路径查询 ===\n";
-    cout << "支持Dijkstra和Floyd两种算法\n";
+    cout << "支持Dijkstra、Floyd和收缩层次三种算法\n";
     
     string src = getCityInput("起点城市");
     string dest = getCityInput("终点城市");
@@ -149,7 +150,7 @@ void TrafficConsultSystem::handleFunction2() {
     cout << "\n从 " << src << " 到 " << dest << endl;
     cout << "================================\n";
     
-    if (algorithmChoice == 0 || algorithmChoice == 1) {
+    if (algorithmChoice <= 2) {
         auto [path, dist] = graph.getShortestPath(srcIdx, destIdx, algorithmChoice);
         
         if (path.empty()) {
@@ -162,16 +163,17 @@ void TrafficConsultSystem::handleFunction2() {
         graph.printPath(path);
         cout << "总距离: " << fixed << setprecision(2) << dist << " km\n";
         
-    } else if (algorithmChoice == 2) {
+    } else {
         graph.compareAlgorithms(srcIdx, destIdx);
     }
     
-    // 查询可行路径（最多10个节点）
+    // 查询可行路径（最多10个节点）：完全图上这样的路径数以亿计，只按距离取最短的若干条
+    const int MAX_LISTED = 100;
     cout << "\n================================\n";
-    cout << "查找可行路径（最多10个节点）...\n";
+    cout << "查找可行路径（最多10个节点，取最短的" << MAX_LISTED << "条）...\n";
     
     auto start = chrono::high_resolution_clock::now();
-    auto allPaths = graph.getAllPaths(srcIdx, destIdx, 10);
+    auto allPaths = graph.getAllPaths(srcIdx, destIdx, 10, MAX_LISTED);
     auto end = chrono::high_resolution_clock::now();
     auto duration = chrono::duration_cast<chrono::milliseconds>(end - start);
     
@@ -0,0 +1,160 @@
+#include "CSRGraph.h"
+#include "Graph.h"
+
+CSRGraph CSRGraph::fromEdges(int n,const vector<array<int,3>>& edges){
+    CSRGraph g;
+    g.n=n;
+    g.offset.assign(n+1,0);
+    for(auto &e: edges) g.offset[e[0]+1]++;//先数每个点的出度
+    for(int i=0;i<n;i++) g.offset[i+1]+=g.offset[i];//前缀和就是每段的起点
+    g.to.resize(edges.size());
+    g.w.resize(edges.size());
+    vector<int> pos(g.offset.begin(),g.offset.end()-1);
+    for(auto &e: edges){
+        int p=pos[e[0]]++;
+        g.to[p]=e[1];
+        g.w[p]=e[2];
+    }
+    return g;
+}
+
+CSRGraph CSRGraph::fromGraph(const Graph& gr,bool onlyRoads){
+    vector<array<int,3>> edges;
+    for(int u=0;u<gr.n;u++){
+        if(onlyRoads){
+            for(int v: gr.adj[u]) edges.push_back({u,v,gr.dist[u][v]});
+        }else{
+            for(int v=0;v<gr.n;v++)
+                if(v!=u && gr.dist[u][v]<INT_MAX/2) edges.push_back({u,v,gr.dist[u][v]});
+        }
+    }
+    return fromEdges(gr.n,edges);
+}
+
+pair<unsigned,int> RadixHeap::pop(){
+    if(buckets[0].empty()){
+        //找到第一个非空桶,以其中的最小键为新的 last 重新分桶,这些元素都会落到更低的桶里
+        int i=1;
+        while(buckets[i].empty()) i++;
+        last=min_element(buckets[i].begin(),buckets[i].end())->first;
+        for(auto &x: buckets[i]) buckets[bucketOf(x.first)].push_back(x);
+        buckets[i].clear();
+    }
+    auto x=buckets[0].back();
+    buckets[0].pop_back();
+    sz--;
+    return x;
+}
+
+vector<int> dijkstraCSR(const CSRGraph& g,int start,vector<int>& prev,int skip,HeapKind heap,int target){
+    const int INF=INT_MAX/2;
+    vector<int> dis(g.n,INF);
+    prev.assign(g.n,-1);
+    dis[start]=0;
+    if(start==skip) return dis;//起点就是禁行城市:哪里都去不了
+    //两种堆都用"懒删除":距离变小就再压一份,弹出时发现比当前距离大就是过期的
+    auto relax=[&](int u,auto&& push){
+        for(int e=g.offset[u];e<g.offset[u+1];e++){
+            int v=g.to[e];
+            if(v==skip) continue;
+            int nd=dis[u]+g.w[e];
+            if(nd<dis[v]){
+                dis[v]=nd;
+                prev[v]=u;
+                push(nd,v);
+            }
+        }
+    };
+    if(heap==HeapKind::Radix){
+        RadixHeap pq;
+        pq.push(0,start);
+        while(!pq.empty()){
+            auto [d,u]=pq.pop();
+            if((int)d>dis[u]) continue;
+            if(u==target) break;
+            relax(u,[&](int nd,int v){ pq.push(nd,v); });
+        }
+    }else{
+        priority_queue<pair<int,int>,vector<pair<int,int>>,greater<>> pq;
+        pq.push({0,start});
+        while(!pq.empty()){
+            auto [d,u]=pq.top();
+            pq.pop();
+            if(d>dis[u]) continue;
+            if(u==target) break;
+            relax(u,[&](int nd,int v){ pq.push({nd,v}); });
+        }
+    }
+    return dis;
+}
+
+int astarCSR(const CSRGraph& g,int start,int target,vector<int>& prev,const function<int(int)>& h,int skip,int* settled){
+    const int INF=INT_MAX/2;
+    vector<int> dis(g.n,INF);
+    vector<char> closed(g.n,0);
+    prev.assign(g.n,-1);
+    if(settled) *settled=0;
+    if(start==skip || target==skip) return INF;
+    dis[start]=0;
+    priority_queue<pair<int,int>,vector<pair<int,int>>,greater<>> pq;//(f = g + h, 节点)
+    pq.push({h(start),start});
+    while(!pq.empty()){
+        int u=pq.top().second;
+        pq.pop();
+        if(closed[u]) continue;
+        closed[u]=1;//启发是一致的(满足三角不等式),第一次弹出时距离就确定了
+        if(settled) (*settled)++;
+        if(u==target) return dis[u];
+        for(int e=g.offset[u];e<g.offset[u+1];e++){
+            int v=g.to[e];
+            if(v==skip || closed[v]) continue;
+            int nd=dis[u]+g.w[e];
+            if(nd<dis[v]){
+                dis[v]=nd;
+                prev[v]=u;
+                pq.push({nd+h(v),v});
+            }
+        }
+    }
+    return INF;
+}
+
+function<int(int)> euclidHeuristic(const CSRGraph& g,int target){
+    auto t=g.coords[target];
+    const auto* c=&g.coords;
+    //向下取整,保证不超过真实的(整数)边权之和
+    return [c,t](int v){ return (int)floor(hypot((*c)[v].first-t.first,(*c)[v].second-t.second)); };
+}
+
+function<int(int)> landmarkHeuristic(const Landmarks& lm,int target){
+    const Landmarks* p=&lm;
+    return [p,target](int v){ return p->estimate(v,target); };
+}
+
+void Landmarks::build(const CSRGraph& g,int k,int first){
+    ids.clear();
+    dist.clear();
+    vector<int> prev;
+    vector<int> nearest(g.n,INT_MAX/2);//每个点到已选地标的最近距离
+    int next=first;
+    for(int i=0;i<k && i<g.n;i++){
+        ids.push_back(next);
+        dist.push_back(dijkstraCSR(g,next,prev,-1,HeapKind::Radix));
+        int best=-1;
+        for(int v=0;v<g.n;v++){
+            nearest[v]=min(nearest[v],dist.back()[v]);
+            //到不了的点不选,否则下界全是 0
+            if(nearest[v]<INT_MAX/2 && (best==-1 || nearest[v]>nearest[best])) best=v;
+        }
+        if(best==-1 || nearest[best]==0) break;
+        next=best;
+    }
+}
+
+vector<int> buildPath(const vector<int>& prev,int start,int target){
+    vector<int> path;
+    for(int v=target;v!=-1;v=prev[v]) path.push_back(v);
+    reverse(path.begin(),path.end());
+    if(path.empty() || path[0]!=start) return {};
+    return path;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <bits/stdc++.h>
+using namespace std;
+
+class Graph;
+
+//压缩邻接表(CSR):u 的出边是 to/w 中 [offset[u], offset[u+1]) 这一段,
+//所有边放在两个连续数组里,遍历邻居是顺序访存,百万级节点也不用 n×n 矩阵
+class CSRGraph{
+public:
+    int n=0;
+    vector<int> offset;//大小 n+1
+    vector<int> to;
+    vector<int> w;
+    vector<pair<double,double>> coords;//可选:节点的平面坐标(与边权同单位),A* 的直线距离启发用
+
+    CSRGraph(){}
+    //从边表建图,edges 为 (u,v,w) 的有向边
+    static CSRGraph fromEdges(int n,const vector<array<int,3>>& edges);
+    //从 Graph 的距离矩阵建图:onlyRoads 为 true 时只取邻接矩阵里相连的城市,否则取所有有限距离(与矩阵版 Dijkstra 同一张图)
+    static CSRGraph fromGraph(const Graph& g,bool onlyRoads);
+    int edgeCount() const { return to.size(); }
+};
+
+//基数堆(radix heap):键是单调不减的整数(Dijkstra 每次弹出的距离只会变大),
+//按与上次弹出值最高不同位分桶,每个元素最多下移 32 次,插入 O(1),弹出均摊 O(log C)
+class RadixHeap{
+public:
+    RadixHeap(){ clear(); }
+    void clear(){ for(auto &b: buckets) b.clear(); last=0; sz=0; }
+    bool empty() const { return sz==0; }
+    size_t size() const { return sz; }
+    void push(unsigned key,int val){ buckets[bucketOf(key)].push_back({key,val}); sz++; }
+    pair<unsigned,int> pop();//弹出最小键,调用方保证非空
+
+private:
+    int bucketOf(unsigned key) const { return key==last ? 0 : 32-__builtin_clz(key^last); }
+    vector<pair<unsigned,int>> buckets[33];
+    unsigned last;
+    size_t sz;
+};
+
+//ALT 启发:选 k 个地标,预先算好每个地标到所有点的距离,
+//由三角不等式 d(v,t) >= |d(L,t)-d(L,v)| 得到下界(无向图)。封掉节点只会让距离变大,下界仍然成立
+class Landmarks{
+public:
+    vector<int> ids;
+    vector<vector<int>> dist;//dist[i][v]:第 i 个地标到 v 的距离
+    //最远点采样:每次选离已选地标最远的点
+    void build(const CSRGraph& g,int k,int first=0);
+    int estimate(int v,int t) const{
+        int h=0;
+        for(auto &d: dist) if(d[v]<INT_MAX/2 && d[t]<INT_MAX/2) h=max(h,abs(d[t]-d[v]));
+        return h;
+    }
+};
+
+enum class HeapKind{ Binary, Radix };
+
+//单源最短路,skip 为要避开的节点(与矩阵版相同:不经过也不到达它),target 非 -1 时确定了 target 就停。
+//返回的距离数组里到不了的点为 INT_MAX/2,prev 用来回溯路径
+vector<int> dijkstraCSR(const CSRGraph& g,int start,vector<int>& prev,int skip=-1,HeapKind heap=HeapKind::Binary,int target=-1);
+
+//A*:f = g + h,h 必须是不高估的下界。返回 start 到 target 的距离,到不了返回 INT_MAX/2;
+//settled 非空时写入确定过的节点数(衡量启发的效果)
+int astarCSR(const CSRGraph& g,int start,int target,vector<int>& prev,const function<int(int)>& h,int skip=-1,int* settled=nullptr);
+//直线距离启发:要求 g.coords 已填好且边权不小于两端点的直线距离
+function<int(int)> euclidHeuristic(const CSRGraph& g,int target);
+function<int(int)> landmarkHeuristic(const Landmarks& lm,int target);
+
+//用 prev 回溯 start→target 的路径,到不了返回空
+vector<int> buildPath(const vector<int>& prev,int start,int target);
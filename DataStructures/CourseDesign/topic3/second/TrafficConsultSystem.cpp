@@ -4,34 +4,25 @@
 #include <iostream>
 using namespace std;
 
+//距离矩阵转成 CSR:取所有有限距离,和原来逐行扫矩阵的 Dijkstra 是同一张图
+const CSRGraph& TrafficConsultSystem::csrGraph(){
+    if(csr.n!=g.n || csr.offset.empty()){
+        csr=CSRGraph::fromGraph(g,false);
+        landmarks.build(csr,min(4,g.n));
+    }
+    return csr;
+}
+
 //Dijkstra：单源最短路径（可跳过某城市）
+//从 start 出发，计算到所有城市的最短距离,prev[v]：最短路径中 v 的前驱节点,skip：要避开的城市（模拟封城/禁行）
+//原来每轮扫一遍 n 个点找最小值再扫一整行矩阵,O(V^2);现在在 CSR 上用二叉堆,O(E log V)
 vector<int> TrafficConsultSystem::dijkstra(int start, vector<int>& prev, int skip){
-    //从 start 出发，计算到 所有城市的最短距离,prev[v]：最短路径中，v 的前驱节点,skip：要避开的城市（模拟封城/禁行）
-    int n = g.n;
-    vector<int> dis(n, INT_MAX/2);//start → 各点最短距离
-    vector<bool> visited(n,false);//是否已确定最短路
-    prev.assign(n,-1);//路径回溯
-    dis[start]=0;
-    for(int i=0;i<n;i++){
-        //找当前“未访问且距离最小”的点
-        int u=-1;
-        for(int j=0;j<n;j++){
-            if(!visited[j] && (u==-1 || dis[j]<dis[u])) u=j;
-        }
-        //u == skip：这个城市直接跳过（模拟禁行）
-        if(u==-1) break;
-        if(u==skip) continue;
-        visited[u]=true;
-        //更新邻接点距离
-        for(int v=0;v<n;v++){
-            if(v==skip) continue;
-            if(dis[u]+g.dist[u][v]<dis[v]){
-                dis[v]=dis[u]+g.dist[u][v];
-                prev[v]=u;
-            }
-        }
-    }
-    return dis;
+    return dijkstraCSR(csrGraph(),start,prev,skip);
+}
+
+int TrafficConsultSystem::astar(int start, int end, vector<int>& prev, int skip){
+    const CSRGraph& cg=csrGraph();
+    return astarCSR(cg,start,end,prev,landmarkHeuristic(landmarks,end),skip);
 }
 
 //Floyd：多源最短路径（可跳过某城市）
@@ -1,13 +1,22 @@
 #pragma once
 #include "Graph.h"
+#include "CSRGraph.h"
 
 class TrafficConsultSystem{
 public:
     Graph g;
     vector<int> dijkstra(int start, vector<int>& prev, int skip=-1);
+    //A*(ALT 地标启发),只求 start → end 一对,比整张图跑 Dijkstra 确定的点少
+    int astar(int start, int end, vector<int>& prev, int skip=-1);
     vector<vector<int>> floyd(vector<vector<int>>& next, int skip=-1);
     vector<pair<vector<int>,int>> getAllPathsLengths(int start,int end,int skip=-1);
     // 验证：所有省会到武汉是否中转不超过2个
     void verifyWuhanCenter();
 
+private:
+    //g 加载完后第一次查询时才建 CSR 和地标;g.n 变了(重新加载)就重建
+    CSRGraph csr;
+    Landmarks landmarks;
+    const CSRGraph& csrGraph();
+
 };
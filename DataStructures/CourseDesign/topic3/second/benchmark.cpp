@@ -0,0 +1,136 @@
+//最短路性能测试:随机几何图(平面上撒点,每个点连最近的 6 个点,边权 = 直线距离 × [1,1.3)),
+//比较 n×n 矩阵版 Dijkstra、CSR + 二叉堆、CSR + 基数堆,以及 A*(直线距离 / ALT 地标两种启发)
+//编译: g++ -std=c++17 -O2 -o benchmark benchmark.cpp CSRGraph.cpp
+//运行: ./benchmark [最大节点数,默认 1000000]
+#include "CSRGraph.h"
+
+static double nowMs(){
+    return chrono::duration<double,milli>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//平均间距约 1000 个单位;用网格分桶找近邻,不用 O(n^2)
+static CSRGraph randomGeometric(int n,mt19937& rng){
+    const int K=6;
+    double side=sqrt((double)n)*1000;
+    uniform_real_distribution<double> pos(0,side),stretch(1.0,1.3);
+    CSRGraph g;
+    g.coords.resize(n);
+    for(auto &c: g.coords) c={pos(rng),pos(rng)};
+    int cells=max(1,(int)sqrt((double)n/2));
+    double cw=side/cells;
+    vector<vector<int>> grid(cells*cells);
+    auto cellOf=[&](double x){ return min(cells-1,(int)(x/cw)); };
+    for(int i=0;i<n;i++) grid[cellOf(g.coords[i].second)*cells+cellOf(g.coords[i].first)].push_back(i);
+    set<pair<int,int>> seen;
+    vector<array<int,3>> edges;
+    for(int i=0;i<n;i++){
+        auto [x,y]=g.coords[i];
+        int cx=cellOf(x),cy=cellOf(y);
+        vector<pair<double,int>> cand;
+        //逐圈向外扩,直到候选够 K 个且再外一圈不可能更近
+        for(int r=1;;r++){
+            cand.clear();
+            for(int yy=max(0,cy-r);yy<=min(cells-1,cy+r);yy++)
+                for(int xx=max(0,cx-r);xx<=min(cells-1,cx+r);xx++)
+                    for(int j: grid[yy*cells+xx]) if(j!=i)
+                        cand.push_back({hypot(g.coords[j].first-x,g.coords[j].second-y),j});
+            if((int)cand.size()>=K){
+                nth_element(cand.begin(),cand.begin()+K-1,cand.end());
+                if(cand[K-1].first<=r*cw || r>=cells) break;
+            }else if(r>=cells) break;
+        }
+        for(int k=0;k<min(K,(int)cand.size());k++){
+            int j=cand[k].second;
+            if(!seen.insert({min(i,j),max(i,j)}).second) continue;
+            int w=(int)ceil(cand[k].first*stretch(rng));//向上取整,直线距离启发仍是下界
+            edges.push_back({i,j,w});
+            edges.push_back({j,i,w});
+        }
+    }
+    auto coords=move(g.coords);
+    g=CSRGraph::fromEdges(n,edges);
+    g.coords=move(coords);
+    return g;
+}
+
+//原 TrafficConsultSystem::dijkstra 的做法:每轮扫全部点找最小,再扫一整行矩阵
+static vector<int> denseDijkstra(const vector<int>& mat,int n,int start){
+    vector<int> dis(n,INT_MAX/2);
+    vector<bool> visited(n,false);
+    dis[start]=0;
+    for(int i=0;i<n;i++){
+        int u=-1;
+        for(int j=0;j<n;j++) if(!visited[j] && (u==-1 || dis[j]<dis[u])) u=j;
+        if(u==-1) break;
+        visited[u]=true;
+        const int* row=&mat[(size_t)u*n];
+        for(int v=0;v<n;v++) if(dis[u]+row[v]<dis[v]) dis[v]=dis[u]+row[v];
+    }
+    return dis;
+}
+
+int main(int argc,char** argv){
+    int maxN=argc>1 ? atoi(argv[1]) : 1000000;
+    mt19937 rng(12345);
+    for(int n=10000;n<=maxN;n*=10){
+        double t0=nowMs();
+        CSRGraph g=randomGeometric(n,rng);
+        double tBuild=nowMs()-t0;
+        t0=nowMs();
+        Landmarks lm;
+        lm.build(g,8);
+        double tLm=nowMs()-t0;
+        printf("n=%d 边=%d 建图 %.0f ms, 8 个地标 %.0f ms\n",n,g.edgeCount(),tBuild,tLm);
+
+        const int Q=20;
+        uniform_int_distribution<int> pick(0,n-1);
+        vector<pair<int,int>> qs(Q);
+        for(auto &q: qs) q={pick(rng),pick(rng)};
+        vector<int> prev,ref(Q);
+        int bad=0;
+
+        //单源全图
+        t0=nowMs();
+        for(int i=0;i<Q;i++) ref[i]=dijkstraCSR(g,qs[i].first,prev)[qs[i].second];
+        double tBin=(nowMs()-t0)/Q;
+        t0=nowMs();
+        for(int i=0;i<Q;i++) bad+=dijkstraCSR(g,qs[i].first,prev,-1,HeapKind::Radix)[qs[i].second]!=ref[i];
+        double tRad=(nowMs()-t0)/Q;
+        printf("  单源全图   二叉堆 %8.2f ms  基数堆 %8.2f ms\n",tBin,tRad);
+        if(n<=10000){
+            vector<int> mat((size_t)n*n,INT_MAX/2);
+            for(int u=0;u<n;u++){
+                mat[(size_t)u*n+u]=0;
+                for(int e=g.offset[u];e<g.offset[u+1];e++) mat[(size_t)u*n+g.to[e]]=g.w[e];
+            }
+            const int DQ=3;
+            t0=nowMs();
+            for(int i=0;i<DQ;i++) bad+=denseDijkstra(mat,n,qs[i].first)[qs[i].second]!=ref[i];
+            printf("  单源全图   矩阵 O(V^2) %8.2f ms\n",(nowMs()-t0)/DQ);
+        }
+
+        //点到点
+        t0=nowMs();
+        for(int i=0;i<Q;i++) bad+=dijkstraCSR(g,qs[i].first,prev,-1,HeapKind::Binary,qs[i].second)[qs[i].second]!=ref[i];
+        double tP2P=(nowMs()-t0)/Q;
+        long long sE=0,sL=0;
+        int settled;
+        t0=nowMs();
+        for(int i=0;i<Q;i++){
+            bad+=astarCSR(g,qs[i].first,qs[i].second,prev,euclidHeuristic(g,qs[i].second),-1,&settled)!=ref[i];
+            sE+=settled;
+        }
+        double tE=(nowMs()-t0)/Q;
+        t0=nowMs();
+        for(int i=0;i<Q;i++){
+            bad+=astarCSR(g,qs[i].first,qs[i].second,prev,landmarkHeuristic(lm,qs[i].second),-1,&settled)!=ref[i];
+            sL+=settled;
+        }
+        double tL=(nowMs()-t0)/Q;
+        printf("  点到点     Dijkstra(到终点即停) %8.2f ms\n",tP2P);
+        printf("             A* 直线距离 %8.2f ms  平均确定 %lld 个点\n",tE,sE/Q);
+        printf("             A* ALT      %8.2f ms  平均确定 %lld 个点\n",tL,sL/Q);
+        printf("  结果不一致: %d\n",bad);
+    }
+    return 0;
+}
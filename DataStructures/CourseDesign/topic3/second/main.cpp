@@ -37,12 +37,17 @@ int main(){
         int end = tcs.g.cityMap[endCity];
 
         if(choice==1){
-            cout<<"选择算法: 1-Dijkstra 2-Floyd: ";
+            cout<<"选择算法: 1-Dijkstra 2-Floyd 3-A*: ";
             int algo; cin>>algo;
             if(algo==1){
                 vector<int> prev;
                 auto dis = tcs.dijkstra(start,prev);
                 cout<<"Dijkstra 最短距离: "<<dis[end]<<endl;
+            }else if(algo==3){
+                vector<int> prev;
+                int d = tcs.astar(start,end,prev);
+                cout<<"A* 最短距离: "<<d<<endl;
+                printPath(tcs.g.cityNames,buildPath(prev,start,end));
             }else{
                 vector<vector<int>> next;
                 auto d = tcs.floyd(next);
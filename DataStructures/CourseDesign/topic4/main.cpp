@@ -1,8 +1,155 @@
 #include "network/server.h"
 #include "storage/storage.h"
+#include "network/cluster.h"
+#include <cstring>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <random>
 
-int main() {
-    StorageEngine engine;
+/*用法: miniredis [选项]
+  --port 6379                 TCP 端口,0 表示不监听 TCP
+  --bind 0.0.0.0              TCP 监听地址
+  --unixsocket <路径>          同时监听 Unix domain socket(同机部署时延迟更低)
+  --unixsocketperm 700        socket 文件权限(八进制)
+  --tcp-backlog 511           listen 队列长度
+  --tcp-keepalive 300         keepalive 空闲秒数,0 关闭
+  --tcp-nodelay yes|no        是否关闭 Nagle 算法
+  --reuseport <N>             开 SO_REUSEPORT,在同一端口上建 N 个监听 socket
+  --io epoll|uring            网络后端
+  --client-output-buffer-limit <normal|pubsub|replica> <hard> <soft> <秒>
+  --timeout 0                 客户端空闲超过这么多秒就断开,0 表示不限制
+  --databases 16              逻辑库的个数(SELECT 0..N-1),集群模式只用 0 号库
+  --hash-max-listpack-entries 128  字段数不超过它的哈希用 listpack 存
+  --hash-max-listpack-value 64     字段名和值都不超过它(字节)的哈希用 listpack 存
+  --compress-threshold 0           不小于这么多字节的字符串值用 LZ4 压缩存放,0 表示不压缩
+  --hash-function wyhash|siphash   key 的哈希函数;siphash 更慢但能抵抗构造冲突的攻击
+  --key-index yes|no               每个库再维护一棵按字典序排列的基数树,支持 KEYINDEX PREFIX/RANGE;默认 no
+  --cluster-config <文件>           开启集群模式,文件格式见 network/cluster.h
+  --cluster-node-id <id>           本进程是配置文件里的哪个节点;没给 --port 时用该节点的端口
+  --trace-dir .                     TRACE DUMP <文件名> 写到这个目录下
+编译时加 -DMINIREDIS_TRACE 打开热路径追踪(storage/trace.h),运行中用 TRACE DUMP <文件名> 导出 Chrome trace JSON
+本机起三个节点的集群:
+  ./miniredis --cluster-config nodes.conf --cluster-node-id node1
+  ./miniredis --cluster-config nodes.conf --cluster-node-id node2
+  ./miniredis --cluster-config nodes.conf --cluster-node-id node3*/
+int main(int argc, char** argv) {
+    //对端断开后再写会触发 SIGPIPE,默认动作是退出进程;忽略它,让 write 返回 EPIPE 按普通错误处理
+    signal(SIGPIPE, SIG_IGN);
+
+    //每次启动随机生成哈希种子,外部无法预知 key 落在哪个桶
+    std::random_device rd;
+    uint8_t seed[16];
+    for (auto& b : seed) b = rd();
+    dictSetHashSeed(seed);
+
+    //库的个数要在创建引擎之前知道,先单独找一遍
+    int databases = DEFAULT_DBNUM;
+    for (int i = 1; i + 1 < argc; i++)
+        if (!strcmp(argv[i], "--databases")) databases = atoi(argv[i + 1]);
+    if (databases < 1) {
+        std::cerr << "invalid number of databases" << std::endl;
+        return 1;
+    }
+
+    StorageEngine engine(StorageMode::Single, databases);
     Server server(engine);
-    server.start(6379);
+    ListenOptions tcp;
+    std::string unixPath;
+    int unixPerm = 0700;
+    int tcpListeners = 1;
+    size_t hashEntries = 128, hashValue = 64;
+    bool portSet = false;
+    bool keyIndex = false;
+    std::string clusterConfig, clusterNodeId;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--port") && i + 1 < argc) {
+            tcp.port = atoi(argv[++i]);
+            portSet = true;
+        } else if (!strcmp(argv[i], "--bind") && i + 1 < argc) {
+            tcp.bindAddr = argv[++i];
+        } else if (!strcmp(argv[i], "--unixsocket") && i + 1 < argc) {
+            unixPath = argv[++i];
+        } else if (!strcmp(argv[i], "--unixsocketperm") && i + 1 < argc) {
+            unixPerm = strtol(argv[++i], nullptr, 8);
+        } else if (!strcmp(argv[i], "--tcp-backlog") && i + 1 < argc) {
+            tcp.backlog = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--tcp-keepalive") && i + 1 < argc) {
+            tcp.keepAlive = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--tcp-nodelay") && i + 1 < argc) {
+            tcp.tcpNoDelay = !strcmp(argv[++i], "yes");
+        } else if (!strcmp(argv[i], "--reuseport") && i + 1 < argc) {
+            tcp.reusePort = true;
+            tcpListeners = atoi(argv[++i]);
+            if (tcpListeners < 1) tcpListeners = 1;
+        } else if (!strcmp(argv[i], "--io") && i + 1 < argc) {
+            const char* io = argv[++i];
+            if (!strcmp(io, "uring")) server.setIoBackend(IoBackend::Uring);
+            else if (!strcmp(io, "epoll")) server.setIoBackend(IoBackend::Epoll);
+            else { std::cerr << "unknown io backend: " << io << std::endl; return 1; }
+        } else if (!strcmp(argv[i], "--databases") && i + 1 < argc) {
+            i++;    //前面已经处理过
+        } else if (!strcmp(argv[i], "--timeout") && i + 1 < argc) {
+            server.setClientTimeout(atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--client-output-buffer-limit") && i + 4 < argc) {
+            const char* cls = argv[++i];
+            OutputBufferLimit lim;
+            lim.hard = strtoull(argv[++i], nullptr, 10);
+            lim.soft = strtoull(argv[++i], nullptr, 10);
+            lim.softSeconds = atoi(argv[++i]);
+            if (!strcmp(cls, "normal")) server.setOutputBufferLimit(ClientClass::Normal, lim);
+            else if (!strcmp(cls, "pubsub")) server.setOutputBufferLimit(ClientClass::PubSub, lim);
+            else if (!strcmp(cls, "replica")) server.setOutputBufferLimit(ClientClass::Replica, lim);
+            else { std::cerr << "unknown client class: " << cls << std::endl; return 1; }
+        } else if (!strcmp(argv[i], "--hash-max-listpack-entries") && i + 1 < argc) {
+            hashEntries = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--hash-max-listpack-value") && i + 1 < argc) {
+            hashValue = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--key-index") && i + 1 < argc) {
+            keyIndex = !strcmp(argv[++i], "yes");
+        } else if (!strcmp(argv[i], "--compress-threshold") && i + 1 < argc) {
+            engine.setStringCompression(strtoull(argv[++i], nullptr, 10));
+        } else if (!strcmp(argv[i], "--hash-function") && i + 1 < argc) {
+            const char* fn = argv[++i];
+            if (!strcmp(fn, "wyhash")) dictSetHashFunction(DictHashFunction::Wyhash);
+            else if (!strcmp(fn, "siphash")) dictSetHashFunction(DictHashFunction::SipHash);
+            else { std::cerr << "unknown hash function: " << fn << std::endl; return 1; }
+        } else if (!strcmp(argv[i], "--trace-dir") && i + 1 < argc) {
+            server.setTraceDir(argv[++i]);
+        } else if (!strcmp(argv[i], "--cluster-config") && i + 1 < argc) {
+            clusterConfig = argv[++i];
+        } else if (!strcmp(argv[i], "--cluster-node-id") && i + 1 < argc) {
+            clusterNodeId = argv[++i];
+        } else {
+            std::cerr << "unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    engine.setHashListpackLimits(hashEntries, hashValue);
+    if (keyIndex) engine.enableKeyIndex();
+
+    Cluster cluster;
+    if (!clusterConfig.empty()) {
+        if (!cluster.load(clusterConfig, clusterNodeId)) return 1;
+        if (!portSet) tcp.port = cluster.node(cluster.myself()).port;
+        engine.enableSlotIndex();
+        server.setCluster(&cluster);
+    }
+
+    std::vector<ListenOptions> listens;
+    if (tcp.port != 0) listens.assign(tcpListeners, tcp);
+    if (!unixPath.empty()) {
+        ListenOptions u;
+        u.unixPath = unixPath;
+        u.unixPerm = unixPerm;
+        u.backlog = tcp.backlog;
+        listens.push_back(u);
+    }
+    if (listens.empty()) {
+        std::cerr << "nothing to listen on: set --port or --unixsocket" << std::endl;
+        return 1;
+    }
+    if (!server.start(listens)) return 1;
 }
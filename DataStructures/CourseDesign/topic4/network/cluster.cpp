@@ -0,0 +1,58 @@
+#include "cluster.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+
+bool Cluster::load(const std::string& path, const std::string& myId) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "cannot open cluster config " << path << std::endl;
+        return false;
+    }
+    for (int i = 0; i < CLUSTER_SLOTS; i++) owner[i] = migrating[i] = importing[i] = -1;
+    nodes.clear();
+    std::string line;
+    int lineno = 0;
+    while (std::getline(in, line)) {
+        lineno++;
+        std::istringstream ss(line);
+        ClusterNode n;
+        if (!(ss >> n.id) || n.id[0] == '#') continue;
+        if (!(ss >> n.host >> n.port) || findNode(n.id) >= 0) {
+            std::cerr << path << ":" << lineno << ": bad node line" << std::endl;
+            return false;
+        }
+        nodes.push_back(n);
+        std::string range;
+        while (ss >> range) {
+            size_t dash = range.find('-');
+            int lo = atoi(range.c_str());
+            int hi = dash == std::string::npos ? lo : atoi(range.c_str() + dash + 1);
+            if (lo < 0 || hi >= CLUSTER_SLOTS || lo > hi) {
+                std::cerr << path << ":" << lineno << ": bad slot range " << range << std::endl;
+                return false;
+            }
+            for (int s = lo; s <= hi; s++) owner[s] = nodes.size() - 1;
+        }
+    }
+    self = findNode(myId);
+    if (self < 0) {
+        std::cerr << "node id " << myId << " not found in " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int Cluster::findNode(const std::string& id) const {
+    for (size_t i = 0; i < nodes.size(); i++)
+        if (nodes[i].id == id) return i;
+    return -1;
+}
+
+//槽正式归属新节点:导入完成,迁出方的迁移状态也随之结束
+void Cluster::setSlotNode(int slot, int node) {
+    owner[slot] = node;
+    if (node == self) importing[slot] = -1;
+    else migrating[slot] = -1;
+}
@@ -0,0 +1,47 @@
+/*集群视图:16384 个哈希槽分别由哪个节点负责。
+没有节点间的 gossip:所有进程读同一个配置文件,迁移槽时由管理员在相关节点上执行 CLUSTER SETSLOT。
+配置文件每行一个节点(# 开头是注释):
+    <节点 id> <host> <port> [槽或槽范围 ...]
+例如:
+    node1 127.0.0.1 7001 0-5460
+    node2 127.0.0.1 7002 5461-10922
+    node3 127.0.0.1 7003 10923-16383*/
+#pragma once
+#include <string>
+#include <vector>
+#include "../storage/slot.h"
+
+struct ClusterNode {
+    std::string id;
+    std::string host;
+    int port;
+};
+
+class Cluster {
+public:
+    //读取配置并确定自己是哪个节点,失败时打印原因并返回 false
+    bool load(const std::string& path, const std::string& myId);
+
+    int myself() const { return self; }
+    const ClusterNode& node(int idx) const { return nodes[idx]; }
+    const std::vector<ClusterNode>& allNodes() const { return nodes; }
+    int findNode(const std::string& id) const;   //没有返回 -1
+
+    //下面返回节点下标,-1 表示没有
+    int slotOwner(int slot) const { return owner[slot]; }
+    int migratingTo(int slot) const { return migrating[slot]; }
+    int importingFrom(int slot) const { return importing[slot]; }
+
+    // CLUSTER SETSLOT 的四种子命令
+    void setSlotNode(int slot, int node);
+    void setMigrating(int slot, int node) { migrating[slot] = node; }
+    void setImporting(int slot, int node) { importing[slot] = node; }
+    void setStable(int slot) { migrating[slot] = importing[slot] = -1; }
+
+private:
+    std::vector<ClusterNode> nodes;
+    int self = -1;
+    int owner[CLUSTER_SLOTS];
+    int migrating[CLUSTER_SLOTS];
+    int importing[CLUSTER_SLOTS];
+};
@@ -0,0 +1,61 @@
+#include "glob.h"
+
+//* 用回溯:记住最近一个 * 的位置,后面匹配失败就让它多吞一个字符再试,最坏 O(plen * slen)
+bool globMatch(const char* p, size_t plen, const char* s, size_t slen) {
+    size_t pi = 0, si = 0;
+    size_t starP = (size_t)-1, starS = 0;
+    while (si < slen) {
+        if (pi < plen) {
+            char c = p[pi];
+            if (c == '*') {
+                while (pi < plen && p[pi] == '*') pi++;
+                if (pi == plen) return true;
+                starP = pi;
+                starS = si;
+                continue;
+            }
+            if (c == '?') {
+                pi++;
+                si++;
+                continue;
+            }
+            if (c == '[') {
+                size_t i = pi + 1;
+                bool negate = i < plen && p[i] == '^';
+                if (negate) i++;
+                bool match = false;
+                while (i < plen && p[i] != ']') {
+                    if (p[i] == '\\' && i + 1 < plen) {
+                        i++;
+                        match = match || p[i] == s[si];
+                    } else if (i + 2 < plen && p[i + 1] == '-' && p[i + 2] != ']') {
+                        char lo = p[i], hi = p[i + 2];
+                        if (lo > hi) { char t = lo; lo = hi; hi = t; }
+                        match = match || (s[si] >= lo && s[si] <= hi);
+                        i += 2;
+                    } else {
+                        match = match || p[i] == s[si];
+                    }
+                    i++;
+                }
+                if (match != negate) {
+                    pi = i < plen ? i + 1 : i;   //没有闭合的 ] 时把剩下的当字符集
+                    si++;
+                    continue;
+                }
+            } else {
+                if (c == '\\' && pi + 1 < plen) c = p[++pi];
+                if (c == s[si]) {
+                    pi++;
+                    si++;
+                    continue;
+                }
+            }
+        }
+        if (starP == (size_t)-1) return false;
+        pi = starP;
+        si = ++starS;
+    }
+    while (pi < plen && p[pi] == '*') pi++;
+    return pi == plen;
+}
@@ -0,0 +1,5 @@
+//glob 风格匹配(SCAN/KEYS 的 MATCH):* 任意串,? 任意一个字符,[abc] [^a-z] 字符集,\ 转义
+#pragma once
+#include <cstddef>
+
+bool globMatch(const char* pattern, size_t plen, const char* str, size_t slen);
@@ -0,0 +1,299 @@
+/*压测客户端:单线程 epoll 驱动多个连接,每个连接一次发 pipeline 条命令,收齐回复再发下一批。
+比较两种后端(同一台机器上分别启动):
+    ./miniredis --port 6379 --io epoll
+    ./miniredis --port 6380 --io uring
+    ./loadgen --port 6379 --clients 50 --requests 1000000 --pipeline 16
+    ./loadgen --port 6380 --clients 50 --requests 1000000 --pipeline 16
+比较同机部署时 TCP 回环与 Unix socket 的延迟(单连接、不开 pipeline):
+    ./miniredis --port 6379 --unixsocket /tmp/miniredis.sock
+    ./loadgen --port 6379 --clients 1 --requests 200000 --cmd get
+    ./loadgen --unix /tmp/miniredis.sock --clients 1 --requests 200000 --cmd get
+大值吞吐(先 set 再 get 同一批 key):
+    ./loadgen --clients 4 --requests 200 --size 16777216 --keyspace 4 --cmd set
+    ./loadgen --clients 4 --requests 200 --size 16777216 --keyspace 4 --cmd get
+找热点 key(SCAN 遍历 + OBJECT FREQ,不压测):
+    ./loadgen --port 6379 --hotkeys 10
+编译: g++ -std=c++17 -O2 -o loadgen network/loadgen.cpp */
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+struct Conn {
+    int fd;
+    std::string out;         //这一批还没发完的请求
+    size_t outPos = 0;
+    std::string in;          //收到还没解析的回复
+    int waiting = 0;         //这一批还差几条回复
+    Clock::time_point sentAt;
+};
+
+//返回 buf 中第一条完整回复的长度,不完整返回 0
+static size_t replyLength(const char* buf, size_t len) {
+    const char* cr = static_cast<const char*>(memchr(buf, '\r', len));
+    if (!cr || cr + 1 >= buf + len) return 0;
+    size_t header = cr - buf + 2;
+    if (buf[0] != '$') return header;
+    long long n = atoll(buf + 1);
+    if (n < 0) return header;
+    if (len < header + n + 2) return 0;
+    return header + n + 2;
+}
+
+static std::string command(const std::vector<std::string>& args) {
+    std::string s = "*" + std::to_string(args.size()) + "\r\n";
+    for (auto& a : args) s += "$" + std::to_string(a.size()) + "\r\n" + a + "\r\n";
+    return s;
+}
+
+static int connectServer(const std::string& host, int port, const std::string& unixPath) {
+    int fd, rc;
+    if (!unixPath.empty()) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, unixPath.c_str(), sizeof(addr.sun_path) - 1);
+        rc = connect(fd, (sockaddr*)&addr, sizeof(addr));
+    } else {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+        rc = connect(fd, (sockaddr*)&addr, sizeof(addr));
+    }
+    if (rc < 0) {
+        std::cerr << "connect failed: " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+//完整解析一条回复(含嵌套数组),数据不够时返回 false
+struct Reply {
+    char type = 0;
+    std::string str;
+    long long num = 0;
+    std::vector<Reply> elems;
+};
+
+static bool parseReply(const std::string& buf, size_t& pos, Reply& r) {
+    size_t eol = buf.find("\r\n", pos);
+    if (eol == std::string::npos) return false;
+    r.type = buf[pos];
+    std::string line = buf.substr(pos + 1, eol - pos - 1);
+    size_t p = eol + 2;
+    if (r.type == '$') {
+        long long n = atoll(line.c_str());
+        if (n >= 0) {
+            if (buf.size() < p + n + 2) return false;
+            r.str = buf.substr(p, n);
+            p += n + 2;
+        }
+    } else if (r.type == '*') {
+        long long n = atoll(line.c_str());
+        r.elems.clear();
+        for (long long i = 0; i < n; i++) {
+            r.elems.emplace_back();
+            if (!parseReply(buf, p, r.elems.back())) return false;
+        }
+    } else if (r.type == ':') {
+        r.num = atoll(line.c_str());
+    } else {
+        r.str = line;
+    }
+    pos = p;
+    return true;
+}
+
+//发出一批请求,阻塞读回 n 条回复
+static bool roundTrip(int fd, const std::string& req, size_t n, std::vector<Reply>& replies) {
+    for (size_t off = 0; off < req.size(); ) {
+        ssize_t w = write(fd, req.data() + off, req.size() - off);
+        if (w <= 0) return false;
+        off += w;
+    }
+    replies.clear();
+    std::string in;
+    size_t pos = 0;
+    char buf[64 * 1024];
+    while (replies.size() < n) {
+        Reply r;
+        size_t p = pos;
+        if (parseReply(in, p, r)) {
+            replies.push_back(std::move(r));
+            pos = p;
+            continue;
+        }
+        ssize_t got = read(fd, buf, sizeof(buf));
+        if (got <= 0) return false;
+        in.append(buf, got);
+    }
+    return true;
+}
+
+//和 redis-cli --hotkeys 的做法一样:SCAN 遍历全部 key,每批 key 用 pipeline 发 OBJECT FREQ,
+//用小顶堆留下频率最高的 top 个。频率是服务器上的 LFU 对数计数器,不是精确的访问次数
+static int hotkeys(int fd, size_t top) {
+    using Item = std::pair<long long, std::string>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> best;
+    std::vector<Reply> replies;
+    std::string cursor = "0";
+    size_t scanned = 0;
+    do {
+        if (!roundTrip(fd, command({"SCAN", cursor, "COUNT", "1000"}), 1, replies) ||
+            replies[0].type != '*' || replies[0].elems.size() != 2) {
+            std::cerr << "SCAN failed" << std::endl;
+            return 1;
+        }
+        cursor = replies[0].elems[0].str;
+        std::vector<std::string> keys;
+        for (auto& k : replies[0].elems[1].elems) keys.push_back(k.str);
+        if (keys.empty()) continue;
+        std::string req;
+        for (auto& k : keys) req += command({"OBJECT", "FREQ", k});
+        if (!roundTrip(fd, req, keys.size(), replies)) {
+            std::cerr << "OBJECT FREQ failed" << std::endl;
+            return 1;
+        }
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (replies[i].type != ':') continue;   //遍历途中被删掉的 key
+            best.emplace(replies[i].num, keys[i]);
+            if (best.size() > top) best.pop();
+        }
+        scanned += keys.size();
+    } while (cursor != "0");
+
+    std::vector<Item> result;
+    for (; !best.empty(); best.pop()) result.push_back(best.top());
+    std::cout << "scanned " << scanned << " keys, top " << result.size() << " by LFU frequency:" << std::endl;
+    for (auto it = result.rbegin(); it != result.rend(); ++it)
+        std::cout << "  freq " << it->first << "\t" << it->second << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::string host = "127.0.0.1", cmd = "set", unixPath;
+    int port = 6379, clients = 50, pipeline = 1, keyspace = 100000;
+    long long requests = 100000;
+    size_t valueSize = 3, hotTop = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string opt = argv[i];
+        if (opt == "--host") host = argv[i + 1];
+        else if (opt == "--port") port = atoi(argv[i + 1]);
+        else if (opt == "--unix") unixPath = argv[i + 1];
+        else if (opt == "--clients") clients = atoi(argv[i + 1]);
+        else if (opt == "--requests") requests = atoll(argv[i + 1]);
+        else if (opt == "--pipeline") pipeline = atoi(argv[i + 1]);
+        else if (opt == "--size") valueSize = strtoull(argv[i + 1], nullptr, 10);
+        else if (opt == "--keyspace") keyspace = atoi(argv[i + 1]);
+        else if (opt == "--cmd") cmd = argv[i + 1];
+        else if (opt == "--hotkeys") hotTop = strtoull(argv[i + 1], nullptr, 10);
+        else { std::cerr << "unknown option: " << opt << std::endl; return 1; }
+    }
+    if (hotTop > 0) {
+        int fd = connectServer(host, port, unixPath);
+        if (fd < 0) return 1;
+        int rc = hotkeys(fd, hotTop);
+        close(fd);
+        return rc;
+    }
+
+    int ep = epoll_create1(0);
+    std::vector<Conn> conns(clients);
+    std::string value(valueSize, 'x');
+    long long issued = 0, done = 0;
+    std::vector<double> latencies;   //每一批的往返时间(微秒)
+    latencies.reserve(requests / pipeline + clients);
+    unsigned seed = 12345;
+
+    auto fillBatch = [&](Conn& c) {
+        c.out.clear();
+        c.outPos = 0;
+        c.waiting = 0;
+        for (int p = 0; p < pipeline && issued < requests; p++, issued++) {
+            seed = seed * 1103515245 + 12345;
+            std::string key = "key:" + std::to_string((seed >> 8) % keyspace);
+            if (cmd == "get") c.out += command({"GET", key});
+            else c.out += command({"SET", key, value});
+            c.waiting++;
+        }
+        c.sentAt = Clock::now();
+    };
+
+    for (int i = 0; i < clients; i++) {
+        Conn& c = conns[i];
+        c.fd = connectServer(host, port, unixPath);
+        if (c.fd < 0) return 1;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.u32 = i;
+        epoll_ctl(ep, EPOLL_CTL_ADD, c.fd, &ev);
+        fillBatch(c);
+    }
+
+    auto start = Clock::now();
+    std::vector<epoll_event> events(clients);
+    std::vector<char> buf(64 * 1024);
+    while (done < requests) {
+        int n = epoll_wait(ep, events.data(), clients, 1000);
+        for (int e = 0; e < n; e++) {
+            Conn& c = conns[events[e].data.u32];
+            if ((events[e].events & EPOLLOUT) && c.outPos < c.out.size()) {
+                ssize_t w = write(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos);
+                if (w > 0) c.outPos += w;
+            }
+            if (events[e].events & EPOLLIN) {
+                ssize_t r = read(c.fd, buf.data(), buf.size());
+                if (r <= 0) { std::cerr << "connection closed by server" << std::endl; return 1; }
+                c.in.append(buf.data(), r);
+                size_t pos = 0, len;
+                while (c.waiting > 0 && (len = replyLength(c.in.data() + pos, c.in.size() - pos)) > 0) {
+                    pos += len;
+                    c.waiting--;
+                    done++;
+                }
+                c.in.erase(0, pos);
+                if (c.waiting == 0 && !c.out.empty()) {
+                    latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - c.sentAt).count());
+                    fillBatch(c);
+                }
+            }
+            //发完这一批就只关心可读
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            if (c.outPos < c.out.size()) ev.events |= EPOLLOUT;
+            ev.data.u32 = events[e].data.u32;
+            epoll_ctl(ep, EPOLL_CTL_MOD, c.fd, &ev);
+        }
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](double p) { return latencies.empty() ? 0 : latencies[(size_t)(p * (latencies.size() - 1))]; };
+    std::cout << (unixPath.empty() ? "tcp " + host + ":" + std::to_string(port) : "unix " + unixPath) << ", ";
+    std::cout << cmd << " x " << requests << ", clients=" << clients << ", pipeline=" << pipeline
+              << ", value=" << valueSize << "B" << std::endl;
+    std::cout << "QPS: " << (long long)(requests / secs) << std::endl;
+    std::cout << "value throughput: " << requests * (double)valueSize / secs / (1024 * 1024) << " MB/s" << std::endl;
+    std::cout << "batch latency(us) p50=" << pct(0.5) << " p99=" << pct(0.99) << " p999=" << pct(0.999) << std::endl;
+    for (auto& c : conns) close(c.fd);
+}
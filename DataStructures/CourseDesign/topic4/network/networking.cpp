@@ -1,19 +1,112 @@
 #include "networking.h"
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+static int fail(int fd, const std::string& what) {
+    std::cerr << what << ": " << strerror(errno) << std::endl;
+    if (fd >= 0) close(fd);
+    return -1;
+}
+
+static int listenUnix(const ListenOptions& opts) {
+    sockaddr_un addr{};
+    if (opts.unixPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "unix socket path too long: " << opts.unixPath << std::endl;
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return fail(fd, "socket");
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, opts.unixPath.c_str());
+    unlink(opts.unixPath.c_str());  //删掉上次留下的 socket 文件
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) return fail(fd, "bind " + opts.unixPath);
+    chmod(opts.unixPath.c_str(), opts.unixPerm);
+    if (listen(fd, opts.backlog) < 0) return fail(fd, "listen " + opts.unixPath);
+    return fd;
+}
+
+int createServer(const ListenOptions& opts) {
+    if (!opts.unixPath.empty()) return listenUnix(opts);
 
-int createServer(int port) {
     int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return fail(fd, "socket");
+    int on = 1;
+    if (opts.reuseAddr && setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0)
+        return fail(fd, "setsockopt SO_REUSEADDR");
+    if (opts.reusePort && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0)
+        return fail(fd, "setsockopt SO_REUSEPORT");
+
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    addr.sin_addr.s_addr = INADDR_ANY;
-    bind(fd, (sockaddr*)&addr, sizeof(addr));
-    listen(fd, 5);
+    addr.sin_port = htons(opts.port);
+    if (inet_pton(AF_INET, opts.bindAddr.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "invalid bind address: " << opts.bindAddr << std::endl;
+        close(fd);
+        return -1;
+    }
+    std::string where = opts.bindAddr + ":" + std::to_string(opts.port);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) return fail(fd, "bind " + where);
+    if (listen(fd, opts.backlog) < 0) return fail(fd, "listen " + where);
     return fd;
 }
 
+int createServer(int port) {
+    ListenOptions opts;
+    opts.port = port;
+    return createServer(opts);
+}
+
 int acceptClient(int serverFd) {
     return accept(serverFd, nullptr, nullptr);
 }
+
+void tuneClientSocket(int fd, const ListenOptions& opts) {
+    if (!opts.unixPath.empty()) return;
+    int on = 1;
+    if (opts.tcpNoDelay) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (opts.keepAlive > 0) {
+        //空闲 keepAlive 秒后开始探测,每 keepAlive/3 秒一次,3 次没回应就断开
+        int idle = opts.keepAlive, intvl = opts.keepAlive / 3, cnt = 3;
+        if (intvl == 0) intvl = 1;
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &cnt, sizeof(cnt));
+    }
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return false;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+int connectTcp(const std::string& host, int port, int timeoutMs) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) return -1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    // Linux 上 SO_SNDTIMEO 同样限制 connect 的等待时间
+    timeval tv{timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
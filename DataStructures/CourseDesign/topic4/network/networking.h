@@ -1,3 +1,25 @@
 #pragma once
+#include <string>
+
+//监听选项:unixPath 非空时监听 Unix domain socket,否则监听 TCP
+struct ListenOptions {
+    std::string bindAddr = "0.0.0.0";
+    int port = 6379;
+    std::string unixPath;
+    int unixPerm = 0700;
+    int backlog = 511;
+    bool reuseAddr = true;      //重启时不用等 TIME_WAIT
+    bool reusePort = false;     //允许多个监听 socket(本进程或其他进程)绑同一端口,由内核分摊连接
+    bool tcpNoDelay = true;     //关掉 Nagle,小回复立即发出
+    int keepAlive = 300;        // TCP keepalive 空闲秒数,0 表示不开启
+};
+
+//创建监听 socket,失败时打印原因并返回 -1
+int createServer(const ListenOptions& opts);
 int createServer(int port);
 int acceptClient(int serverFd);
+//对新接受的连接应用 TCP 选项(Unix socket 不需要)
+void tuneClientSocket(int fd, const ListenOptions& opts);
+bool setNonBlocking(int fd);
+//阻塞式连接 host:port(IPv4),之后的读写超过 timeoutMs 也会失败;失败返回 -1
+int connectTcp(const std::string& host, int port, int timeoutMs);
@@ -2,37 +2,71 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <cstdlib>
 
-std::vector<std::string> Resp::parse(const std::string& input) {
-    std::vector<std::string> result;
-
-    size_t i = 0;
-    size_t n = input.size();
-
-    // 必须以 * 开头（RESP Array）
-    if (n == 0 || input[i] != '*') return result;
-
-    // 跳过 "*<num>\r\n"
-    i = input.find("\r\n", i);
-    if (i == std::string::npos) return result;
-    i += 2;
+//读取 "<数字>\r\n",p 指向数字第一个字符;成功时 p 移到 \r\n 之后,返回值含义同 parseCommand
+static int readNumber(const char*& p, const char* end, long long& out) {
+    const char* cr = static_cast<const char*>(memchr(p, '\r', end - p));
+    if (!cr || cr + 1 >= end) return 0;
+    char* stop = nullptr;
+    out = strtoll(p, &stop, 10);
+    if (stop != cr || cr[1] != '\n') return -1;
+    p = cr + 2;
+    return 1;
+}
 
-    while (i < n) {
-        if (input[i] != '$') break;
+int Resp::parseCommand(const char* buf, size_t len, std::vector<std::string>& argv, size_t& consumed) {
+    argv.clear();
+    if (len == 0) return 0;
+    const char* p = buf;
+    const char* end = buf + len;
 
-        // 跳过 "$<len>\r\n"
-        i = input.find("\r\n", i);
-        if (i == std::string::npos) break;
-        i += 2;
+    // inline 命令(如 telnet 直接输入 "PING\r\n"),按空格切分
+    if (*p != '*') {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', len));
+        if (!nl) return 0;
+        const char* lineEnd = (nl > p && nl[-1] == '\r') ? nl - 1 : nl;
+        const char* s = p;
+        while (s < lineEnd) {
+            while (s < lineEnd && *s == ' ') s++;
+            const char* e = s;
+            while (e < lineEnd && *e != ' ') e++;
+            if (e > s) argv.emplace_back(s, e - s);
+            s = e;
+        }
+        consumed = nl + 1 - buf;
+        return 1;
+    }
 
-        // 读取真正的数据
-        size_t end = input.find("\r\n", i);
-        if (end == std::string::npos) break;
+    // "*<num>\r\n" 后面跟 num 个 "$<len>\r\n<data>\r\n"
+    long long count = 0;
+    p++;
+    int st = readNumber(p, end, count);
+    if (st <= 0) return st;
+    if (count < 0 || count > 1024 * 1024) return -1;
+    argv.reserve(count);
 
-        result.push_back(input.substr(i, end - i));
-        i = end + 2;
+    for (long long i = 0; i < count; i++) {
+        if (p >= end) return 0;
+        if (*p != '$') return -1;
+        long long blen = 0;
+        p++;
+        st = readNumber(p, end, blen);
+        if (st <= 0) return st;
+        if (blen < 0) return -1;
+        //按长度读取数据,值里可以包含 \r\n
+        if (end - p < blen + 2) return 0;
+        argv.emplace_back(p, blen);
+        p += blen + 2;
     }
+    consumed = p - buf;
+    return 1;
+}
 
+std::vector<std::string> Resp::parse(const std::string& input) {
+    std::vector<std::string> result;
+    size_t consumed = 0;
+    if (parseCommand(input.data(), input.size(), result, consumed) != 1) result.clear();
     return result;
 }
 
@@ -40,10 +74,49 @@ std::string Resp::simple(const std::string& s) {
     return "+" + s + "\r\n";
 }
 
+std::string Resp::error(const std::string& s) {
+    return "-" + s + "\r\n";
+}
+
+std::string Resp::integer(long long n) {
+    return ":" + std::to_string(n) + "\r\n";
+}
+
+//一次分配好空间,值只拷贝一次(大值的回复走 Server::addReplyObject,不经过这里)
 std::string Resp::bulk(const std::string& s) {
-    return "$" + std::to_string(s.size()) + "\r\n" + s + "\r\n";
+    std::string len = std::to_string(s.size());
+    std::string r;
+    r.reserve(len.size() + s.size() + 5);
+    r += '$';
+    r += len;
+    r += "\r\n";
+    r += s;
+    r += "\r\n";
+    return r;
 }
 
 std::string Resp::nullBulk() {
     return "$-1\r\n";
 }
+
+std::string Resp::nullArray() {
+    return "*-1\r\n";
+}
+
+std::string Resp::arrayHeader(size_t n) {
+    return "*" + std::to_string(n) + "\r\n";
+}
+
+std::string Resp::pushHeader(size_t n) {
+    return ">" + std::to_string(n) + "\r\n";
+}
+
+std::string Resp::mapHeader(size_t n) {
+    return "%" + std::to_string(n) + "\r\n";
+}
+
+std::string Resp::command(const std::vector<std::string>& argv) {
+    std::string s = arrayHeader(argv.size());
+    for (auto& a : argv) s += bulk(a);
+    return s;
+}
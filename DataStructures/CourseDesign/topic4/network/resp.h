@@ -4,8 +4,21 @@
 
 class Resp {
 public:
+    //从 buf 中解析出一条完整命令:返回 1 表示解析成功(consumed 为消耗的字节数),
+    //0 表示数据还不完整需要继续读,-1 表示协议错误
+    static int parseCommand(const char* buf, size_t len, std::vector<std::string>& argv, size_t& consumed);
     static std::vector<std::string> parse(const std::string& input);
     static std::string simple(const std::string& s);
+    static std::string error(const std::string& s);
+    static std::string integer(long long n);
     static std::string bulk(const std::string& s);
     static std::string nullBulk();
+    static std::string nullArray();     //阻塞命令超时等场合的空回复
+    //数组回复的头部,后面紧跟 n 个元素
+    static std::string arrayHeader(size_t n);
+    // RESP3:服务器主动推送的消息(>)和键值对(%),只发给 HELLO 3 之后的客户端
+    static std::string pushHeader(size_t n);
+    static std::string mapHeader(size_t n);
+    //把一条命令编码成请求格式(多个 bulk 组成的数组),节点之间转发数据时用
+    static std::string command(const std::vector<std::string>& argv);
 };
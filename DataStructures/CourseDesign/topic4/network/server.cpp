@@ -1,46 +1,809 @@
 #include "server.h"
 #include "networking.h"
 #include "resp.h"
+#include "../storage/trace.h"
 #include <unistd.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <cerrno>
+#include <cctype>
+#include <cstdlib>
+#include <strings.h>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
 
-Server::Server(StorageEngine& e) : engine(e) {}
+static const size_t READ_CHUNK = 16 * 1024;              //每次 read 的大小
+static const size_t REPLY_CHUNK = 16 * 1024;             //回复块的大小,小回复会拼到同一块里
+static const size_t MAX_WRITE_PER_EVENT = 64 * 1024;     //一次写事件最多写这么多,避免一个客户端霸占事件循环
+static const size_t REPLY_PAUSE_BYTES = 1024 * 1024;     //积压超过这个值就暂停执行该客户端的后续命令
 
-//服务器开始工作
-void Server::start(int port) {
-    int sfd = createServer(port);
+Server::Server(StorageEngine& e) : engine(e), timers(monotonicMs()), blockingKeys(e.dbCount()) {
+    //默认值与 Redis 相同:普通客户端不限制,订阅/从节点客户端有软硬限制
+    limits[(int)ClientClass::Normal] = {0, 0, 0};
+    limits[(int)ClientClass::PubSub] = {32 * 1024 * 1024, 8 * 1024 * 1024, 60};
+    limits[(int)ClientClass::Replica] = {256 * 1024 * 1024, 64 * 1024 * 1024, 60};
+    engine.setKeyModifiedHook([this](const std::string& key) { trackingInvalidateKey(key); });
+}
+
+void Server::setOutputBufferLimit(ClientClass cls, const OutputBufferLimit& limit) {
+    limits[(int)cls] = limit;
+}
+
+//服务器开始工作:创建所有监听 socket,按选择的后端进入事件循环
+bool Server::start(const std::vector<ListenOptions>& listenOpts) {
+    for (auto& opts : listenOpts) {
+        int fd = createServer(opts);
+        if (fd < 0) {
+            for (auto& l : listeners) close(l.fd);
+            listeners.clear();
+            return false;
+        }
+        setNonBlocking(fd);
+        listeners.push_back({fd, opts});
+        if (opts.unixPath.empty()) std::cerr << "listening on " << opts.bindAddr << ":" << opts.port << std::endl;
+        else std::cerr << "listening on unix:" << opts.unixPath << std::endl;
+    }
+    timers.add(monotonicMs() + CRON_INTERVAL_MS, [this] { serverCron(); });
+    if (backend == IoBackend::Uring) {
+        runUring();
+        //内核不支持 io_uring 时 runUring 会直接返回,退回 epoll
+        backend = IoBackend::Epoll;
+    }
+    runEpoll();
+    return true;
+}
+
+bool Server::start(int port) {
+    ListenOptions opts;
+    opts.port = port;
+    return start(std::vector<ListenOptions>{opts});
+}
+
+//单线程 epoll 事件循环
+void Server::runEpoll() {
+    epfd = epoll_create1(0);
+
+    for (auto& l : listeners) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = l.fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, l.fd, &ev);
+    }
+
+    epoll_event events[1024];
+    while (true) {
+        //等待超时就是离最近一个定时器到期的时间,没有事件时不会空转
+        int n;
+        {
+            TRACE_SCOPE("epoll_wait");
+            n = epoll_wait(epfd, events, 1024, timers.nextTimeoutMs(monotonicMs(), -1));
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            const Listener* l = nullptr;
+            for (auto& x : listeners) if (x.fd == fd) l = &x;
+            if (l) {
+                acceptClients(*l);
+                continue;
+            }
+            auto it = clients.find(fd);
+            if (it == clients.end()) continue;
+            Client* c = it->second;
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                freeClient(c);
+                continue;
+            }
+            //先写后读:先把积压的回复发出去,读到的新命令才有地方放
+            if (events[i].events & EPOLLOUT) {
+                writeToClient(c);
+                if (clients.find(fd) == clients.end()) continue;
+            }
+            if (events[i].events & EPOLLIN) readFromClient(c);
+        }
+        timers.advance(monotonicMs());
+        processUnblockedClients();
+        trackingBroadcastInvalidations();
+    }
+}
 
+void Server::acceptClients(const Listener& l) {
     while (true) {
-        int cfd = acceptClient(sfd);
-        if (cfd < 0) continue;
-
-        while (true) {
-            char buf[1024] = {0};
-            ssize_t n = read(cfd, buf, sizeof(buf));
-            if (n <= 0) break;  // 客户端关闭
-
-            auto cmd = Resp::parse(buf);
-            if (cmd.empty()) continue;
-
-            std::string reply;
-            if (cmd[0] == "SET" && cmd.size() >= 3) {
-                engine.set(cmd[1], cmd[2]);
-                reply = Resp::simple("OK");
-            } 
-            else if (cmd[0] == "GET" && cmd.size() >= 2) {
-                auto v = engine.get(cmd[1]);
-                reply = v ? Resp::bulk(*v) : Resp::nullBulk();
-            } 
-            else if (cmd[0] == "DEL" && cmd.size() >= 2) {
-                reply = Resp::simple(engine.del(cmd[1]) ? "1" : "0");
-            } 
-            else {
-                reply = Resp::simple("ERR");
+        int cfd = acceptClient(l.fd);
+        if (cfd < 0) return;  // EAGAIN:这一批已经接收完
+        setNonBlocking(cfd);
+        tuneClientSocket(cfd, l.opts);
+        Client* c = new Client;
+        c->fd = cfd;
+        clients[cfd] = c;
+        trackClient(c);
+        updateEvents(c);
+    }
+}
+
+void Server::readFromClient(Client* c) {
+    ssize_t n;
+    {
+        TRACE_SCOPE("read");
+        if (c->bigArg && c->bigArgIndex < 0 && c->bigArgRead < (size_t)c->bulklen) {
+            //正在读大参数:querybuf 此时一定是空的,数据直接读进最终的 SDS
+            n = read(c->fd, c->bigArg->buf + c->bigArgRead, c->bulklen - c->bigArgRead);
+            if (n > 0) c->bigArgRead += n;
+        } else {
+            size_t old = c->querybuf.size();
+            c->querybuf.resize(old + READ_CHUNK);
+            n = read(c->fd, &c->querybuf[old], READ_CHUNK);
+            c->querybuf.resize(old + (n > 0 ? n : 0));
+        }
+    }
+    if (n <= 0) {
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) return;
+        freeClient(c);  // 客户端关闭
+        return;
+    }
+    c->lastInteraction = monotonicMs();
+    if (c->querybuf.size() > QUERYBUF_MAX) {
+        std::cerr << "client fd=" << c->fd << " query buffer too big, closing" << std::endl;
+        freeClient(c);
+        return;
+    }
+
+    processInput(c);
+    if (c->closeAsap && c->reply.empty()) {
+        freeClient(c);
+        return;
+    }
+    //先直接尝试写,写不完的部分再交给 EPOLLOUT
+    if (c->replyBytes > 0) writeToClient(c);
+    else updateEvents(c);
+}
+
+//把收到的数据交给客户端:正在读大参数时先填满它,剩下的放进 querybuf(io_uring 后端用)
+void Server::feedInput(Client* c, const char* data, size_t n) {
+    if (c->bigArg && c->bigArgIndex < 0) {
+        size_t take = std::min(n, (size_t)c->bulklen - c->bigArgRead);
+        memcpy(c->bigArg->buf + c->bigArgRead, data, take);
+        c->bigArgRead += take;
+        data += take;
+        n -= take;
+    }
+    c->querybuf.append(data, n);
+}
+
+//解析 "<前缀字符><整数>\r\n" 形式的行,成功时 pos 移到下一行;1 成功,0 数据不够,-1 格式错误
+static int readLengthLine(const std::string& buf, size_t& pos, char prefix, long long& out) {
+    const char* p = buf.data() + pos;
+    const char* end = buf.data() + buf.size();
+    const char* cr = static_cast<const char*>(memchr(p, '\r', end - p));
+    if (!cr || cr + 1 >= end) return end - p > 64 * 1024 ? -1 : 0;
+    if (*p != prefix || cr[1] != '\n' || cr == p + 1) return -1;
+    bool neg = p[1] == '-';
+    long long v = 0;
+    for (const char* q = p + 1 + neg; q < cr; q++) {
+        if (*q < '0' || *q > '9' || v > PROTO_MAX_BULK_LEN) return -1;
+        v = v * 10 + (*q - '0');
+    }
+    out = neg ? -v : v;
+    pos = cr + 2 - buf.data();
+    return 1;
+}
+
+//从 querybuf 的 pos 处继续解析一条命令到 c->argv;1 表示完整,0 表示需要更多数据,-1 表示协议错误。
+//RESP 数组的解析状态保存在 Client 里,半条命令不会在每次读到新数据时从头重新解析
+int Server::parseRequest(Client* c, size_t& pos) {
+    if (c->multibulklen == 0) {
+        if (pos >= c->querybuf.size()) return 0;
+        c->argv.clear();
+        // inline 命令交给 Resp 解析
+        if (c->querybuf[pos] != '*') {
+            size_t consumed = 0;
+            int r = Resp::parseCommand(c->querybuf.data() + pos, c->querybuf.size() - pos, c->argv, consumed);
+            if (r == 1) pos += consumed;
+            return r;
+        }
+        long long n;
+        int r = readLengthLine(c->querybuf, pos, '*', n);
+        if (r <= 0) return r;
+        if (n > PROTO_MAX_MULTIBULK_LEN) return -1;
+        if (n <= 0) return 1;   //空数组,跳过
+        c->multibulklen = n;
+        c->argv.reserve(std::min<long long>(n, 1024));
+    }
+    while (c->multibulklen > 0) {
+        if (c->bulklen == -1) {
+            long long len;
+            int r = readLengthLine(c->querybuf, pos, '$', len);
+            if (r <= 0) return r;
+            if (len < 0 || len > PROTO_MAX_BULK_LEN) return -1;
+            c->bulklen = len;
+            if ((size_t)len >= BIG_ARG) {
+                //一条命令只直接接管一个大参数,前一个先转成普通参数
+                if (c->bigArg) {
+                    c->argv[c->bigArgIndex].assign(c->bigArg->buf, c->bigArg->len);
+                    sdsFree(c->bigArg);
+                }
+                c->bigArg = sdsNewLen(nullptr, len);
+                c->bigArgIndex = -1;
+                c->bigArgRead = std::min((size_t)len, c->querybuf.size() - pos);
+                memcpy(c->bigArg->buf, c->querybuf.data() + pos, c->bigArgRead);
+                pos += c->bigArgRead;
+            }
+        }
+        if (c->bigArg && c->bigArgIndex < 0) {
+            if (c->bigArgRead < (size_t)c->bulklen || c->querybuf.size() - pos < 2) return 0;
+            c->bigArgIndex = c->argv.size();
+            c->argv.emplace_back();
+        } else {
+            if (c->querybuf.size() - pos < (size_t)c->bulklen + 2) return 0;
+            c->argv.emplace_back(c->querybuf.data() + pos, c->bulklen);
+            pos += c->bulklen;
+        }
+        if (c->querybuf.compare(pos, 2, "\r\n") != 0) return -1;
+        pos += 2;
+        c->bulklen = -1;
+        c->multibulklen--;
+    }
+    return 1;
+}
+
+//从请求缓冲区里逐条解析命令并执行(支持 pipeline)
+void Server::processInput(Client* c) {
+    size_t pos = 0;
+    while (!c->closeAsap && !c->blocked) {
+        if (c->replyBytes > REPLY_PAUSE_BYTES) {
+            c->readPaused = true;
+            break;
+        }
+        int r;
+        {
+            TRACE_SCOPE("parse");
+            r = parseRequest(c, pos);
+        }
+        if (r == 0) break;
+        if (r < 0) {
+            addReply(c, Resp::error("ERR Protocol error"));
+            c->closeAsap = true;
+            break;
+        }
+        if (c->bigArg && !(c->bigArgIndex == 2 && !strcasecmp(c->argv[0].c_str(), "SET"))) {
+            //只有 SET 的值能直接接管大参数,其他命令拿到的是普通参数
+            c->argv[c->bigArgIndex].assign(c->bigArg->buf, c->bigArg->len);
+            sdsFree(c->bigArg);
+            c->bigArg = nullptr;
+        }
+        if (!c->argv.empty()) execute(c, c->argv);
+        //被重定向等原因没有用掉的大参数
+        sdsFree(c->bigArg);
+        c->bigArg = nullptr;
+        c->bigArgIndex = -1;
+        c->argv.clear();
+    }
+    c->querybuf.erase(0, pos);
+}
+
+static const char* WRONGTYPE = "WRONGTYPE Operation against a key holding the wrong kind of value";
+
+void Server::execute(Client* c, const std::vector<std::string>& cmd) {
+    TRACE_SCOPE_DETAIL("execute", cmd[0]);
+    std::string name = cmd[0];
+    for (auto& ch : name) ch = toupper((unsigned char)ch);
+    if (cluster) {
+        bool redirected = clusterRedirect(c, name, cmd);
+        c->asking = false;
+        if (redirected) return;
+    }
+    currentClientId = c->id;
+    engine.select(c->db);
+    if (c->tracking && !c->trackingBcast) trackingRememberKeys(c, name, cmd);
+    std::string reply;
+    if (name == "SET" && cmd.size() >= 3) {
+        if (c->bigArg) {
+            engine.setOwned(cmd[1], c->bigArg);
+            c->bigArg = nullptr;
+        } else {
+            engine.set(cmd[1], cmd[2]);
+        }
+        reply = Resp::simple("OK");
+    }
+    else if (name == "GET" && cmd.size() >= 2) {
+        if (!engine.checkType(cmd[1], OBJ_STRING)) reply = Resp::error(WRONGTYPE);
+        else if (Object* o = engine.getStringObject(cmd[1])) {
+            auto* v = static_cast<SDS*>(o->ptr);
+            //压缩存放的值只能解压成一份拷贝再发
+            if (o->encoding != OBJ_ENCODING_RAW) reply = Resp::bulk(stringObjectValue(o));
+            else if (v->len >= REPLY_CHUNK) {
+                addReplyObject(c, o);
+                return;
+            } else {
+                reply = Resp::bulk(std::string(v->buf, v->len));
             }
+        } else {
+            reply = Resp::nullBulk();
+        }
+    }
+    else if (name == "DEL" && cmd.size() >= 2) {
+        reply = Resp::simple(engine.del(cmd[1]) ? "1" : "0");
+    }
+    else if (name == "HSET" && cmd.size() >= 4 && cmd.size() % 2 == 0) {
+        if (!engine.checkType(cmd[1], OBJ_HASH)) reply = Resp::error(WRONGTYPE);
+        else {
+            long long added = 0;
+            for (size_t i = 2; i < cmd.size(); i += 2) added += engine.hset(cmd[1], cmd[i], cmd[i + 1]);
+            reply = Resp::integer(added);
+        }
+    }
+    else if (name == "HGET" && cmd.size() == 3) {
+        if (!engine.checkType(cmd[1], OBJ_HASH)) reply = Resp::error(WRONGTYPE);
+        else {
+            auto v = engine.hget(cmd[1], cmd[2]);
+            reply = v ? Resp::bulk(*v) : Resp::nullBulk();
+        }
+    }
+    else if (name == "HDEL" && cmd.size() >= 3) {
+        if (!engine.checkType(cmd[1], OBJ_HASH)) reply = Resp::error(WRONGTYPE);
+        else {
+            long long deleted = 0;
+            for (size_t i = 2; i < cmd.size(); i++) deleted += engine.hdel(cmd[1], cmd[i]);
+            reply = Resp::integer(deleted);
+        }
+    }
+    else if ((name == "HLEN" && cmd.size() == 2) || (name == "HEXISTS" && cmd.size() == 3)) {
+        if (!engine.checkType(cmd[1], OBJ_HASH)) reply = Resp::error(WRONGTYPE);
+        else if (name == "HLEN") reply = Resp::integer(engine.hlen(cmd[1]));
+        else reply = Resp::integer(engine.hget(cmd[1], cmd[2]) ? 1 : 0);
+    }
+    else if (name == "HGETALL" && cmd.size() == 2) {
+        if (!engine.checkType(cmd[1], OBJ_HASH)) reply = Resp::error(WRONGTYPE);
+        else {
+            auto all = engine.hgetall(cmd[1]);
+            reply = Resp::arrayHeader(all.size() * 2);
+            for (auto& kv : all) reply += Resp::bulk(kv.first) + Resp::bulk(kv.second);
+        }
+    }
+    else if ((name == "LPUSH" || name == "RPUSH") && cmd.size() >= 3) {
+        if (!engine.checkType(cmd[1], OBJ_LIST)) reply = Resp::error(WRONGTYPE);
+        else {
+            reply = Resp::integer(engine.push(cmd[1], std::vector<std::string>(cmd.begin() + 2, cmd.end()), name == "LPUSH"));
+            signalKeyAsReady(c->db, cmd[1]);
+        }
+    }
+    else if ((name == "LPOP" || name == "RPOP") && cmd.size() == 2) {
+        if (!engine.checkType(cmd[1], OBJ_LIST)) reply = Resp::error(WRONGTYPE);
+        else {
+            auto v = engine.pop(cmd[1], name == "LPOP");
+            reply = v ? Resp::bulk(*v) : Resp::nullBulk();
+        }
+    }
+    else if (name == "LLEN" && cmd.size() == 2) {
+        if (!engine.checkType(cmd[1], OBJ_LIST)) reply = Resp::error(WRONGTYPE);
+        else reply = Resp::integer(engine.llen(cmd[1]));
+    }
+    else if (name == "LRANGE" && cmd.size() == 4) {
+        if (!engine.checkType(cmd[1], OBJ_LIST)) reply = Resp::error(WRONGTYPE);
+        else {
+            auto items = engine.lrange(cmd[1], atoll(cmd[2].c_str()), atoll(cmd[3].c_str()));
+            reply = Resp::arrayHeader(items.size());
+            for (auto& v : items) reply += Resp::bulk(v);
+        }
+    }
+    else if ((name == "BLPOP" || name == "BRPOP") && cmd.size() >= 3) {
+        blockingPopCommand(c, cmd, name == "BLPOP");
+        return;
+    }
+    else if (name == "XADD" && cmd.size() >= 5) {
+        reply = xaddCommand(c, cmd);
+    }
+    else if (name == "XLEN" && cmd.size() == 2) {
+        if (!engine.checkType(cmd[1], OBJ_STREAM)) reply = Resp::error(WRONGTYPE);
+        else {
+            Stream* s = engine.streamRead(cmd[1]);
+            reply = Resp::integer(s ? s->length() : 0);
+        }
+    }
+    else if ((name == "XRANGE" || name == "XREVRANGE") && (cmd.size() == 4 || cmd.size() == 6)) {
+        reply = xrangeCommand(cmd, name == "XREVRANGE");
+    }
+    else if (name == "XDEL" && cmd.size() >= 3) {
+        reply = xdelCommand(cmd);
+    }
+    else if (name == "XTRIM" && cmd.size() >= 4) {
+        reply = xtrimCommand(cmd);
+    }
+    else if ((name == "XREAD" || name == "XREADGROUP") && cmd.size() >= 4) {
+        reply = xreadCommand(c, cmd, name == "XREADGROUP");
+        if (c->blocked) return;
+    }
+    else if (name == "XGROUP" && cmd.size() >= 4) {
+        reply = xgroupCommand(cmd);
+    }
+    else if (name == "XACK" && cmd.size() >= 4) {
+        reply = xackCommand(cmd);
+    }
+    else if (name == "XPENDING" && cmd.size() >= 3) {
+        reply = xpendingCommand(cmd);
+    }
+    else if (name == "XINFO" && cmd.size() == 3) {
+        reply = xinfoCommand(cmd);
+    }
+    else if (name == "ZADD" && cmd.size() >= 4) {
+        reply = zaddCommand(cmd, false);
+    }
+    else if (name == "ZINCRBY" && cmd.size() == 4) {
+        reply = zaddCommand(cmd, true);
+    }
+    else if (name == "ZREM" && cmd.size() >= 3) {
+        reply = zremCommand(cmd);
+    }
+    else if (name == "ZSCORE" && cmd.size() == 3) {
+        reply = zscoreCommand(cmd);
+    }
+    else if (name == "ZCARD" && cmd.size() == 2) {
+        if (!engine.checkType(cmd[1], OBJ_ZSET)) reply = Resp::error(WRONGTYPE);
+        else {
+            ZSet* z = engine.zsetRead(cmd[1]);
+            reply = Resp::integer(z ? z->size() : 0);
+        }
+    }
+    else if ((name == "ZRANK" || name == "ZREVRANK") && cmd.size() == 3) {
+        reply = zrankCommand(cmd, name == "ZREVRANK");
+    }
+    else if ((name == "ZRANGE" || name == "ZREVRANGE") && (cmd.size() == 4 || cmd.size() == 5)) {
+        reply = zrangeCommand(cmd, name == "ZREVRANGE");
+    }
+    else if ((name == "ZRANGEBYSCORE" || name == "ZREVRANGEBYSCORE") && cmd.size() >= 4) {
+        reply = zrangebyscoreCommand(cmd, name == "ZREVRANGEBYSCORE");
+    }
+    else if (name == "ZCOUNT" && cmd.size() == 4) {
+        reply = zcountCommand(cmd);
+    }
+    else if (name == "GEOADD" && cmd.size() >= 5) {
+        reply = geoaddCommand(cmd);
+    }
+    else if (name == "GEOPOS" && cmd.size() >= 2) {
+        reply = geoposCommand(cmd);
+    }
+    else if (name == "GEODIST" && (cmd.size() == 4 || cmd.size() == 5)) {
+        reply = geodistCommand(cmd);
+    }
+    else if (name == "GEOHASH" && cmd.size() >= 2) {
+        reply = geohashCommand(cmd);
+    }
+    else if (name == "GEOSEARCH" && cmd.size() >= 6) {
+        reply = geosearchCommand(cmd);
+    }
+    else if (name == "PFADD" && cmd.size() >= 2) {
+        if (!engine.checkType(cmd[1], OBJ_HLL)) reply = Resp::error(WRONGTYPE);
+        else reply = Resp::integer(engine.pfadd(cmd[1], std::vector<std::string>(cmd.begin() + 2, cmd.end())));
+    }
+    else if ((name == "PFCOUNT" && cmd.size() >= 2) || (name == "PFMERGE" && cmd.size() >= 2)) {
+        std::vector<std::string> keys(cmd.begin() + 1, cmd.end());
+        bool ok = true;
+        for (auto& k : keys) ok = ok && engine.checkType(k, OBJ_HLL);
+        if (!ok) reply = Resp::error(WRONGTYPE);
+        else if (name == "PFCOUNT") reply = Resp::integer(engine.pfcount(keys));
+        else {
+            engine.pfmerge(cmd[1], std::vector<std::string>(keys.begin() + 1, keys.end()));
+            reply = Resp::simple("OK");
+        }
+    }
+    // BF.RESERVE key error_rate capacity
+    else if (name == "BF.RESERVE" && cmd.size() == 4) {
+        char* end1;
+        char* end2;
+        double rate = strtod(cmd[2].c_str(), &end1);
+        long long cap = strtoll(cmd[3].c_str(), &end2, 10);
+        if (cmd[2].empty() || *end1 || !(rate > 0 && rate < 1)) reply = Resp::error("ERR (0 < error rate range < 1)");
+        else if (cmd[3].empty() || *end2 || cap <= 0) reply = Resp::error("ERR (capacity should be larger than 0)");
+        else if (engine.exists(cmd[1])) reply = Resp::error("ERR item exists");
+        else if (!engine.bfReserve(cmd[1], rate, cap)) reply = Resp::error("ERR filter would exceed the per-key size limit");
+        else reply = Resp::simple("OK");
+    }
+    else if ((name == "BF.ADD" || name == "BF.EXISTS") && cmd.size() == 3) {
+        if (!engine.checkType(cmd[1], OBJ_BLOOM)) reply = Resp::error(WRONGTYPE);
+        else if (name == "BF.ADD") reply = Resp::integer(engine.bfAdd(cmd[1], cmd[2]));
+        else reply = Resp::integer(engine.bfExists(cmd[1], cmd[2]) ? 1 : 0);
+    }
+    else if ((name == "BF.MADD" || name == "BF.MEXISTS") && cmd.size() >= 3) {
+        if (!engine.checkType(cmd[1], OBJ_BLOOM)) reply = Resp::error(WRONGTYPE);
+        else {
+            reply = Resp::arrayHeader(cmd.size() - 2);
+            for (size_t i = 2; i < cmd.size(); i++)
+                reply += Resp::integer(name == "BF.MADD" ? engine.bfAdd(cmd[1], cmd[i]) : engine.bfExists(cmd[1], cmd[i]) ? 1 : 0);
+        }
+    }
+    // RESTORE key ttl payload [REPLACE]:载荷只接受 StorageEngine::dumpObject 的格式(MIGRATE 搬 HLL/Bloom 时用);
+    //本服务器没有过期时间,ttl 只能是 0
+    else if (name == "RESTORE" && (cmd.size() == 4 || (cmd.size() == 5 && !strcasecmp(cmd[4].c_str(), "REPLACE")))) {
+        if (cmd[2] != "0") reply = Resp::error("ERR Invalid TTL value, must be 0");
+        else if (cmd.size() == 4 && engine.exists(cmd[1])) reply = Resp::error("BUSYKEY Target key name already exists.");
+        else if (!engine.restoreObject(cmd[1], cmd[3])) reply = Resp::error("ERR Bad data format");
+        else reply = Resp::simple("OK");
+    }
+    else if (name == "OBJECT" && cmd.size() == 3 && !strcasecmp(cmd[1].c_str(), "ENCODING")) {
+        const char* enc = engine.objectEncoding(cmd[2]);
+        reply = enc ? Resp::bulk(enc) : Resp::nullBulk();
+    }
+    else if (name == "OBJECT" && cmd.size() == 3 && !strcasecmp(cmd[1].c_str(), "FREQ")) {
+        int freq = engine.objectFreq(cmd[2]);
+        reply = freq >= 0 ? Resp::integer(freq) : Resp::nullBulk();
+    }
+    else if (name == "TYPE" && cmd.size() == 2) {
+        const char* type = engine.objectType(cmd[1]);
+        reply = Resp::simple(type ? type : "none");
+    }
+    else if (name == "DBSIZE" && cmd.size() == 1) {
+        reply = Resp::integer(engine.dbsize());
+    }
+    else if (name == "INFO" && cmd.size() <= 2) {
+        reply = infoCommand(cmd.size() == 2 ? cmd[1] : "");
+    }
+    else if (name == "SCAN" && cmd.size() >= 2) {
+        reply = scanCommand(cmd);
+    }
+    else if (name == "KEYS" && cmd.size() == 2) {
+        reply = keysCommand(cmd[1]);
+    }
+    else if (name == "TRACE" && cmd.size() >= 2) {
+        reply = traceCommand(cmd);
+    }
+    else if (name == "KEYINDEX" && cmd.size() >= 3) {
+        reply = keyindexCommand(cmd);
+    }
+    else if (name == "SELECT" && cmd.size() == 2) {
+        reply = selectCommand(c, cmd);
+    }
+    else if (name == "SWAPDB" && cmd.size() == 3) {
+        reply = swapdbCommand(cmd);
+    }
+    else if ((name == "FLUSHDB" || name == "FLUSHALL") && cmd.size() <= 2) {
+        reply = flushCommand(cmd, name == "FLUSHALL");
+    }
+    else if (name == "CLIENT") {
+        reply = clientCommand(c, cmd);
+    }
+    else if (name == "HELLO") {
+        reply = helloCommand(c, cmd);
+    }
+    else if (name == "SUBSCRIBE") {
+        reply = subscribeCommand(c, cmd);
+    }
+    else if (name == "CLUSTER") {
+        reply = clusterCommand(cmd);
+    }
+    else if (name == "ASKING") {
+        if (!cluster) reply = Resp::error("ERR This instance has cluster support disabled");
+        else {
+            c->asking = true;
+            reply = Resp::simple("OK");
+        }
+    }
+    else if (name == "MIGRATE") {
+        reply = migrateCommand(cmd);
+    }
+    else {
+        reply = Resp::simple("ERR");
+    }
+    addReply(c, std::move(reply));
+    if (!readyKeys.empty()) handleClientsBlockedOnKeys();
+}
+
+// TRACE DUMP <文件名> | RESET | ON | OFF | INFO
+// DUMP 把各线程环形缓冲区里的事件写成 Chrome trace JSON,返回写出的条数。
+//文件只能建在 --trace-dir 目录下,名字里不许有 / 和 ..,客户端不能借此覆盖服务器能写的任意文件
+std::string Server::traceCommand(const std::vector<std::string>& cmd) {
+#ifdef MINIREDIS_TRACE
+    const char* sub = cmd[1].c_str();
+    if (!strcasecmp(sub, "DUMP") && cmd.size() == 3) {
+        const std::string& file = cmd[2];
+        if (file.empty() || file.find('/') != std::string::npos || file.find("..") != std::string::npos)
+            return Resp::error("ERR invalid trace file name");
+        long long n = traceDumpChrome(traceDir + "/" + file);
+        return n < 0 ? Resp::error("ERR can't open " + file) : Resp::integer(n);
+    }
+    if (cmd.size() != 2) return Resp::error("ERR syntax error");
+    if (!strcasecmp(sub, "RESET")) traceReset();
+    else if (!strcasecmp(sub, "ON")) traceSetEnabled(true);
+    else if (!strcasecmp(sub, "OFF")) traceSetEnabled(false);
+    else if (!strcasecmp(sub, "INFO"))
+        return Resp::bulk("enabled:" + std::to_string(traceEnabled()) + "\r\nevents:" + std::to_string(traceEventCount()) + "\r\n");
+    else return Resp::error("ERR syntax error");
+    return Resp::simple("OK");
+#else
+    (void)cmd;
+    return Resp::error("ERR tracing is not compiled in, rebuild with -DMINIREDIS_TRACE");
+#endif
+}
+
+//把回复追加到客户端的输出缓冲区,只入队不写 socket
+void Server::addReply(Client* c, std::string s) {
+    if (c->closeAsap) return;
+    size_t len = s.size();
+    //正在被内核发送的块不能追加(可能重新分配内存),引用对象的块也不能追加
+    if (c->reply.size() > c->sendingChunks && !c->reply.back().obj &&
+        c->reply.back().buf.size() + len <= REPLY_CHUNK) {
+        c->reply.back().buf += s;
+    } else {
+        c->reply.emplace_back(std::move(s));
+    }
+    c->replyBytes += len;
+
+    if (outputLimitReached(c)) {
+        std::cerr << "client fd=" << c->fd << " output buffer " << c->replyBytes
+                  << " bytes exceeds limit, closing" << std::endl;
+        c->reply.resize(c->sendingChunks);
+        c->replyBytes = 0;
+        for (auto& chunk : c->reply) c->replyBytes += chunk.size();
+        c->replyBytes -= c->reply.empty() ? 0 : c->sentlen;
+        if (c->reply.empty()) c->sentlen = 0;
+        c->closeAsap = true;
+    }
+}
+
+//大字符串:回复里直接引用对象,头和尾的 \r\n 单独成块,值本身不拷贝
+void Server::addReplyObject(Client* c, Object* o) {
+    auto* v = static_cast<SDS*>(o->ptr);
+    addReply(c, "$" + std::to_string(v->len) + "\r\n");
+    if (c->closeAsap) return;
+    c->reply.emplace_back(o);
+    c->replyBytes += v->len;
+    addReply(c, "\r\n");
+}
+
+bool Server::outputLimitReached(Client* c) {
+    const OutputBufferLimit& lim = limits[(int)c->cls];
+    if (lim.hard && c->replyBytes >= lim.hard) return true;
+    if (lim.soft && c->replyBytes >= lim.soft) {
+        time_t now = time(nullptr);
+        if (c->softLimitSince == 0) c->softLimitSince = now;
+        else if (now - c->softLimitSince >= lim.softSeconds) return true;
+    } else {
+        c->softLimitSince = 0;
+    }
+    return false;
+}
+
+//把输出缓冲区头部最多 max 个块填进 iov(第一块跳过已经发出的部分),返回块数
+size_t Server::replyIov(Client* c, iovec* iov, size_t max) {
+    size_t n = 0;
+    for (auto& chunk : c->reply) {
+        if (n == max) break;
+        size_t off = n == 0 ? c->sentlen : 0;
+        iov[n].iov_base = const_cast<char*>(chunk.data()) + off;
+        iov[n].iov_len = chunk.size() - off;
+        n++;
+    }
+    return n;
+}
+
+//非阻塞写:能写多少写多少,写不完留给下一次 EPOLLOUT。
+//用 writev 一次写多个块,引用对象的大值直接从存储的缓冲区发出
+void Server::writeToClient(Client* c) {
+    size_t written = 0;
+    iovec iov[16];
+    while (!c->reply.empty() && written < MAX_WRITE_PER_EVENT) {
+        size_t cnt = replyIov(c, iov, 16);
+        ssize_t n;
+        {
+            TRACE_SCOPE("writev");
+            n = writev(c->fd, iov, cnt);
+        }
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) break;
+            freeClient(c);
+            return;
+        }
+        consumeReply(c, n);
+        written += n;
+    }
+    if (afterReplyWritten(c)) updateEvents(c);
+}
 
-            write(cfd, reply.c_str(), reply.size());
+//从输出缓冲区头部去掉已经发出去的 n 个字节
+void Server::consumeReply(Client* c, size_t n) {
+    c->replyBytes -= n;
+    while (n > 0) {
+        size_t left = c->reply.front().size() - c->sentlen;
+        if (n < left) {
+            c->sentlen += n;
+            break;
         }
+        n -= left;
+        c->reply.pop_front();
+        c->sentlen = 0;
+    }
+}
+
+//一次写完成后的公共处理,客户端被释放时返回 false
+bool Server::afterReplyWritten(Client* c) {
+    if (c->reply.empty() && c->closeAsap) {
+        freeClient(c);
+        return false;
+    }
+    if (c->replyBytes < limits[(int)c->cls].soft) c->softLimitSince = 0;
+
+    //积压降下来了,恢复执行之前暂停的命令
+    if (c->readPaused && c->replyBytes <= REPLY_PAUSE_BYTES / 2) {
+        c->readPaused = false;
+        processInput(c);
+        if (c->closeAsap && c->reply.empty()) {
+            freeClient(c);
+            return false;
+        }
+    }
+    return true;
+}
+
+//根据当前状态决定关心哪些事件:有积压就关心可写,暂停时不再关心可读
+void Server::updateEvents(Client* c) {
+    uint32_t want = 0;
+    if (!c->readPaused) want |= EPOLLIN;
+    if (c->replyBytes > 0) want |= EPOLLOUT;
+    if (want == c->events) return;
+
+    epoll_event ev{};
+    ev.events = want;
+    ev.data.fd = c->fd;
+    epoll_ctl(epfd, c->events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, c->fd, &ev);
+    c->events = want;
+}
 
-        close(cfd);
+void Server::freeClient(Client* c) {
+    unblockClient(c);
+    trackingDisable(c);
+    clientsById.erase(c->id);
+    if (c->idleTimer) timers.cancel(c->idleTimer);
+    c->idleTimer = 0;
+    unblockedClients.erase(std::remove(unblockedClients.begin(), unblockedClients.end(), c), unblockedClients.end());
+    if (backend == IoBackend::Uring) {
+        uringCloseClient(c);
+        return;
     }
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, nullptr);
+    close(c->fd);
+    clients.erase(c->fd);
+    delete c;
+}
+
+//每 CRON_INTERVAL_MS 执行一次的定期任务,执行完把自己重新挂回时间轮
+void Server::serverCron() {
+    lfuUpdateClock();
+    clientsCron();
+    timers.add(monotonicMs() + CRON_INTERVAL_MS, [this] { serverCron(); });
 }
 
+//新连接:分配 id,记下时间,开了空闲超时就挂一个检查定时器
+void Server::trackClient(Client* c) {
+    c->id = nextClientId++;
+    clientsById[c->id] = c;
+    c->lastInteraction = monotonicMs();
+    if (clientTimeout > 0)
+        c->idleTimer = timers.add(c->lastInteraction + clientTimeout * 1000ULL, [this, c] { clientIdleCheck(c); });
+}
+
+//收到数据时不动定时器,只更新 lastInteraction;到点后再看是不是真的空闲了这么久,
+//没有就按最近一次交互重新挂上。阻塞中的客户端只受阻塞命令自己的超时约束
+void Server::clientIdleCheck(Client* c) {
+    c->idleTimer = 0;
+    uint64_t now = monotonicMs();
+    uint64_t deadline = c->lastInteraction + clientTimeout * 1000ULL;
+    if (c->blocked || now < deadline) {
+        uint64_t next = c->blocked ? now + clientTimeout * 1000ULL : deadline;
+        c->idleTimer = timers.add(next, [this, c] { clientIdleCheck(c); });
+        return;
+    }
+    std::cerr << "client fd=" << c->fd << " idle timeout, closing" << std::endl;
+    freeClient(c);
+}
+
+//定期检查:积压一直没降下来的慢客户端,软限制超时后断开
+void Server::clientsCron() {
+    std::vector<Client*> victims;
+    for (auto& [fd, c] : clients) {
+        if (c->replyBytes > 0 && outputLimitReached(c)) victims.push_back(c);
+    }
+    for (Client* c : victims) {
+        std::cerr << "client fd=" << c->fd << " slow consumer, closing" << std::endl;
+        freeClient(c);
+    }
+}
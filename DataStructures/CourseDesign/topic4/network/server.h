@@ -3,14 +3,264 @@
 解析命令
 调用存储引擎*/
 #pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <utility>
+#include <unordered_map>
+#include <ctime>
+#include <cstdint>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include "../storage/storage.h"
+#include "../storage/stream.h"
+#include "networking.h"
+#include "timer.h"
+
+class Uring;
+class Cluster;
+
+static const size_t QUERYBUF_MAX = 1024 * 1024 * 1024;   //请求缓冲区上限
+static const int CRON_INTERVAL_MS = 100;                 //定期任务(慢客户端检查等)的间隔,由时间轮驱动
+static const size_t BIG_ARG = 32 * 1024;                 //不小于它的参数直接读进最终的 SDS
+static const long long PROTO_MAX_BULK_LEN = 512LL * 1024 * 1024;   //单个参数的长度上限
+static const long long PROTO_MAX_MULTIBULK_LEN = 1024 * 1024;      //一条命令的参数个数上限
+
+//网络 I/O 后端:默认 epoll + read/write,高吞吐节点可以选 io_uring
+enum class IoBackend { Epoll, Uring };
+
+//客户端类别,不同类别使用各自的输出缓冲区限制
+enum class ClientClass { Normal = 0, PubSub = 1, Replica = 2 };
+
+//输出缓冲区限制(0 表示不限制):
+//待发送数据超过 hard 立即断开;超过 soft 并持续 softSeconds 秒也断开
+struct OutputBufferLimit {
+    size_t hard;
+    size_t soft;
+    int softSeconds;
+};
+
+//回复块:普通块存放拷贝进来的数据;大值直接引用存储里的字符串对象(持有一份引用计数),
+//发送时用 writev/sendmsg 从对象自己的缓冲区发出,不再拷贝
+struct ReplyChunk {
+    std::string buf;
+    Object* obj = nullptr;
+
+    ReplyChunk() = default;
+    explicit ReplyChunk(std::string s) : buf(std::move(s)) {}
+    explicit ReplyChunk(Object* o) : obj(o) { incrRefCount(o); }
+    ReplyChunk(ReplyChunk&& o) noexcept : buf(std::move(o.buf)), obj(o.obj) { o.obj = nullptr; }
+    ReplyChunk& operator=(ReplyChunk&& o) noexcept {
+        std::swap(buf, o.buf);
+        std::swap(obj, o.obj);
+        return *this;
+    }
+    ~ReplyChunk() { if (obj) decrRefCount(obj); }
+
+    const char* data() const { return obj ? static_cast<SDS*>(obj->ptr)->buf : buf.data(); }
+    size_t size() const { return obj ? static_cast<SDS*>(obj->ptr)->len : buf.size(); }
+};
+
+//一个客户端连接的全部状态
+struct Client {
+    int fd;
+    uint64_t id = 0;                    //连接的唯一编号(CLIENT ID),不复用
+    int resp = 2;                       //协议版本,HELLO 3 之后可以收推送消息
+    int db = 0;                         // SELECT 选中的逻辑库
+    ClientClass cls = ClientClass::Normal;
+    std::string querybuf;               //已读到但还没解析完的请求数据
+    // RESP 数组请求的解析状态,一条命令可以跨多次读取
+    long long multibulklen = 0;         //当前命令还没解析的参数个数,0 表示等待新命令
+    long long bulklen = -1;             //当前参数的长度,-1 表示还没读到 $ 头
+    std::vector<std::string> argv;      //当前命令已经解析出的参数
+    SDS* bigArg = nullptr;              //大参数:知道长度后就分配最终的 SDS,后面的数据直接读进来
+    size_t bigArgRead = 0;              //bigArg 已经读到的字节数
+    int bigArgIndex = -1;               //bigArg 读完后在 argv 中的下标(argv 里对应位置是空串)
+    std::deque<ReplyChunk> reply;       //待发送的回复,按块存放
+    size_t sentlen = 0;                 //reply.front() 已经发出去的字节数
+    size_t replyBytes = 0;              //所有块里还没发出去的总字节数
+    time_t softLimitSince = 0;          //第一次超过 soft 限制的时间,0 表示当前没超
+    uint32_t events = 0;                //当前在 epoll 中注册的事件
+    bool readPaused = false;            //输出积压太多,暂停读取(背压)
+    bool closeAsap = false;             //回复发送完/出错后尽快关闭
+    bool asking = false;                //集群:上一条命令是 ASKING,下一条命令可以访问正在导入的槽
+
+    //阻塞命令(BLPOP/BRPOP/XREAD/XREADGROUP):等待期间不执行后续命令,缓冲区里的命令解除阻塞后再执行;
+    //等的是阻塞时所在库(db)里的 key
+    bool blocked = false;
+    bool blockLeft = true;              //解除阻塞时从列表哪一端弹出
+    //等的是流:XREAD 读 blockStreamIds 里各 key 在给定 ID 之后的消息,XREADGROUP 读 blockGroup 的新消息
+    bool blockStream = false;
+    std::vector<std::pair<std::string, StreamID>> blockStreamIds;
+    size_t blockCount = 0;              //每个流最多读几条,0 表示不限
+    std::string blockGroup;             //空表示是 XREAD
+    std::string blockConsumer;
+    bool blockNoack = false;
+    std::vector<std::pair<std::string, std::list<Client*>::iterator>> blockedOn;  //在各个 key 等待队列里的位置
+    TimerId blockTimer = 0;             //超时定时器,0 表示一直等
+    uint64_t lastInteraction = 0;       //最近一次收到数据的时间(单调时钟毫秒)
+    TimerId idleTimer = 0;              //空闲超时检查(开了 --timeout 才有)
+
+    //客户端缓存失效通知(CLIENT TRACKING)
+    bool tracking = false;
+    bool trackingBcast = false;         //按前缀广播,不记录读过哪些 key
+    bool trackingNoloop = false;        //自己改的 key 不通知自己
+    uint64_t trackingRedirect = 0;      //通知改发给这个客户端,0 表示发给自己
+    std::vector<std::string> trackingPrefixes;    // BCAST 登记的前缀
+    bool subscribedInvalidate = false;  // RESP2 客户端订阅了 __redis__:invalidate,用来接收重定向过来的通知
+
+    // io_uring 后端使用:提交中的请求在完成前不能释放这些内存
+    int inflight = 0;                   //还没完成的 recv/send 请求数
+    bool recvArmed = false;             //多发 recv 是否仍在生效
+    bool pendingSend = false;           //是否已在本轮的待发送列表里
+    size_t sendingChunks = 0;           //reply 前面这么多块正在被内核发送,不能再修改
+    bool closing = false;               //已经从 clients 中摘除,等请求全部完成后释放
+    msghdr msg{};
+    iovec iov[16];
+
+    ~Client() { sdsFree(bigArg); }
+};
+
+//一个监听 socket 及创建它用的选项(接受连接时要按这些选项调整新连接)
+struct Listener {
+    int fd;
+    ListenOptions opts;
+};
 
 //Redis 服务器本体
 class Server {
 public:
     explicit Server(StorageEngine& engine);//把存储引擎传进来,服务器后面所有SET/GET/DEL都是调用这个engine
-    void start(int port);
+    void setOutputBufferLimit(ClientClass cls, const OutputBufferLimit& limit);
+    void setIoBackend(IoBackend b) { backend = b; }
+    //开启集群模式:按槽检查 key 的归属,不归本节点时重定向
+    void setCluster(Cluster* c) { cluster = c; }
+    //空闲超过 seconds 秒的客户端断开,0 表示不限制
+    void setClientTimeout(int seconds) { clientTimeout = seconds; }
+    // TRACE DUMP 只往这个目录里写
+    void setTraceDir(const std::string& dir) { traceDir = dir; }
+    //在所有给定地址上监听并进入事件循环;任何一个监听失败都返回 false
+    bool start(const std::vector<ListenOptions>& listenOpts);
+    bool start(int port);
 
 private:
+    void runEpoll();
+    void runUring();
+    void acceptClients(const Listener& l);
+    void readFromClient(Client* c);
+    void writeToClient(Client* c);
+    void feedInput(Client* c, const char* data, size_t n);
+    void processInput(Client* c);
+    int parseRequest(Client* c, size_t& pos);
+    void execute(Client* c, const std::vector<std::string>& cmd);
+    void addReply(Client* c, std::string s);
+    void addReplyObject(Client* c, Object* o);
+    size_t replyIov(Client* c, iovec* iov, size_t max);
+    void consumeReply(Client* c, size_t n);
+    bool afterReplyWritten(Client* c);
+    bool outputLimitReached(Client* c);
+    void updateEvents(Client* c);
+    void freeClient(Client* c);
+    void serverCron();
+    void clientsCron();
+    void trackClient(Client* c);
+    void clientIdleCheck(Client* c);
+
+    //集群
+    bool clusterRedirect(Client* c, const std::string& name, const std::vector<std::string>& cmd);
+    std::string clusterCommand(const std::vector<std::string>& cmd);
+    std::string migrateCommand(const std::vector<std::string>& cmd);
+
+    //流
+    std::string xaddCommand(Client* c, const std::vector<std::string>& cmd);
+    std::string xrangeCommand(const std::vector<std::string>& cmd, bool reverse);
+    std::string xdelCommand(const std::vector<std::string>& cmd);
+    std::string xtrimCommand(const std::vector<std::string>& cmd);
+    std::string xgroupCommand(const std::vector<std::string>& cmd);
+    std::string xackCommand(const std::vector<std::string>& cmd);
+    std::string xpendingCommand(const std::vector<std::string>& cmd);
+    std::string xinfoCommand(const std::vector<std::string>& cmd);
+    std::string xreadCommand(Client* c, const std::vector<std::string>& cmd, bool group);
+    bool serveStreamWaiter(Client* c, const std::string& key);
+
+    //有序集合和 GEO
+    std::string zaddCommand(const std::vector<std::string>& cmd, bool incrby);
+    std::string zremCommand(const std::vector<std::string>& cmd);
+    std::string zscoreCommand(const std::vector<std::string>& cmd);
+    std::string zrankCommand(const std::vector<std::string>& cmd, bool reverse);
+    std::string zrangeCommand(const std::vector<std::string>& cmd, bool reverse);
+    std::string zrangebyscoreCommand(const std::vector<std::string>& cmd, bool reverse);
+    std::string zcountCommand(const std::vector<std::string>& cmd);
+    std::string geoaddCommand(const std::vector<std::string>& cmd);
+    std::string geoposCommand(const std::vector<std::string>& cmd);
+    std::string geodistCommand(const std::vector<std::string>& cmd);
+    std::string geohashCommand(const std::vector<std::string>& cmd);
+    std::string geosearchCommand(const std::vector<std::string>& cmd);
+
+    //键空间
+    std::string infoCommand(const std::string& section);
+    std::string scanCommand(const std::vector<std::string>& cmd);
+    std::string keysCommand(const std::string& pattern);
+    std::string keyindexCommand(const std::vector<std::string>& cmd);
+    std::string selectCommand(Client* c, const std::vector<std::string>& cmd);
+    std::string swapdbCommand(const std::vector<std::string>& cmd);
+    std::string flushCommand(const std::vector<std::string>& cmd, bool all);
+
+    //热路径追踪(storage/trace.h),编译时没开 MINIREDIS_TRACE 只会报错
+    std::string traceCommand(const std::vector<std::string>& cmd);
+
+    //客户端缓存失效通知
+    std::string clientCommand(Client* c, const std::vector<std::string>& cmd);
+    std::string helloCommand(Client* c, const std::vector<std::string>& cmd);
+    std::string subscribeCommand(Client* c, const std::vector<std::string>& cmd);
+    void trackingRememberKeys(Client* c, const std::string& name, const std::vector<std::string>& cmd);
+    void trackingInvalidateKey(const std::string& key);
+    void trackingBroadcastInvalidations();
+    void trackingDisable(Client* c);
+    void trackingInvalidateAll();
+    void sendInvalidation(Client* c, const std::string& keys);
+    void wakeClient(Client* c);
+
+    //阻塞命令
+    void blockingPopCommand(Client* c, const std::vector<std::string>& cmd, bool left);
+    void blockClient(Client* c, const std::vector<std::string>& keys, uint64_t timeoutMs);
+    void unblockClient(Client* c);
+    void signalKeyAsReady(int db, const std::string& key);
+    void handleClientsBlockedOnKeys();
+    void processUnblockedClients();
+
+    // io_uring 后端
+    void uringHandleCqe(const struct io_uring_cqe* cqe);
+    void uringArmRecv(Client* c);
+    void uringFlushSends();
+    void uringCloseClient(Client* c);
+
     StorageEngine& engine;
+    std::vector<Listener> listeners;
+    int epfd = -1;
+    std::unordered_map<int, Client*> clients;
+    OutputBufferLimit limits[3];
+    IoBackend backend = IoBackend::Epoll;
+    Uring* ring = nullptr;
+    std::vector<int> pendingSends;      // io_uring:本轮有新回复、需要提交 send 的客户端
+    Cluster* cluster = nullptr;
+    TimerWheel timers;                  //所有定时任务:cron、客户端空闲超时、阻塞命令超时
+    int clientTimeout = 0;
+    std::string traceDir = ".";
+    //每个库一张表:key -> 按阻塞先后排队的客户端
+    std::vector<std::unordered_map<std::string, std::list<Client*>>> blockingKeys;
+    std::vector<std::pair<int, std::string>> readyKeys;     //刚被写入、可能让等待的客户端解除阻塞的 (库, key)
+    std::vector<Client*> unblockedClients;  //刚解除阻塞的客户端,事件循环里接着处理它们缓冲的命令
+    uint64_t nextClientId = 1;
+    uint64_t currentClientId = 0;       //正在执行命令的客户端,NOLOOP 用
+    std::unordered_map<uint64_t, Client*> clientsById;
+    //默认模式的失效表:key 的 64 位哈希 -> 读过它的客户端 id。不存 key 本身,哈希冲突只会多发通知
+    std::unordered_map<uint64_t, std::vector<uint64_t>> trackingTable;
+    // BCAST 模式:前缀 -> 登记的客户端,以及本轮事件循环里被修改的匹配 key(和修改者 id)
+    struct BcastPrefix {
+        std::vector<uint64_t> clients;
+        std::vector<std::pair<std::string, uint64_t>> keys;
+    };
+    std::unordered_map<std::string, BcastPrefix> bcastPrefixes;
 };
@@ -0,0 +1,139 @@
+/*阻塞命令:BLPOP/BRPOP 在所有 key 都为空时让客户端挂起,XREAD/XREADGROUP BLOCK 等流里有新消息。
+每个 key 一条 FIFO 等待队列,客户端记住自己在各队列里的位置,解除阻塞时 O(1) 摘除;
+写入列表或流的命令把 key 标记为就绪,命令执行完后按先来先服务把新元素分给等待的客户端;
+超时交给时间轮,不需要轮询*/
+#include "server.h"
+#include "resp.h"
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+static const char* WRONGTYPE = "WRONGTYPE Operation against a key holding the wrong kind of value";
+
+// BLPOP key [key ...] timeout,timeout 以秒为单位,可以是小数,0 表示一直等
+void Server::blockingPopCommand(Client* c, const std::vector<std::string>& cmd, bool left) {
+    char* end;
+    double timeout = strtod(cmd.back().c_str(), &end);
+    if (cmd.back().empty() || *end || !std::isfinite(timeout)) {
+        addReply(c, Resp::error("ERR timeout is not a float or out of range"));
+        return;
+    }
+    if (timeout < 0) {
+        addReply(c, Resp::error("ERR timeout is negative"));
+        return;
+    }
+    std::vector<std::string> keys(cmd.begin() + 1, cmd.end() - 1);
+    for (auto& k : keys) {
+        if (!engine.checkType(k, OBJ_LIST)) {
+            addReply(c, Resp::error(WRONGTYPE));
+            return;
+        }
+    }
+    //有非空的 key 就和 LPOP/RPOP 一样直接返回
+    for (auto& k : keys) {
+        if (auto v = engine.pop(k, left)) {
+            addReply(c, Resp::arrayHeader(2) + Resp::bulk(k) + Resp::bulk(*v));
+            return;
+        }
+    }
+
+    c->blockLeft = left;
+    c->blockStream = false;
+    blockClient(c, keys, (uint64_t)std::ceil(timeout * 1000));
+}
+
+//在 keys 的等待队列里排队,timeoutMs 为 0 表示一直等;等的是什么由调用方事先记在 Client 里
+void Server::blockClient(Client* c, const std::vector<std::string>& keys, uint64_t timeoutMs) {
+    c->blocked = true;
+    for (auto& k : keys) {
+        auto& waiters = blockingKeys[c->db][k];
+        //同一个 key 写了两次只排一次队
+        bool queued = false;
+        for (auto& b : c->blockedOn) queued = queued || b.first == k;
+        if (queued) continue;
+        waiters.push_back(c);
+        c->blockedOn.emplace_back(k, std::prev(waiters.end()));
+    }
+    if (timeoutMs > 0) {
+        c->blockTimer = timers.add(monotonicMs() + timeoutMs, [this, c] {
+            c->blockTimer = 0;
+            unblockClient(c);
+            addReply(c, Resp::nullArray());
+            unblockedClients.push_back(c);
+        });
+    }
+}
+
+//把客户端从所有等待队列里摘掉并取消超时;没有阻塞时什么也不做
+void Server::unblockClient(Client* c) {
+    if (!c->blocked) return;
+    auto& keys = blockingKeys[c->db];
+    for (auto& [key, pos] : c->blockedOn) {
+        auto it = keys.find(key);
+        it->second.erase(pos);
+        if (it->second.empty()) keys.erase(it);
+    }
+    c->blockedOn.clear();
+    if (c->blockTimer) timers.cancel(c->blockTimer);
+    c->blockTimer = 0;
+    c->blocked = false;
+}
+
+void Server::signalKeyAsReady(int db, const std::string& key) {
+    if (!blockingKeys[db].count(key)) return;
+    std::pair<int, std::string> k(db, key);
+    if (std::find(readyKeys.begin(), readyKeys.end(), k) == readyKeys.end()) readyKeys.push_back(std::move(k));
+}
+
+//按排队顺序给等待的客户端分配元素:等列表的每人弹一个,直到列表空了;
+//等流的只要有比它的 ID 新的消息就都能读到,互不影响
+void Server::handleClientsBlockedOnKeys() {
+    std::vector<std::pair<int, std::string>> keys;
+    keys.swap(readyKeys);
+    for (auto& [db, key] : keys) {
+        engine.select(db);
+        auto it = blockingKeys[db].find(key);
+        if (it == blockingKeys[db].end()) continue;
+        //服务过的客户端会从队列里摘掉,先拷一份
+        std::vector<Client*> waiters(it->second.begin(), it->second.end());
+        bool listEmpty = false;
+        for (Client* c : waiters) {
+            if (c->blockStream) {
+                if (!serveStreamWaiter(c, key)) continue;
+            } else {
+                if (listEmpty) continue;
+                auto v = engine.pop(key, c->blockLeft);
+                if (!v) {
+                    listEmpty = true;
+                    continue;
+                }
+                addReply(c, Resp::arrayHeader(2) + Resp::bulk(key) + Resp::bulk(*v));
+            }
+            unblockClient(c);
+            unblockedClients.push_back(c);
+        }
+    }
+}
+
+//解除阻塞的客户端:发出回复,并继续执行阻塞期间缓冲下来的命令(这些命令又可能唤醒别的客户端)
+void Server::processUnblockedClients() {
+    while (!unblockedClients.empty()) {
+        Client* c = unblockedClients.front();
+        unblockedClients.erase(unblockedClients.begin());
+        processInput(c);
+        if (c->closeAsap && c->reply.empty()) {
+            freeClient(c);
+            continue;
+        }
+        if (backend == IoBackend::Uring) {
+            if (c->replyBytes > 0 && !c->pendingSend) {
+                c->pendingSend = true;
+                pendingSends.push_back(c->fd);
+            }
+        } else if (c->replyBytes > 0) {
+            writeToClient(c);
+        } else {
+            updateEvents(c);
+        }
+    }
+}
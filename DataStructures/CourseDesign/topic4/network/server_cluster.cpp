@@ -0,0 +1,339 @@
+//集群模式:请求重定向、CLUSTER 命令、MIGRATE
+#include "server.h"
+#include "cluster.h"
+#include "resp.h"
+#include <unistd.h>
+#include <strings.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+//命令里所有 key 所在的参数下标,没有 key 返回空
+static std::vector<size_t> commandKeys(const std::string& name, const std::vector<std::string>& cmd) {
+    static const char* keyed[] = {"SET", "GET", "DEL", "HSET", "HGET", "HDEL", "HLEN", "HEXISTS", "HGETALL",
+                                  "PFADD", "RESTORE", "BF.RESERVE", "BF.ADD", "BF.MADD", "BF.EXISTS", "BF.MEXISTS",
+                                  "LPUSH", "RPUSH", "LPOP", "RPOP", "LLEN", "LRANGE", "TYPE",
+                                  "XADD", "XLEN", "XRANGE", "XREVRANGE", "XDEL", "XTRIM", "XACK", "XPENDING",
+                                  "ZADD", "ZINCRBY", "ZREM", "ZSCORE", "ZCARD", "ZRANK", "ZREVRANK", "ZRANGE",
+                                  "ZREVRANGE", "ZRANGEBYSCORE", "ZREVRANGEBYSCORE", "ZCOUNT",
+                                  "GEOADD", "GEOPOS", "GEODIST", "GEOHASH", "GEOSEARCH"};
+    std::vector<size_t> keys;
+    //PFCOUNT k1 k2 ...、PFMERGE dest src ...:后面全是 key
+    if (name == "PFCOUNT" || name == "PFMERGE") {
+        for (size_t i = 1; i < cmd.size(); i++) keys.push_back(i);
+        return keys;
+    }
+    // XREAD/XREADGROUP ... STREAMS k1 k2 ... id1 id2 ...:STREAMS 之后前一半是 key。
+    //格式不对时不算 key,交给命令自己报语法错误
+    if (name == "XREAD" || name == "XREADGROUP") {
+        size_t i = 1;
+        while (i < cmd.size() && strcasecmp(cmd[i].c_str(), "STREAMS")) i++;
+        size_t rest = i < cmd.size() ? cmd.size() - i - 1 : 0;
+        if (rest && rest % 2 == 0)
+            for (size_t k = 0; k < rest / 2; k++) keys.push_back(i + 1 + k);
+        return keys;
+    }
+    //BLPOP k1 k2 ... timeout
+    if (name == "BLPOP" || name == "BRPOP") {
+        for (size_t i = 1; i + 1 < cmd.size(); i++) keys.push_back(i);
+        return keys;
+    }
+    size_t ki = 0;
+    for (const char* k : keyed)
+        if (name == k) ki = 1;
+    if (name == "OBJECT" || name == "XGROUP" || name == "XINFO") ki = 2;
+    if (ki && ki < cmd.size()) keys.push_back(ki);
+    return keys;
+}
+
+static std::string nodeAddr(const ClusterNode& n) {
+    return n.host + ":" + std::to_string(n.port);
+}
+
+//槽不归本节点时回复 MOVED;本节点正在迁出这个槽、而 key 已经不在本地时回复 ASK。
+//目标节点只在客户端先发了 ASKING 的情况下执行正在导入的槽上的命令
+bool Server::clusterRedirect(Client* c, const std::string& name, const std::vector<std::string>& cmd) {
+    std::vector<size_t> keys = commandKeys(name, cmd);
+    if (keys.empty()) return false;
+    //多 key 命令的 key 必须在同一个槽,否则读到的是本节点不完整的数据
+    int slot = keyHashSlot(cmd[keys[0]].data(), cmd[keys[0]].size());
+    for (size_t i = 1; i < keys.size(); i++) {
+        if (keyHashSlot(cmd[keys[i]].data(), cmd[keys[i]].size()) != slot) {
+            addReply(c, Resp::error("CROSSSLOT Keys in request don't hash to the same slot"));
+            return true;
+        }
+    }
+    int owner = cluster->slotOwner(slot);
+    if (owner < 0) {
+        addReply(c, Resp::error("CLUSTERDOWN Hash slot not served"));
+        return true;
+    }
+    if (owner == cluster->myself()) {
+        int target = cluster->migratingTo(slot);
+        if (target < 0) return false;
+        //迁移中:key 全都不在了才让客户端去目标节点;只走了一部分时哪边都不完整,让客户端稍后重试
+        size_t missing = 0;
+        for (size_t ki : keys) missing += !engine.exists(cmd[ki]);
+        if (missing == 0) return false;
+        if (missing == keys.size())
+            addReply(c, Resp::error("ASK " + std::to_string(slot) + " " + nodeAddr(cluster->node(target))));
+        else
+            addReply(c, Resp::error("TRYAGAIN Multiple keys request during rehashing of slot"));
+        return true;
+    }
+    if (c->asking && cluster->importingFrom(slot) >= 0) return false;
+    addReply(c, Resp::error("MOVED " + std::to_string(slot) + " " + nodeAddr(cluster->node(owner))));
+    return true;
+}
+
+static bool parseSlot(const std::string& s, int& slot) {
+    char* end;
+    long v = strtol(s.c_str(), &end, 10);
+    if (s.empty() || *end || v < 0 || v >= CLUSTER_SLOTS) return false;
+    slot = v;
+    return true;
+}
+
+std::string Server::clusterCommand(const std::vector<std::string>& cmd) {
+    if (!cluster) return Resp::error("ERR This instance has cluster support disabled");
+    if (cmd.size() < 2) return Resp::error("ERR wrong number of arguments for 'cluster' command");
+    const char* sub = cmd[1].c_str();
+    int slot;
+
+    if (!strcasecmp(sub, "MYID")) return Resp::bulk(cluster->node(cluster->myself()).id);
+
+    if (!strcasecmp(sub, "KEYSLOT") && cmd.size() == 3)
+        return Resp::integer(keyHashSlot(cmd[2].data(), cmd[2].size()));
+
+    if (!strcasecmp(sub, "COUNTKEYSINSLOT") && cmd.size() == 3) {
+        if (!parseSlot(cmd[2], slot)) return Resp::error("ERR Invalid slot");
+        return Resp::integer(engine.countKeysInSlot(slot));
+    }
+
+    if (!strcasecmp(sub, "GETKEYSINSLOT") && cmd.size() == 4) {
+        long long count = atoll(cmd[3].c_str());
+        if (!parseSlot(cmd[2], slot) || count < 0) return Resp::error("ERR Invalid slot or number of keys");
+        auto keys = engine.getKeysInSlot(slot, count);
+        std::string reply = Resp::arrayHeader(keys.size());
+        for (auto& k : keys) reply += Resp::bulk(k);
+        return reply;
+    }
+
+    //连续且属于同一节点的槽合并成一段:[起始, 结束, [host, port, id]]
+    if (!strcasecmp(sub, "SLOTS")) {
+        std::string body;
+        size_t ranges = 0;
+        for (int s = 0; s < CLUSTER_SLOTS; ) {
+            int owner = cluster->slotOwner(s), e = s;
+            while (e + 1 < CLUSTER_SLOTS && cluster->slotOwner(e + 1) == owner) e++;
+            if (owner >= 0) {
+                const ClusterNode& n = cluster->node(owner);
+                body += Resp::arrayHeader(3) + Resp::integer(s) + Resp::integer(e);
+                body += Resp::arrayHeader(3) + Resp::bulk(n.host) + Resp::integer(n.port) + Resp::bulk(n.id);
+                ranges++;
+            }
+            s = e + 1;
+        }
+        return Resp::arrayHeader(ranges) + body;
+    }
+
+    //与 Redis 的 CLUSTER NODES 格式相同,没有的字段(集群总线端口、epoch 等)填 0
+    if (!strcasecmp(sub, "NODES")) {
+        std::string out;
+        const auto& nodes = cluster->allNodes();
+        for (size_t i = 0; i < nodes.size(); i++) {
+            out += nodes[i].id + " " + nodeAddr(nodes[i]) + "@0 " +
+                   ((int)i == cluster->myself() ? "myself,master" : "master") + " - 0 0 0 connected";
+            for (int s = 0; s < CLUSTER_SLOTS; ) {
+                if (cluster->slotOwner(s) != (int)i) { s++; continue; }
+                int e = s;
+                while (e + 1 < CLUSTER_SLOTS && cluster->slotOwner(e + 1) == (int)i) e++;
+                out += " " + std::to_string(s) + (e > s ? "-" + std::to_string(e) : "");
+                s = e + 1;
+            }
+            for (int s = 0; s < CLUSTER_SLOTS; s++) {
+                if ((int)i != cluster->myself()) break;
+                if (cluster->migratingTo(s) >= 0)
+                    out += " [" + std::to_string(s) + "->-" + cluster->node(cluster->migratingTo(s)).id + "]";
+                if (cluster->importingFrom(s) >= 0)
+                    out += " [" + std::to_string(s) + "-<-" + cluster->node(cluster->importingFrom(s)).id + "]";
+            }
+            out += "\n";
+        }
+        return Resp::bulk(out);
+    }
+
+    // CLUSTER SETSLOT <slot> IMPORTING|MIGRATING|NODE <id> / STABLE
+    if (!strcasecmp(sub, "SETSLOT") && cmd.size() >= 4) {
+        if (!parseSlot(cmd[2], slot)) return Resp::error("ERR Invalid slot");
+        const char* action = cmd[3].c_str();
+        if (!strcasecmp(action, "STABLE") && cmd.size() == 4) {
+            cluster->setStable(slot);
+            return Resp::simple("OK");
+        }
+        if (cmd.size() != 5) return Resp::error("ERR syntax error");
+        int node = cluster->findNode(cmd[4]);
+        if (node < 0) return Resp::error("ERR I don't know about node " + cmd[4]);
+        if (!strcasecmp(action, "MIGRATING")) {
+            if (cluster->slotOwner(slot) != cluster->myself())
+                return Resp::error("ERR I'm not the owner of hash slot " + cmd[2]);
+            cluster->setMigrating(slot, node);
+        } else if (!strcasecmp(action, "IMPORTING")) {
+            if (cluster->slotOwner(slot) == cluster->myself())
+                return Resp::error("ERR I'm already the owner of hash slot " + cmd[2]);
+            cluster->setImporting(slot, node);
+        } else if (!strcasecmp(action, "NODE")) {
+            //迁出方在槽里还有 key 时不能交出槽,否则这些 key 就丢了
+            if (cluster->slotOwner(slot) == cluster->myself() && node != cluster->myself() &&
+                engine.countKeysInSlot(slot) > 0)
+                return Resp::error("ERR Can't assign hashslot " + cmd[2] + " to a different node while I still hold keys for this hash slot.");
+            cluster->setSlotNode(slot, node);
+        } else {
+            return Resp::error("ERR Invalid CLUSTER SETSLOT action or number of arguments");
+        }
+        return Resp::simple("OK");
+    }
+    return Resp::error("ERR Unknown subcommand or wrong number of arguments for '" + cmd[1] + "'");
+}
+
+//解析 buf 里的一条 RESP 回复(+ - : $ *):返回 1 表示完整(consumed 为它的字节数),
+//0 表示还没收全,-1 表示格式错误;错误回复的内容放进 err
+static int parseReply(const char* buf, size_t len, size_t& consumed, std::string& err) {
+    const char* eol = (const char*)memmem(buf, len, "\r\n", 2);
+    if (!eol) return 0;
+    size_t head = eol - buf + 2;
+    switch (buf[0]) {
+    case '+':
+    case ':':
+        consumed = head;
+        return 1;
+    case '-':
+        if (err.empty()) err.assign(buf + 1, eol - buf - 1);
+        consumed = head;
+        return 1;
+    case '$': {
+        long long n = atoll(buf + 1);
+        if (n < 0) {
+            consumed = head;
+            return 1;
+        }
+        if (len < head + n + 2) return 0;
+        consumed = head + n + 2;
+        return 1;
+    }
+    case '*': {
+        long long n = atoll(buf + 1);
+        size_t pos = head;
+        for (long long i = 0; i < n; i++) {
+            size_t c;
+            int r = parseReply(buf + pos, len - pos, c, err);
+            if (r != 1) return r;
+            pos += c;
+        }
+        consumed = pos;
+        return 1;
+    }
+    default:
+        return -1;
+    }
+}
+
+//等 fd 可读/可写,最多等到 deadline
+static bool waitFd(int fd, short events, std::chrono::steady_clock::time_point deadline) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    if (left <= 0) return false;
+    pollfd p{fd, events, 0};
+    return poll(&p, 1, (int)left) == 1;
+}
+
+//读满 n 条回复,中间任何一条是错误回复都算失败;多行的 bulk 回复按长度读完整
+static bool readReplies(int fd, size_t n, std::chrono::steady_clock::time_point deadline, std::string& err) {
+    std::string buf, replyErr;
+    char tmp[4096];
+    size_t pos = 0;
+    while (n > 0) {
+        size_t consumed;
+        int r = pos < buf.size() ? parseReply(buf.data() + pos, buf.size() - pos, consumed, replyErr) : 0;
+        if (r < 0) {
+            err = "IOERR protocol error reading from target instance";
+            return false;
+        }
+        if (r == 1) {
+            pos += consumed;
+            n--;
+            continue;
+        }
+        ssize_t got = waitFd(fd, POLLIN, deadline) ? read(fd, tmp, sizeof(tmp)) : -1;
+        if (got <= 0) {
+            err = "IOERR error or timeout reading from target instance";
+            return false;
+        }
+        buf.append(tmp, got);
+    }
+    if (!replyErr.empty()) {
+        err = "Target instance replied with error: " + replyErr;
+        return false;
+    }
+    return true;
+}
+
+// MIGRATE host port key|"" destination-db timeout [KEYS key ...]
+//同步执行:连接目标节点,用 ASKING + 重建命令把 key 写过去,全部成功后删除本地的 key
+std::string Server::migrateCommand(const std::vector<std::string>& cmd) {
+    if (cmd.size() < 6) return Resp::error("ERR wrong number of arguments for 'migrate' command");
+    std::vector<std::string> keys;
+    if (!cmd[3].empty()) keys.push_back(cmd[3]);
+    for (size_t i = 6; i < cmd.size(); i++) {
+        if (!strcasecmp(cmd[i].c_str(), "KEYS") && cmd[3].empty()) {
+            keys.insert(keys.end(), cmd.begin() + i + 1, cmd.end());
+            break;
+        }
+        return Resp::error("ERR syntax error");
+    }
+    int timeout = atoi(cmd[5].c_str());
+    if (timeout <= 0) timeout = 1000;
+
+    std::string out;
+    size_t replies = 0;
+    std::vector<std::string> moved;
+    for (auto& k : keys) {
+        auto cmds = engine.rebuildCommands(k);
+        if (cmds.empty()) {
+            //还没有重建办法的类型不能当作不存在跳过,否则 key 留在本地,槽永远交不出去
+            if (engine.exists(k)) return Resp::error("ERR cannot migrate key '" + k + "': unsupported type");
+            continue;
+        }
+        //ASKING 只对紧跟的一条命令有效
+        for (auto& c : cmds) {
+            out += Resp::command({"ASKING"}) + Resp::command(c);
+            replies += 2;
+        }
+        moved.push_back(k);
+    }
+    if (moved.empty()) return Resp::simple("NOKEY");
+
+    int fd = connectTcp(cmd[1], atoi(cmd[2].c_str()), timeout);
+    if (fd < 0) return Resp::error("IOERR error or timeout connecting to the client");
+    //timeout 限制整次迁移(写完所有命令并收齐回复),不是单次读写
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    std::string err;
+    bool ok = true;
+    for (size_t off = 0; off < out.size(); ) {
+        //目标节点中途断开时 send 返回 EPIPE,不能让 SIGPIPE 杀掉整个进程
+        ssize_t w = waitFd(fd, POLLOUT, deadline) ? send(fd, out.data() + off, out.size() - off, MSG_NOSIGNAL) : -1;
+        if (w <= 0) {
+            ok = false;
+            err = "IOERR error or timeout writing to target instance";
+            break;
+        }
+        off += w;
+    }
+    //全部回复收齐且没有错误才删除本地的 key
+    if (ok) ok = readReplies(fd, replies, deadline, err);
+    close(fd);
+    if (!ok) return Resp::error(err);
+    for (auto& k : moved) engine.del(k);
+    return Resp::simple("OK");
+}
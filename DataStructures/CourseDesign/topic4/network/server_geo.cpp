@@ -0,0 +1,187 @@
+// GEO:GEOADD/GEOPOS/GEODIST/GEOHASH/GEOSEARCH,位置存在有序集合里(分数是 52 位 geohash)。
+//编码和搜索在 storage/geo.h,这里只做参数解析、单位换算和回复格式
+#include "server.h"
+#include "resp.h"
+#include "../storage/geo.h"
+#include <strings.h>
+#include <cstdlib>
+#include <cstdio>
+
+static const char* WRONGTYPE = "WRONGTYPE Operation against a key holding the wrong kind of value";
+
+//单位换算成米,不认识的单位返回 0
+static double unitFactor(const std::string& unit) {
+    if (!strcasecmp(unit.c_str(), "m")) return 1;
+    if (!strcasecmp(unit.c_str(), "km")) return 1000;
+    if (!strcasecmp(unit.c_str(), "ft")) return 0.3048;
+    if (!strcasecmp(unit.c_str(), "mi")) return 1609.34;
+    return 0;
+}
+
+static std::string unitError() {
+    return Resp::error("ERR unsupported unit provided. please use M, KM, FT, MI");
+}
+
+static bool parseLonLat(const std::string& lonArg, const std::string& latArg, double& lon, double& lat) {
+    return parseScore(lonArg, lon) && parseScore(latArg, lat) && lon >= GEO_LONG_MIN && lon <= GEO_LONG_MAX &&
+           lat >= GEO_LAT_MIN && lat <= GEO_LAT_MAX;
+}
+
+static std::string lonLatError(const std::string& lon, const std::string& lat) {
+    return Resp::error("ERR invalid longitude,latitude pair " + lon + "," + lat);
+}
+
+//距离保留 4 位小数,坐标用 17 位有效数字,和 Redis 一致
+static std::string fixed4(double v) {
+    char buf[64];
+    int n = snprintf(buf, sizeof(buf), "%.4f", v);
+    return std::string(buf, n);
+}
+
+static std::string posReply(double lon, double lat) {
+    return Resp::arrayHeader(2) + Resp::bulk(formatScore(lon)) + Resp::bulk(formatScore(lat));
+}
+
+// GEOADD key [NX|XX] [CH] longitude latitude member [longitude latitude member ...]
+std::string Server::geoaddCommand(const std::vector<std::string>& cmd) {
+    size_t i = 2;
+    std::vector<std::string> zadd = {"ZADD", cmd[1]};
+    while (i < cmd.size() && (!strcasecmp(cmd[i].c_str(), "NX") || !strcasecmp(cmd[i].c_str(), "XX") ||
+                              !strcasecmp(cmd[i].c_str(), "CH")))
+        zadd.push_back(cmd[i++]);
+    if (i == cmd.size() || (cmd.size() - i) % 3) return Resp::error("ERR syntax error");
+    //换算成 ZADD 的参数,之后的选项处理、类型检查都交给 ZADD
+    for (; i < cmd.size(); i += 3) {
+        double lon, lat;
+        uint64_t bits;
+        if (!parseLonLat(cmd[i], cmd[i + 1], lon, lat)) return lonLatError(cmd[i], cmd[i + 1]);
+        geohashEncode(lon, lat, GEO_STEP_MAX, bits);
+        zadd.push_back(std::to_string(bits));
+        zadd.push_back(cmd[i + 2]);
+    }
+    return zaddCommand(zadd, false);
+}
+
+std::string Server::geoposCommand(const std::vector<std::string>& cmd) {
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+    ZSet* z = engine.zsetRead(cmd[1]);
+    std::string r = Resp::arrayHeader(cmd.size() - 2);
+    for (size_t i = 2; i < cmd.size(); i++) {
+        double score, lon, lat;
+        if (!z || !z->score(cmd[i], score)) {
+            r += Resp::nullArray();
+            continue;
+        }
+        geohashDecode((uint64_t)score, GEO_STEP_MAX, lon, lat);
+        r += posReply(lon, lat);
+    }
+    return r;
+}
+
+// GEODIST key member1 member2 [unit]
+std::string Server::geodistCommand(const std::vector<std::string>& cmd) {
+    double factor = cmd.size() == 5 ? unitFactor(cmd[4]) : 1;
+    if (factor == 0) return unitError();
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+    ZSet* z = engine.zsetRead(cmd[1]);
+    double s1, s2, lon1, lat1, lon2, lat2;
+    if (!z || !z->score(cmd[2], s1) || !z->score(cmd[3], s2)) return Resp::nullBulk();
+    geohashDecode((uint64_t)s1, GEO_STEP_MAX, lon1, lat1);
+    geohashDecode((uint64_t)s2, GEO_STEP_MAX, lon2, lat2);
+    return Resp::bulk(fixed4(geoDistance(lon1, lat1, lon2, lat2) / factor));
+}
+
+std::string Server::geohashCommand(const std::vector<std::string>& cmd) {
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+    ZSet* z = engine.zsetRead(cmd[1]);
+    std::string r = Resp::arrayHeader(cmd.size() - 2);
+    for (size_t i = 2; i < cmd.size(); i++) {
+        double score;
+        r += z && z->score(cmd[i], score) ? Resp::bulk(geohashString((uint64_t)score)) : Resp::nullBulk();
+    }
+    return r;
+}
+
+// GEOSEARCH key FROMMEMBER member|FROMLONLAT lon lat BYRADIUS r unit|BYBOX w h unit
+//           [ASC|DESC] [COUNT n [ANY]] [WITHCOORD] [WITHDIST] [WITHHASH]
+//只扫中心格子和 8 个邻居对应的几段分数区间,见 geoSearchRanges
+std::string Server::geosearchCommand(const std::vector<std::string>& cmd) {
+    GeoShape shape;
+    const std::string* fromMember = nullptr;
+    bool hasFrom = false, hasBy = false, desc = false, any = false;
+    bool withCoord = false, withDist = false, withHash = false;
+    long long count = 0;
+    double factor = 1;
+    for (size_t i = 2; i < cmd.size(); i++) {
+        const char* opt = cmd[i].c_str();
+        size_t left = cmd.size() - i - 1;
+        if (!strcasecmp(opt, "FROMMEMBER") && left >= 1 && !hasFrom) {
+            fromMember = &cmd[++i];
+            hasFrom = true;
+        } else if (!strcasecmp(opt, "FROMLONLAT") && left >= 2 && !hasFrom) {
+            if (!parseLonLat(cmd[i + 1], cmd[i + 2], shape.lon, shape.lat)) return lonLatError(cmd[i + 1], cmd[i + 2]);
+            i += 2;
+            hasFrom = true;
+        } else if (!strcasecmp(opt, "BYRADIUS") && left >= 2 && !hasBy) {
+            if (!parseScore(cmd[i + 1], shape.radius) || shape.radius < 0) return Resp::error("ERR need numeric radius");
+            if ((factor = unitFactor(cmd[i + 2])) == 0) return unitError();
+            shape.radius *= factor;
+            i += 2;
+            hasBy = true;
+        } else if (!strcasecmp(opt, "BYBOX") && left >= 3 && !hasBy) {
+            if (!parseScore(cmd[i + 1], shape.width) || !parseScore(cmd[i + 2], shape.height) ||
+                shape.width < 0 || shape.height < 0)
+                return Resp::error("ERR need numeric width and height");
+            if ((factor = unitFactor(cmd[i + 3])) == 0) return unitError();
+            shape.box = true;
+            shape.width *= factor;
+            shape.height *= factor;
+            i += 3;
+            hasBy = true;
+        } else if (!strcasecmp(opt, "ASC")) {
+            desc = false;
+        } else if (!strcasecmp(opt, "DESC")) {
+            desc = true;
+        } else if (!strcasecmp(opt, "COUNT") && left >= 1) {
+            count = atoll(cmd[++i].c_str());
+            if (count <= 0) return Resp::error("ERR COUNT must be > 0");
+            if (i + 1 < cmd.size() && !strcasecmp(cmd[i + 1].c_str(), "ANY")) {
+                any = true;
+                i++;
+            }
+        } else if (!strcasecmp(opt, "WITHCOORD")) {
+            withCoord = true;
+        } else if (!strcasecmp(opt, "WITHDIST")) {
+            withDist = true;
+        } else if (!strcasecmp(opt, "WITHHASH")) {
+            withHash = true;
+        } else {
+            return Resp::error("ERR syntax error");
+        }
+    }
+    if (!hasFrom) return Resp::error("ERR exactly one of FROMMEMBER or FROMLONLAT can be specified for GEOSEARCH");
+    if (!hasBy) return Resp::error("ERR exactly one of BYRADIUS and BYBOX can be specified for GEOSEARCH");
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+    ZSet* z = engine.zsetRead(cmd[1]);
+    if (!z) return Resp::arrayHeader(0);
+    if (fromMember) {
+        double score;
+        if (!z->score(*fromMember, score)) return Resp::error("ERR could not decode requested zset member");
+        geohashDecode((uint64_t)score, GEO_STEP_MAX, shape.lon, shape.lat);
+    }
+
+    auto found = geoSearch(*z, shape, desc, count, any);
+    size_t extra = withCoord + withDist + withHash;
+    std::string r = Resp::arrayHeader(found.size());
+    for (auto& g : found) {
+        if (!extra) {
+            r += Resp::bulk(g.member);
+            continue;
+        }
+        r += Resp::arrayHeader(1 + extra) + Resp::bulk(g.member);
+        if (withDist) r += Resp::bulk(fixed4(g.dist / factor));
+        if (withHash) r += Resp::integer(g.hash);
+        if (withCoord) r += posReply(g.lon, g.lat);
+    }
+    return r;
+}
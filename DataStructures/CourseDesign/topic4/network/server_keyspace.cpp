@@ -0,0 +1,200 @@
+//键空间:INFO、SCAN、KEYS、KEYINDEX,以及多库命令 SELECT/SWAPDB/FLUSHDB/FLUSHALL
+#include "server.h"
+#include "resp.h"
+#include "glob.h"
+#include <strings.h>
+#include <cstdlib>
+
+// INFO [stats|keyspace],不带参数时两段都给
+std::string Server::infoCommand(const std::string& section) {
+    bool all = section.empty() || !strcasecmp(section.c_str(), "all") || !strcasecmp(section.c_str(), "default");
+    std::string out;
+    if (all || !strcasecmp(section.c_str(), "stats")) {
+        out += "# Stats\r\n";
+        out += "connected_clients:" + std::to_string(clients.size()) + "\r\n";
+        out += "keyspace_hits:" + std::to_string(engine.keyspaceHits()) + "\r\n";
+        out += "keyspace_misses:" + std::to_string(engine.keyspaceMisses()) + "\r\n";
+        out += "lazyfree_pending_objects:" + std::to_string(engine.lazyfreePending()) + "\r\n";
+        if (engine.keyIndexEnabled())
+            out += "keyindex_bytes:" + std::to_string(engine.keyIndexBytes()) + "\r\n";
+    }
+    if (all || !strcasecmp(section.c_str(), "keyspace")) {
+        if (!out.empty()) out += "\r\n";
+        out += "# Keyspace\r\n";
+        //没有过期时间,expires 和 avg_ttl 总是 0,保留字段是为了和 Redis 的格式兼容
+        for (int id = 0; id < engine.dbCount(); id++) {
+            if (size_t n = engine.dbsize(id))
+                out += "db" + std::to_string(id) + ":keys=" + std::to_string(n) + ",expires=0,avg_ttl=0\r\n";
+        }
+    }
+    return Resp::bulk(out);
+}
+
+// SCAN cursor [MATCH pattern] [COUNT count] [TYPE type]
+std::string Server::scanCommand(const std::vector<std::string>& cmd) {
+    char* end;
+    unsigned long long cursor = strtoull(cmd[1].c_str(), &end, 10);
+    if (cmd[1].empty() || *end) return Resp::error("ERR invalid cursor");
+    const std::string* pattern = nullptr;
+    long long count = 10;
+    int type = -1;
+    for (size_t i = 2; i < cmd.size(); i += 2) {
+        if (i + 1 >= cmd.size()) return Resp::error("ERR syntax error");
+        const char* opt = cmd[i].c_str();
+        if (!strcasecmp(opt, "MATCH")) {
+            pattern = &cmd[i + 1];
+        } else if (!strcasecmp(opt, "COUNT")) {
+            count = atoll(cmd[i + 1].c_str());
+            if (count < 1) return Resp::error("ERR syntax error");
+        } else if (!strcasecmp(opt, "TYPE")) {
+            for (int t = OBJ_STRING; t <= OBJ_ZSET; t++)
+                if (!strcasecmp(cmd[i + 1].c_str(), typeName(t))) type = t;
+            //未知类型什么都匹配不上,和 Redis 一样照常返回游标
+            if (type < 0) type = 255;
+        } else {
+            return Resp::error("ERR syntax error");
+        }
+    }
+    std::vector<std::string> keys;
+    size_t next = engine.scan(cursor, count, keys, type);
+    std::string body;
+    size_t n = 0;
+    for (auto& k : keys) {
+        //* 匹配一切,不用逐个比较
+        if (pattern && *pattern != "*" && !globMatch(pattern->data(), pattern->size(), k.data(), k.size())) continue;
+        body += Resp::bulk(k);
+        n++;
+    }
+    return Resp::arrayHeader(2) + Resp::bulk(std::to_string(next)) + Resp::arrayHeader(n) + body;
+}
+
+// KEYS pattern:模式里第一个通配符之前的部分是字面前缀,先按前缀从 key 索引里取出候选,
+//再逐个做通配符匹配;模式以通配符开头时前缀为空,等于遍历整个库
+std::string Server::keysCommand(const std::string& pattern) {
+    size_t literal = pattern.find_first_of("*?[\\");
+    std::string prefix = pattern.substr(0, literal);
+    bool exact = literal == std::string::npos;
+    bool matchAll = literal == pattern.size() - 1 && pattern[literal] == '*';     // prefix* 不用再逐个匹配
+    std::string body;
+    size_t n = 0;
+    for (auto& k : engine.keysWithPrefix(prefix, nullptr, SIZE_MAX)) {
+        if (exact ? k != pattern : !matchAll && !globMatch(pattern.data(), pattern.size(), k.data(), k.size()))
+            continue;
+        body += Resp::bulk(k);
+        n++;
+    }
+    return Resp::arrayHeader(n) + body;
+}
+
+//字典序区间的端点,语法同 ZRANGEBYLEX:[a 含端点,(a 不含,- 和 + 表示不限
+static bool parseLexBound(const std::string& s, std::string& out, bool& exclusive, bool& unbounded) {
+    unbounded = s == "-" || s == "+";
+    if (unbounded) return true;
+    if (s.empty() || (s[0] != '[' && s[0] != '(')) return false;
+    exclusive = s[0] == '(';
+    out = s.substr(1);
+    return true;
+}
+
+// KEYINDEX PREFIX prefix [AFTER key] [COUNT count]
+//   按字典序返回当前库里以 prefix 开头的 key,回复 [游标, [key ...]];游标是这一批的最后一个 key,
+//   下一批带上 AFTER 游标接着取,取完时游标为空。和 SCAN 不同,结果有序且不重复
+// KEYINDEX RANGE min max [LIMIT offset count]
+//   字典序在 min 和 max 之间的 key
+std::string Server::keyindexCommand(const std::vector<std::string>& cmd) {
+    const char* sub = cmd[1].c_str();
+    if (!strcasecmp(sub, "PREFIX")) {
+        std::string after;
+        bool hasAfter = false;
+        long long count = 10;
+        for (size_t i = 3; i < cmd.size(); i += 2) {
+            if (i + 1 >= cmd.size()) return Resp::error("ERR syntax error");
+            if (!strcasecmp(cmd[i].c_str(), "AFTER")) {
+                after = cmd[i + 1];
+                hasAfter = true;
+            } else if (!strcasecmp(cmd[i].c_str(), "COUNT")) {
+                count = atoll(cmd[i + 1].c_str());
+                if (count < 1) return Resp::error("ERR syntax error");
+            } else {
+                return Resp::error("ERR syntax error");
+            }
+        }
+        //多取一个,用来判断后面还有没有
+        auto keys = engine.keysWithPrefix(cmd[2], hasAfter ? &after : nullptr, count + 1);
+        bool more = keys.size() > (size_t)count;
+        if (more) keys.pop_back();
+        std::string reply = Resp::arrayHeader(2) + (more ? Resp::bulk(keys.back()) : Resp::nullBulk());
+        reply += Resp::arrayHeader(keys.size());
+        for (auto& k : keys) reply += Resp::bulk(k);
+        return reply;
+    }
+    if (!strcasecmp(sub, "RANGE") && (cmd.size() == 4 || cmd.size() == 7)) {
+        std::string lo, hi;
+        bool loEx = false, hiEx = false, loInf, hiInf;
+        if (!parseLexBound(cmd[2], lo, loEx, loInf) || !parseLexBound(cmd[3], hi, hiEx, hiInf) ||
+            (loInf && cmd[2] != "-") || (hiInf && cmd[3] != "+"))
+            return Resp::error("ERR min or max not valid string range item");
+        long long offset = 0, count = -1;
+        if (cmd.size() == 7) {
+            if (strcasecmp(cmd[4].c_str(), "LIMIT")) return Resp::error("ERR syntax error");
+            offset = atoll(cmd[5].c_str());
+            count = atoll(cmd[6].c_str());
+            if (offset < 0) return Resp::arrayHeader(0);
+        }
+        auto keys = engine.keyRange(loInf ? nullptr : &lo, loEx, hiInf ? nullptr : &hi, hiEx, offset,
+                                    count < 0 ? SIZE_MAX : count);
+        std::string reply = Resp::arrayHeader(keys.size());
+        for (auto& k : keys) reply += Resp::bulk(k);
+        return reply;
+    }
+    return Resp::error("ERR Unknown subcommand or wrong number of arguments for '" + cmd[1] + "'");
+}
+
+static bool parseDbIndex(const std::string& s, int& id) {
+    char* end;
+    long v = strtol(s.c_str(), &end, 10);
+    if (s.empty() || *end || v < INT32_MIN || v > INT32_MAX) return false;
+    id = v;
+    return true;
+}
+
+// SELECT index:之后这个连接的所有命令都作用在该库上
+std::string Server::selectCommand(Client* c, const std::vector<std::string>& cmd) {
+    int id;
+    if (!parseDbIndex(cmd[1], id)) return Resp::error("ERR value is not an integer or out of range");
+    if (cluster && id != 0) return Resp::error("ERR SELECT is not allowed in cluster mode");
+    if (id < 0 || id >= engine.dbCount()) return Resp::error("ERR DB index is out of range");
+    c->db = id;
+    return Resp::simple("OK");
+}
+
+// SWAPDB a b:已经选中这两个库的连接立刻看到对方的数据。
+//阻塞在这两个库上的客户端可能因此等到了非空列表或有新消息的流,需要重新检查
+std::string Server::swapdbCommand(const std::vector<std::string>& cmd) {
+    if (cluster) return Resp::error("ERR SWAPDB is not allowed in cluster mode");
+    int a, b;
+    if (!parseDbIndex(cmd[1], a)) return Resp::error("ERR invalid first DB index");
+    if (!parseDbIndex(cmd[2], b)) return Resp::error("ERR invalid second DB index");
+    if (!engine.swapdb(a, b)) return Resp::error("ERR DB index is out of range");
+    trackingInvalidateAll();
+    for (int id : {a, b}) {
+        engine.select(id);
+        for (auto& [key, waiters] : blockingKeys[id])
+            if (engine.exists(key) && (engine.checkType(key, OBJ_LIST) || engine.checkType(key, OBJ_STREAM)))
+                signalKeyAsReady(id, key);
+    }
+    return Resp::simple("OK");
+}
+
+// FLUSHDB|FLUSHALL [ASYNC|SYNC]:ASYNC 把旧表交给后台线程释放,命令本身只是换一张空表
+std::string Server::flushCommand(const std::vector<std::string>& cmd, bool all) {
+    bool async = false;
+    if (cmd.size() == 2) {
+        if (!strcasecmp(cmd[1].c_str(), "ASYNC")) async = true;
+        else if (strcasecmp(cmd[1].c_str(), "SYNC")) return Resp::error("ERR syntax error");
+    }
+    if (all) engine.flushall(async);
+    else engine.flushdb(async);
+    trackingInvalidateAll();
+    return Resp::simple("OK");
+}
@@ -0,0 +1,462 @@
+//流:XADD/XRANGE/XREVRANGE/XDEL/XTRIM/XINFO,XREAD 和消费组 XGROUP/XREADGROUP/XACK/XPENDING。
+//存储结构在 storage/stream.h;这里只做参数解析和回复格式,BLOCK 复用阻塞命令的等待队列
+#include "server.h"
+#include "resp.h"
+#include <strings.h>
+#include <cstdlib>
+#include <chrono>
+
+static const char* WRONGTYPE = "WRONGTYPE Operation against a key holding the wrong kind of value";
+static const char* INVALID_ID = "ERR Invalid stream ID specified as stream command argument";
+
+//消息 ID 用墙上时间(毫秒),和 Redis 一样
+static uint64_t wallMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static bool parseCount(const std::string& s, long long& v) {
+    char* end;
+    v = strtoll(s.c_str(), &end, 10);
+    return !s.empty() && !*end;
+}
+
+static std::string noGroup(const std::string& key, const std::string& group) {
+    return Resp::error("NOGROUP No such key '" + key + "' or consumer group '" + group + "'");
+}
+
+// [id, [field, value, ...]];已经删除的消息(只在读历史 PEL 时出现)内容为空
+static std::string entryReply(const StreamEntry& e) {
+    std::string r = Resp::arrayHeader(2) + Resp::bulk(e.id.toString());
+    if (e.missing) return r + Resp::nullArray();
+    r += Resp::arrayHeader(e.fields.size());
+    for (auto& f : e.fields) r += Resp::bulk(f);
+    return r;
+}
+
+static std::string entriesReply(const std::vector<StreamEntry>& entries) {
+    std::string r = Resp::arrayHeader(entries.size());
+    for (auto& e : entries) r += entryReply(e);
+    return r;
+}
+
+// XREAD 的回复:每个有消息的流一项,RESP2 是 [[key, entries] ...],RESP3 是 key -> entries 的 map
+static std::string streamsReply(const Client* c, const std::vector<std::pair<std::string, std::string>>& parts) {
+    std::string r = c->resp == 3 ? Resp::mapHeader(parts.size()) : Resp::arrayHeader(parts.size());
+    for (auto& [key, entries] : parts) {
+        if (c->resp != 3) r += Resp::arrayHeader(2);
+        r += Resp::bulk(key) + entries;
+    }
+    return r;
+}
+
+//范围的端点:只给毫秒时起点补 0、终点补最大序号;"(" 开头表示不含端点,转成相邻的 ID
+static bool parseRangeId(const std::string& s, StreamID& id, bool isEnd) {
+    bool exclusive = !s.empty() && s[0] == '(';
+    std::string t = exclusive ? s.substr(1) : s;
+    if (exclusive && (t == "-" || t == "+")) return false;
+    if (!parseStreamID(t, id, isEnd ? UINT64_MAX : 0)) return false;
+    if (exclusive) return isEnd ? id.decr() : id.incr();
+    return true;
+}
+
+struct TrimSpec {
+    bool set = false;
+    bool byLen = true;
+    bool approx = false;
+    long long maxLen = 0;
+    StreamID minId;
+};
+
+// MAXLEN|MINID [=|~] threshold;i 指向 MAXLEN/MINID,成功后指向下一个参数
+static bool parseTrim(const std::vector<std::string>& cmd, size_t& i, TrimSpec& t, std::string& err) {
+    t.set = true;
+    t.byLen = !strcasecmp(cmd[i].c_str(), "MAXLEN");
+    i++;
+    if (i < cmd.size() && (cmd[i] == "~" || cmd[i] == "=")) {
+        t.approx = cmd[i] == "~";
+        i++;
+    }
+    if (i >= cmd.size()) {
+        err = Resp::error("ERR syntax error");
+        return false;
+    }
+    if (t.byLen) {
+        if (!parseCount(cmd[i], t.maxLen)) {
+            err = Resp::error("ERR value is not an integer or out of range");
+            return false;
+        }
+        if (t.maxLen < 0) {
+            err = Resp::error("ERR The MAXLEN argument must be >= 0.");
+            return false;
+        }
+    } else if (!parseStreamID(cmd[i], t.minId, 0)) {
+        err = Resp::error(INVALID_ID);
+        return false;
+    }
+    i++;
+    return true;
+}
+
+static size_t applyTrim(Stream* s, const TrimSpec& t) {
+    return t.byLen ? s->trimMaxLen(t.maxLen, t.approx) : s->trimMinId(t.minId, t.approx);
+}
+
+// XADD key [NOMKSTREAM] [MAXLEN|MINID [=|~] threshold] *|ms-*|ms-seq field value [field value ...]
+std::string Server::xaddCommand(Client* c, const std::vector<std::string>& cmd) {
+    const std::string& key = cmd[1];
+    bool nomkstream = false;
+    TrimSpec trim;
+    std::string err;
+    size_t i = 2;
+    while (i < cmd.size()) {
+        if (!strcasecmp(cmd[i].c_str(), "NOMKSTREAM")) {
+            nomkstream = true;
+            i++;
+        } else if (!strcasecmp(cmd[i].c_str(), "MAXLEN") || !strcasecmp(cmd[i].c_str(), "MINID")) {
+            if (!parseTrim(cmd, i, trim, err)) return err;
+        } else {
+            break;
+        }
+    }
+    if (i + 1 >= cmd.size() || (cmd.size() - i - 1) % 2) return Resp::error("ERR wrong number of arguments for 'xadd' command");
+    const std::string& idArg = cmd[i];
+    bool autoId = idArg == "*", autoSeq = false;
+    StreamID id;
+    if (!autoId) {
+        autoSeq = idArg.size() > 2 && idArg.compare(idArg.size() - 2, 2, "-*") == 0;
+        bool seqGiven;
+        if (autoSeq ? !parseStreamID(idArg.substr(0, idArg.size() - 2), id, 0, &seqGiven) || seqGiven
+                    : !parseStreamID(idArg, id, 0) || idArg == "-" || idArg == "+")
+            return Resp::error(INVALID_ID);
+        if (!autoSeq && id == StreamID()) return Resp::error("ERR The ID specified in XADD must be greater than 0-0");
+    }
+    if (!engine.checkType(key, OBJ_STREAM)) return Resp::error(WRONGTYPE);
+    Stream* s = engine.streamWrite(key, !nomkstream);
+    if (!s) return Resp::nullBulk();
+
+    StreamID last = s->lastId();
+    if (autoId) {
+        if (!s->nextId(wallMs(), id))
+            return Resp::error("ERR The stream has exhausted the last possible ID, unable to add more items");
+    } else if (autoSeq) {
+        //同一毫秒内序号接着最后一条往下排,新的毫秒从 0 开始
+        if (id.ms == last.ms) {
+            id = last;
+            if (!id.incr() || id.ms != last.ms) return Resp::error("ERR The ID specified in XADD is equal or smaller than the target stream top item");
+        }
+    }
+    if (id <= last) return Resp::error("ERR The ID specified in XADD is equal or smaller than the target stream top item");
+    s->append(id, std::vector<std::string>(cmd.begin() + i + 1, cmd.end()));
+    if (trim.set) applyTrim(s, trim);
+    signalKeyAsReady(c->db, key);
+    return Resp::bulk(id.toString());
+}
+
+// XRANGE key start end [COUNT n] / XREVRANGE key end start [COUNT n]
+std::string Server::xrangeCommand(const std::vector<std::string>& cmd, bool reverse) {
+    StreamID start, end;
+    if (!parseRangeId(cmd[reverse ? 3 : 2], start, false) || !parseRangeId(cmd[reverse ? 2 : 3], end, true))
+        return Resp::error(INVALID_ID);
+    long long count = 0;
+    if (cmd.size() == 6) {
+        if (strcasecmp(cmd[4].c_str(), "COUNT")) return Resp::error("ERR syntax error");
+        if (!parseCount(cmd[5], count)) return Resp::error("ERR value is not an integer or out of range");
+        if (count <= 0) return Resp::arrayHeader(0);
+    }
+    if (!engine.checkType(cmd[1], OBJ_STREAM)) return Resp::error(WRONGTYPE);
+    Stream* s = engine.streamRead(cmd[1]);
+    if (!s) return Resp::arrayHeader(0);
+    return entriesReply(s->range(start, end, reverse, count));
+}
+
+// XDEL key id [id ...]
+std::string Server::xdelCommand(const std::vector<std::string>& cmd) {
+    std::vector<StreamID> ids(cmd.size() - 2);
+    for (size_t i = 2; i < cmd.size(); i++)
+        if (!parseStreamID(cmd[i], ids[i - 2], 0)) return Resp::error(INVALID_ID);
+    if (!engine.checkType(cmd[1], OBJ_STREAM)) return Resp::error(WRONGTYPE);
+    Stream* s = engine.streamWrite(cmd[1], false);
+    long long deleted = 0;
+    for (auto& id : ids) deleted += s && s->remove(id);
+    return Resp::integer(deleted);
+}
+
+// XTRIM key MAXLEN|MINID [=|~] threshold
+std::string Server::xtrimCommand(const std::vector<std::string>& cmd) {
+    TrimSpec trim;
+    std::string err;
+    size_t i = 2;
+    if (strcasecmp(cmd[i].c_str(), "MAXLEN") && strcasecmp(cmd[i].c_str(), "MINID")) return Resp::error("ERR syntax error");
+    if (!parseTrim(cmd, i, trim, err)) return err;
+    if (i != cmd.size()) return Resp::error("ERR syntax error");
+    if (!engine.checkType(cmd[1], OBJ_STREAM)) return Resp::error(WRONGTYPE);
+    Stream* s = engine.streamWrite(cmd[1], false);
+    return Resp::integer(s ? applyTrim(s, trim) : 0);
+}
+
+// XREAD [COUNT n] [BLOCK ms] STREAMS key [key ...] id [id ...]
+// XREADGROUP GROUP group consumer [COUNT n] [BLOCK ms] [NOACK] STREAMS key [key ...] id [id ...]
+// XREAD 的 $ 表示只要之后的新消息;XREADGROUP 的 > 表示组里还没投递过的消息,其他 ID 重读自己的 PEL。
+//一条都读不到、又给了 BLOCK 时挂起并返回空串,直到有人往这些流里 XADD(只有 > 会阻塞,重读 PEL 总是立即返回)
+std::string Server::xreadCommand(Client* c, const std::vector<std::string>& cmd, bool group) {
+    long long count = 0, block = -1;
+    bool noack = false;
+    std::string groupName, consumerName;
+    size_t i = 1;
+    for (; i < cmd.size(); i++) {
+        const char* opt = cmd[i].c_str();
+        bool hasArg = i + 1 < cmd.size();
+        if (!strcasecmp(opt, "STREAMS")) {
+            i++;
+            break;
+        } else if (!strcasecmp(opt, "COUNT") && hasArg) {
+            if (!parseCount(cmd[++i], count)) return Resp::error("ERR value is not an integer or out of range");
+            if (count < 0) count = 0;
+        } else if (!strcasecmp(opt, "BLOCK") && hasArg) {
+            if (!parseCount(cmd[++i], block)) return Resp::error("ERR timeout is not an integer or out of range");
+            if (block < 0) return Resp::error("ERR timeout is negative");
+        } else if (group && !strcasecmp(opt, "GROUP") && i + 2 < cmd.size()) {
+            groupName = cmd[++i];
+            consumerName = cmd[++i];
+        } else if (group && !strcasecmp(opt, "NOACK")) {
+            noack = true;
+        } else {
+            return Resp::error("ERR syntax error");
+        }
+    }
+    if (group && groupName.empty()) return Resp::error("ERR Missing GROUP option for XREADGROUP");
+    size_t rest = cmd.size() - i;
+    if (rest == 0 || rest % 2)
+        return Resp::error(std::string("ERR Unbalanced '") + (group ? "xreadgroup" : "xread") +
+                                       "' list of streams: for each stream key an ID or '$' must be specified.");
+    size_t n = rest / 2;
+
+    //先检查完所有 key 和 ID 再读,出错时不改动任何消费组
+    std::vector<std::pair<std::string, StreamID>> targets;
+    std::vector<bool> history(n, false);
+    for (size_t k = 0; k < n; k++) {
+        const std::string& key = cmd[i + k];
+        const std::string& idArg = cmd[i + n + k];
+        if (!engine.checkType(key, OBJ_STREAM)) return Resp::error(WRONGTYPE);
+        StreamID id;
+        if (group) {
+            Stream* s = engine.streamRead(key);
+            if (!s || !s->group(groupName))
+                return Resp::error("NOGROUP No such key '" + key + "' or consumer group '" + groupName +
+                                               "' in XREADGROUP with GROUP option");
+            history[k] = idArg != ">";
+            if (history[k] && !parseStreamID(idArg, id, 0)) return Resp::error(INVALID_ID);
+        } else if (idArg == "$") {
+            Stream* s = engine.streamRead(key);
+            if (s) id = s->lastId();
+        } else if (!parseStreamID(idArg, id, 0)) {
+            return Resp::error(INVALID_ID);
+        }
+        targets.emplace_back(key, id);
+    }
+
+    std::vector<std::pair<std::string, std::string>> parts;
+    uint64_t now = wallMs();
+    for (size_t k = 0; k < n; k++) {
+        auto& [key, id] = targets[k];
+        if (group) {
+            Stream* s = engine.streamWrite(key, false);
+            StreamGroup* g = s->group(groupName);
+            StreamConsumer* consumer = s->consumer(g, consumerName, true);
+            if (history[k]) {
+                parts.emplace_back(key, entriesReply(s->readPending(consumer, id, count, now)));
+                continue;
+            }
+            auto entries = s->readGroup(g, consumer, count, noack, now);
+            if (!entries.empty()) parts.emplace_back(key, entriesReply(entries));
+        } else {
+            Stream* s = engine.streamRead(key);
+            StreamID start = id;
+            if (!s || s->lastId() <= id || !start.incr()) continue;
+            auto entries = s->range(start, StreamID::max(), false, count);
+            if (!entries.empty()) parts.emplace_back(key, entriesReply(entries));
+        }
+    }
+    if (!parts.empty()) return streamsReply(c, parts);
+    if (block < 0) return Resp::nullArray();
+
+    c->blockStream = true;
+    c->blockStreamIds = std::move(targets);
+    c->blockCount = count;
+    c->blockGroup = groupName;
+    c->blockConsumer = consumerName;
+    c->blockNoack = noack;
+    std::vector<std::string> keys;
+    for (auto& t : c->blockStreamIds) keys.push_back(t.first);
+    blockClient(c, keys, block);
+    return "";
+}
+
+//流里来了新消息,看阻塞在上面的客户端能不能读到;读到了就回复并返回 true
+bool Server::serveStreamWaiter(Client* c, const std::string& key) {
+    if (!engine.checkType(key, OBJ_STREAM)) return false;
+    std::vector<StreamEntry> entries;
+    if (!c->blockGroup.empty()) {
+        Stream* s = engine.streamWrite(key, false);
+        if (!s) return false;
+        StreamGroup* g = s->group(c->blockGroup);
+        //等待期间组被删掉了
+        if (!g) {
+            addReply(c, Resp::error("NOGROUP the consumer group this client was blocked on no longer exists"));
+            return true;
+        }
+        if (g->lastId >= s->lastId()) return false;
+        entries = s->readGroup(g, s->consumer(g, c->blockConsumer, true), c->blockCount, c->blockNoack, wallMs());
+    } else {
+        Stream* s = engine.streamRead(key);
+        StreamID start;
+        for (auto& t : c->blockStreamIds)
+            if (t.first == key) start = t.second;
+        if (!s || s->lastId() <= start || !start.incr()) return false;
+        entries = s->range(start, StreamID::max(), false, c->blockCount);
+    }
+    if (entries.empty()) return false;
+    addReply(c, streamsReply(c, {{key, entriesReply(entries)}}));
+    return true;
+}
+
+// XGROUP CREATE key group id|$ [MKSTREAM] / SETID key group id|$ / DESTROY key group
+//        CREATECONSUMER key group consumer / DELCONSUMER key group consumer
+std::string Server::xgroupCommand(const std::vector<std::string>& cmd) {
+    const char* sub = cmd[1].c_str();
+    const std::string& key = cmd[2];
+    const std::string& name = cmd[3];
+    bool create = !strcasecmp(sub, "CREATE");
+    bool mkstream = create && cmd.size() == 6 && !strcasecmp(cmd[5].c_str(), "MKSTREAM");
+    if (!engine.checkType(key, OBJ_STREAM)) return Resp::error(WRONGTYPE);
+
+    if (create || !strcasecmp(sub, "SETID")) {
+        if (cmd.size() != 5 && !mkstream) return Resp::error("ERR syntax error");
+        StreamID id;
+        if (cmd[4] != "$" && !parseStreamID(cmd[4], id, 0)) return Resp::error(INVALID_ID);
+        Stream* s = engine.streamWrite(key, mkstream);
+        if (!s)
+            return Resp::error("ERR The XGROUP subcommand requires the key to exist. Note that for CREATE you may "
+                               "want to use the MKSTREAM option to create an empty stream automatically.");
+        if (cmd[4] == "$") id = s->lastId();
+        if (create) {
+            if (!s->createGroup(name, id)) return Resp::error("BUSYGROUP Consumer Group name already exists");
+        } else {
+            StreamGroup* g = s->group(name);
+            if (!g) return noGroup(key, name);
+            g->lastId = id;
+        }
+        return Resp::simple("OK");
+    }
+
+    Stream* s = engine.streamWrite(key, false);
+    if (!s) return Resp::error("ERR The XGROUP subcommand requires the key to exist");
+    if (!strcasecmp(sub, "DESTROY") && cmd.size() == 4) return Resp::integer(s->destroyGroup(name) ? 1 : 0);
+    if ((!strcasecmp(sub, "CREATECONSUMER") || !strcasecmp(sub, "DELCONSUMER")) && cmd.size() == 5) {
+        StreamGroup* g = s->group(name);
+        if (!g) return noGroup(key, name);
+        if (!strcasecmp(sub, "DELCONSUMER")) return Resp::integer(s->deleteConsumer(g, cmd[4]));
+        bool created;
+        s->consumer(g, cmd[4], true, &created);
+        return Resp::integer(created ? 1 : 0);
+    }
+    return Resp::error("ERR Unknown subcommand or wrong number of arguments for '" + cmd[1] + "'");
+}
+
+// XACK key group id [id ...]
+std::string Server::xackCommand(const std::vector<std::string>& cmd) {
+    std::vector<StreamID> ids(cmd.size() - 3);
+    for (size_t i = 3; i < cmd.size(); i++)
+        if (!parseStreamID(cmd[i], ids[i - 3], 0)) return Resp::error(INVALID_ID);
+    if (!engine.checkType(cmd[1], OBJ_STREAM)) return Resp::error(WRONGTYPE);
+    Stream* s = engine.streamWrite(cmd[1], false);
+    StreamGroup* g = s ? s->group(cmd[2]) : nullptr;
+    if (!g) return Resp::integer(0);
+    long long acked = 0;
+    for (auto& id : ids) acked += s->ack(g, id);
+    return Resp::integer(acked);
+}
+
+// XPENDING key group:汇总 [总数, 最小 ID, 最大 ID, [[消费者, 数量] ...]]
+// XPENDING key group [IDLE ms] start end count [consumer]:逐条 [ID, 消费者, 空闲毫秒, 投递次数]
+std::string Server::xpendingCommand(const std::vector<std::string>& cmd) {
+    const std::string& key = cmd[1];
+    if (!engine.checkType(key, OBJ_STREAM)) return Resp::error(WRONGTYPE);
+    Stream* s = engine.streamRead(key);
+    StreamGroup* g = s ? s->group(cmd[2]) : nullptr;
+    if (!g) return noGroup(key, cmd[2]);
+
+    if (cmd.size() == 3) {
+        size_t total = g->pel.size();
+        if (total == 0) return Resp::arrayHeader(4) + Resp::integer(0) + Resp::nullBulk() + Resp::nullBulk() + Resp::nullArray();
+        StreamID minId, maxId;
+        auto first = [](StreamID& out) {
+            return [&out](const StreamID& id, const StreamNack*) {
+                out = id;
+                return false;
+            };
+        };
+        s->forEachPending(g, nullptr, StreamID(), StreamID::max(), false, first(minId));
+        s->forEachPending(g, nullptr, StreamID(), StreamID::max(), true, first(maxId));
+        std::string body;
+        size_t consumers = 0;
+        g->consumers.walk(nullptr, nullptr, false, [&](const std::string& name, void* v) {
+            auto* consumer = static_cast<StreamConsumer*>(v);
+            if (consumer->pel.size() == 0) return true;
+            body += Resp::arrayHeader(2) + Resp::bulk(name) + Resp::bulk(std::to_string(consumer->pel.size()));
+            consumers++;
+            return true;
+        });
+        return Resp::arrayHeader(4) + Resp::integer(total) + Resp::bulk(minId.toString()) +
+               Resp::bulk(maxId.toString()) + Resp::arrayHeader(consumers) + body;
+    }
+
+    size_t i = 3;
+    long long minIdle = 0, count;
+    if (!strcasecmp(cmd[i].c_str(), "IDLE")) {
+        if (i + 1 >= cmd.size() || !parseCount(cmd[i + 1], minIdle)) return Resp::error("ERR syntax error");
+        i += 2;
+    }
+    if (cmd.size() - i != 3 && cmd.size() - i != 4) return Resp::error("ERR syntax error");
+    StreamID start, end;
+    if (!parseRangeId(cmd[i], start, false) || !parseRangeId(cmd[i + 1], end, true)) return Resp::error(INVALID_ID);
+    if (!parseCount(cmd[i + 2], count)) return Resp::error("ERR value is not an integer or out of range");
+    StreamConsumer* consumer = nullptr;
+    if (cmd.size() - i == 4) {
+        consumer = s->consumer(g, cmd[i + 3], false);
+        if (!consumer) return Resp::arrayHeader(0);
+    }
+    std::string body;
+    long long n = 0;
+    uint64_t now = wallMs();
+    if (count > 0) {
+        s->forEachPending(g, consumer, start, end, false, [&](const StreamID& id, const StreamNack* nack) {
+            long long idle = now > nack->deliveryTime ? now - nack->deliveryTime : 0;
+            if (idle < minIdle) return true;
+            body += Resp::arrayHeader(4) + Resp::bulk(id.toString()) + Resp::bulk(nack->consumer->name) +
+                    Resp::integer(idle) + Resp::integer(nack->deliveryCount);
+            return ++n < count;
+        });
+    }
+    return Resp::arrayHeader(n) + body;
+}
+
+// XINFO STREAM key:长度、块数、占用内存、最后生成的 ID、消费组数、第一条和最后一条消息
+std::string Server::xinfoCommand(const std::vector<std::string>& cmd) {
+    if (strcasecmp(cmd[1].c_str(), "STREAM")) return Resp::error("ERR Unknown subcommand or wrong number of arguments for '" + cmd[1] + "'");
+    if (!engine.checkType(cmd[2], OBJ_STREAM)) return Resp::error(WRONGTYPE);
+    Stream* s = engine.streamRead(cmd[2]);
+    if (!s) return Resp::error("ERR no such key");
+    auto first = s->range(StreamID(), StreamID::max(), false, 1);
+    auto last = s->range(StreamID(), StreamID::max(), true, 1);
+    std::string r = Resp::arrayHeader(14);
+    r += Resp::bulk("length") + Resp::integer(s->length());
+    r += Resp::bulk("radix-tree-keys") + Resp::integer(s->blocks());
+    r += Resp::bulk("memory-bytes") + Resp::integer(s->bytes());
+    r += Resp::bulk("last-generated-id") + Resp::bulk(s->lastId().toString());
+    r += Resp::bulk("groups") + Resp::integer(s->groupCount());
+    r += Resp::bulk("first-entry") + (first.empty() ? Resp::nullBulk() : entryReply(first[0]));
+    r += Resp::bulk("last-entry") + (last.empty() ? Resp::nullBulk() : entryReply(last[0]));
+    return r;
+}
@@ -0,0 +1,250 @@
+//客户端缓存失效通知(CLIENT TRACKING)
+//默认模式:记住每个客户端读过哪些 key,key 被修改时只通知读过它的客户端,通知一次后就忘掉,
+//客户端再读一次才会重新登记。失效表里不存 key,只存 key 的 64 位哈希,冲突最多多发一次通知。
+//BCAST 模式:不记录读过的 key,客户端登记前缀,匹配前缀的 key 一被修改就广播;
+//服务器几乎不占内存,代价是客户端会收到没缓存过的 key 的通知。
+//通知格式:RESP3 客户端收推送消息 >2 invalidate [key ...];RESP2 客户端用 REDIRECT
+//把通知转给另一个订阅了 __redis__:invalidate 的连接,以 pub/sub 消息的格式发送
+#include "server.h"
+#include "resp.h"
+#include <strings.h>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_set>
+
+static const size_t TRACKING_TABLE_MAX_KEYS = 1000000;   //失效表上限,超过后淘汰一项并让相关客户端清空缓存
+static const char* INVALIDATE_CHANNEL = "__redis__:invalidate";
+
+//只读命令的 key 是 cmd[first..last],不是只读命令返回 false
+static bool readCommandKeys(const std::string& name, size_t argc, size_t& first, size_t& last) {
+    static const char* single[] = {"GET", "HGET", "HLEN", "HEXISTS", "HGETALL", "LLEN", "LRANGE",
+                                   "TYPE", "BF.EXISTS", "BF.MEXISTS", "XLEN", "XRANGE", "XREVRANGE",
+                                   "ZSCORE", "ZCARD", "ZRANK", "ZREVRANK", "ZRANGE", "ZREVRANGE", "ZRANGEBYSCORE",
+                                   "ZREVRANGEBYSCORE", "ZCOUNT", "GEOPOS", "GEODIST", "GEOHASH", "GEOSEARCH"};
+    if (argc < 2) return false;
+    first = 1;
+    last = 1;
+    if (name == "PFCOUNT") {
+        last = argc - 1;
+        return true;
+    }
+    for (const char* s : single)
+        if (name == s) return true;
+    return false;
+}
+
+//执行只读命令前登记读过的 key(默认模式)
+void Server::trackingRememberKeys(Client* c, const std::string& name, const std::vector<std::string>& cmd) {
+    size_t first, last;
+    if (!readCommandKeys(name, cmd.size(), first, last)) return;
+    for (size_t i = first; i <= last; i++) {
+        auto& ids = trackingTable[dictHash(cmd[i].data(), cmd[i].size())];
+        if (std::find(ids.begin(), ids.end(), c->id) == ids.end()) ids.push_back(c->id);
+    }
+    //表满了:随便淘汰一项。表里没有 key 名,没法发具体的 key,只能让这些客户端清空整个缓存
+    while (trackingTable.size() > TRACKING_TABLE_MAX_KEYS) {
+        auto victim = trackingTable.begin();
+        for (uint64_t id : victim->second) {
+            auto it = clientsById.find(id);
+            if (it != clientsById.end() && it->second->tracking) sendInvalidation(it->second, Resp::nullArray());
+        }
+        trackingTable.erase(victim);
+    }
+}
+
+// StorageEngine 的修改回调:默认模式立即通知并删掉这一项;BCAST 模式先攒着,事件循环每轮合并发送
+void Server::trackingInvalidateKey(const std::string& key) {
+    for (auto& [prefix, bp] : bcastPrefixes) {
+        if (key.compare(0, prefix.size(), prefix) == 0) bp.keys.emplace_back(key, currentClientId);
+    }
+    if (trackingTable.empty()) return;
+    auto it = trackingTable.find(dictHash(key.data(), key.size()));
+    if (it == trackingTable.end()) return;
+    std::vector<uint64_t> ids = std::move(it->second);
+    trackingTable.erase(it);
+    std::string payload = Resp::arrayHeader(1) + Resp::bulk(key);
+    for (uint64_t id : ids) {
+        auto ci = clientsById.find(id);
+        if (ci == clientsById.end()) continue;   //已经断开的客户端留下的记录,这里顺便清掉
+        Client* t = ci->second;
+        //关掉后重新打开的客户端可能收到一次多余的通知,不影响正确性
+        if (!t->tracking || t->trackingBcast) continue;
+        if (t->trackingNoloop && id == currentClientId) continue;
+        sendInvalidation(t, payload);
+    }
+}
+
+//每个前缀一条消息,带上本轮所有被修改的匹配 key(同一个 key 只出现一次)
+void Server::trackingBroadcastInvalidations() {
+    for (auto& [prefix, bp] : bcastPrefixes) {
+        if (bp.keys.empty()) continue;
+        for (uint64_t id : bp.clients) {
+            auto ci = clientsById.find(id);
+            if (ci == clientsById.end()) continue;
+            Client* t = ci->second;
+            std::unordered_set<std::string> seen;
+            std::string body;
+            for (auto& [key, modifier] : bp.keys) {
+                if (t->trackingNoloop && modifier == id) continue;
+                if (!seen.insert(key).second) continue;
+                body += Resp::bulk(key);
+            }
+            if (!seen.empty()) sendInvalidation(t, Resp::arrayHeader(seen.size()) + body);
+        }
+        bp.keys.clear();
+    }
+}
+
+// keys 是已经编码好的 key 数组(或表示 "全部失效" 的空数组)
+void Server::sendInvalidation(Client* c, const std::string& keys) {
+    Client* target = c;
+    if (c->trackingRedirect) {
+        auto it = clientsById.find(c->trackingRedirect);
+        if (it == clientsById.end()) {
+            //接收通知的连接已经断开,客户端的缓存不再可信
+            if (c->resp == 3) {
+                addReply(c, Resp::pushHeader(2) + Resp::bulk("tracking-redir-broken") + Resp::integer(c->trackingRedirect));
+                wakeClient(c);
+            }
+            return;
+        }
+        target = it->second;
+    }
+    if (target->resp == 3)
+        addReply(target, Resp::pushHeader(2) + Resp::bulk("invalidate") + keys);
+    else if (target->subscribedInvalidate)
+        addReply(target, Resp::arrayHeader(3) + Resp::bulk("message") + Resp::bulk(INVALIDATE_CHANNEL) + keys);
+    else
+        return;
+    wakeClient(target);
+}
+
+//给不是当前正在处理的客户端追加了回复后,让事件循环把它发出去
+void Server::wakeClient(Client* c) {
+    if (c->closeAsap && c->reply.empty()) {
+        //超过输出限制被标记关闭的,交给事件循环释放
+        if (std::find(unblockedClients.begin(), unblockedClients.end(), c) == unblockedClients.end())
+            unblockedClients.push_back(c);
+        return;
+    }
+    if (backend == IoBackend::Uring) {
+        if (c->replyBytes > 0 && !c->pendingSend) {
+            c->pendingSend = true;
+            pendingSends.push_back(c->fd);
+        }
+    } else {
+        updateEvents(c);
+    }
+}
+
+//清空或交换库:不逐个通知 key,让所有开了跟踪的客户端清空整个缓存(空数组),失效表也随之清空
+void Server::trackingInvalidateAll() {
+    trackingTable.clear();
+    for (auto& [id, c] : clientsById)
+        if (c->tracking) sendInvalidation(c, Resp::nullArray());
+}
+
+//关闭跟踪或断开连接:从前缀表里摘掉;失效表里的记录不逐个清理,通知时发现客户端不在了再删
+void Server::trackingDisable(Client* c) {
+    for (auto& prefix : c->trackingPrefixes) {
+        auto it = bcastPrefixes.find(prefix);
+        if (it == bcastPrefixes.end()) continue;
+        auto& ids = it->second.clients;
+        ids.erase(std::remove(ids.begin(), ids.end(), c->id), ids.end());
+        if (ids.empty()) bcastPrefixes.erase(it);
+    }
+    c->trackingPrefixes.clear();
+    c->tracking = c->trackingBcast = c->trackingNoloop = false;
+    c->trackingRedirect = 0;
+}
+
+// CLIENT ID | GETREDIR | TRACKING on|off [REDIRECT id] [BCAST] [PREFIX p ...] [NOLOOP]
+std::string Server::clientCommand(Client* c, const std::vector<std::string>& cmd) {
+    if (cmd.size() < 2) return Resp::error("ERR wrong number of arguments for 'client' command");
+    const char* sub = cmd[1].c_str();
+    if (!strcasecmp(sub, "ID") && cmd.size() == 2) return Resp::integer(c->id);
+    if (!strcasecmp(sub, "GETREDIR") && cmd.size() == 2)
+        return Resp::integer(c->tracking ? (long long)c->trackingRedirect : -1);
+    if (strcasecmp(sub, "TRACKING") || cmd.size() < 3)
+        return Resp::error("ERR Unknown subcommand or wrong number of arguments for '" + cmd[1] + "'");
+
+    bool on;
+    if (!strcasecmp(cmd[2].c_str(), "on")) on = true;
+    else if (!strcasecmp(cmd[2].c_str(), "off")) on = false;
+    else return Resp::error("ERR syntax error");
+
+    uint64_t redirect = 0;
+    bool bcast = false, noloop = false;
+    std::vector<std::string> prefixes;
+    for (size_t i = 3; i < cmd.size(); i++) {
+        const char* opt = cmd[i].c_str();
+        bool more = i + 1 < cmd.size();
+        if (!strcasecmp(opt, "REDIRECT") && more) {
+            char* end;
+            long long id = strtoll(cmd[i + 1].c_str(), &end, 10);
+            if (cmd[i + 1].empty() || *end || id <= 0) return Resp::error("ERR Invalid client ID");
+            if (!clientsById.count(id)) return Resp::error("ERR The client ID you want redirect to does not exist");
+            redirect = id;
+            i++;
+        } else if (!strcasecmp(opt, "BCAST")) {
+            bcast = true;
+        } else if (!strcasecmp(opt, "PREFIX") && more) {
+            prefixes.push_back(cmd[++i]);
+        } else if (!strcasecmp(opt, "NOLOOP")) {
+            noloop = true;
+        } else {
+            return Resp::error("ERR syntax error");
+        }
+    }
+
+    if (!on) {
+        trackingDisable(c);
+        return Resp::simple("OK");
+    }
+    if (!prefixes.empty() && !bcast) return Resp::error("ERR PREFIX option requires BCAST mode to be enabled");
+    if (c->tracking && c->trackingBcast != bcast)
+        return Resp::error("ERR You can't switch BCAST mode on/off before disabling tracking for this client, and then re-enabling it with a different mode.");
+    if (!redirect && c->resp == 2)
+        return Resp::error("ERR RESP2 clients need REDIRECT to a connection subscribed to " + std::string(INVALIDATE_CHANNEL) + ", or switch to RESP3 with HELLO 3");
+
+    //重复打开时前缀在原来的基础上追加
+    std::vector<std::string> kept = c->trackingPrefixes;
+    trackingDisable(c);
+    c->tracking = true;
+    c->trackingBcast = bcast;
+    c->trackingNoloop = noloop;
+    c->trackingRedirect = redirect;
+    if (bcast) {
+        if (prefixes.empty() && kept.empty()) prefixes.push_back("");   //空前缀匹配所有 key
+        prefixes.insert(prefixes.begin(), kept.begin(), kept.end());
+        for (auto& p : prefixes) {
+            if (std::find(c->trackingPrefixes.begin(), c->trackingPrefixes.end(), p) != c->trackingPrefixes.end()) continue;
+            c->trackingPrefixes.push_back(p);
+            bcastPrefixes[p].clients.push_back(c->id);
+        }
+    }
+    return Resp::simple("OK");
+}
+
+// HELLO [protover]:切换协议版本并返回服务器信息,RESP3 用 map,RESP2 用扁平数组
+std::string Server::helloCommand(Client* c, const std::vector<std::string>& cmd) {
+    if (cmd.size() > 2) return Resp::error("ERR syntax error");
+    if (cmd.size() == 2) {
+        if (cmd[1] != "2" && cmd[1] != "3") return Resp::error("NOPROTO unsupported protocol version");
+        c->resp = cmd[1][0] - '0';
+    }
+    std::string body = Resp::bulk("server") + Resp::bulk("miniredis") + Resp::bulk("version") + Resp::bulk("1.0") +
+                       Resp::bulk("proto") + Resp::integer(c->resp) + Resp::bulk("id") + Resp::integer(c->id) +
+                       Resp::bulk("mode") + Resp::bulk(cluster ? "cluster" : "standalone") +
+                       Resp::bulk("role") + Resp::bulk("master");
+    return (c->resp == 3 ? Resp::mapHeader(6) : Resp::arrayHeader(12)) + body;
+}
+
+//只支持失效通知频道:RESP2 客户端用它接收重定向过来的通知,没有通用的 pub/sub
+std::string Server::subscribeCommand(Client* c, const std::vector<std::string>& cmd) {
+    if (cmd.size() != 2 || cmd[1] != INVALIDATE_CHANNEL)
+        return Resp::error("ERR only the " + std::string(INVALIDATE_CHANNEL) + " channel is supported");
+    c->subscribedInvalidate = true;
+    c->cls = ClientClass::PubSub;
+    return Resp::arrayHeader(3) + Resp::bulk("subscribe") + Resp::bulk(INVALIDATE_CHANNEL) + Resp::integer(1);
+}
@@ -0,0 +1,183 @@
+/*io_uring 后端:
+多发 accept 一次提交持续接收新连接;
+每个连接一个多发 recv,数据放进内核从 provided buffer ring 里挑的缓冲区;
+每轮处理完所有完成事件后,把所有有回复的客户端的 sendmsg 一起提交,一次系统调用搞定*/
+#include "server.h"
+#include "uring.h"
+#include "resp.h"
+#include "../storage/trace.h"
+#include <unistd.h>
+#include <cerrno>
+#include <iostream>
+
+static const unsigned RING_ENTRIES = 4096;
+static const unsigned RECV_BUF_COUNT = 1024;      //必须是 2 的幂
+static const unsigned RECV_BUF_SIZE = 16 * 1024;
+static const uint16_t RECV_BGID = 1;
+
+// user_data 低 3 位放操作类型,高位放 Client 指针(new 出来的对象至少 8 字节对齐);
+// accept 的高位放监听 socket 在 listeners 里的下标
+enum : uint64_t { OP_ACCEPT = 1, OP_RECV = 2, OP_SEND = 3, OP_CANCEL = 5 };
+
+static uint64_t packData(Client* c, uint64_t op) { return reinterpret_cast<uint64_t>(c) | op; }
+static Client* dataClient(uint64_t d) { return reinterpret_cast<Client*>(d & ~7ULL); }
+
+void Server::runUring() {
+    ring = new Uring;
+    if (!ring->init(RING_ENTRIES) || !ring->setupBufRing(RECV_BUF_COUNT, RECV_BUF_SIZE, RECV_BGID)) {
+        std::cerr << "io_uring unavailable, falling back to epoll" << std::endl;
+        delete ring;
+        ring = nullptr;
+        return;
+    }
+    std::cerr << "io_uring backend, recv buffers: "
+              << (ring->usingBufRing() ? "provided buffer ring" : "IORING_OP_PROVIDE_BUFFERS") << std::endl;
+
+    for (size_t i = 0; i < listeners.size(); i++) ring->prepAcceptMultishot(listeners[i].fd, i << 3 | OP_ACCEPT);
+
+    while (true) {
+        timers.advance(monotonicMs());
+        processUnblockedClients();
+        trackingBroadcastInvalidations();
+        uringFlushSends();
+        //最多等到最近一个定时器到期
+        int r;
+        {
+            TRACE_SCOPE("io_uring_enter");
+            r = ring->submitAndWait(1, timers.nextTimeoutMs(monotonicMs(), -1));
+        }
+        if (r < 0 && errno != EINTR && errno != EBUSY && errno != ETIME) {
+            std::cerr << "io_uring_enter failed, errno=" << errno << std::endl;
+            return;
+        }
+        ring->forEachCqe([&](io_uring_cqe* cqe) { uringHandleCqe(cqe); });
+    }
+}
+
+void Server::uringHandleCqe(const io_uring_cqe* cqe) {
+    uint64_t op = cqe->user_data & 7;
+    bool more = cqe->flags & IORING_CQE_F_MORE;
+
+    if (op == OP_ACCEPT) {
+        const Listener& l = listeners[cqe->user_data >> 3];
+        if (cqe->res >= 0) {
+            tuneClientSocket(cqe->res, l.opts);
+            Client* c = new Client;
+            c->fd = cqe->res;
+            clients[c->fd] = c;
+            trackClient(c);
+            uringArmRecv(c);
+        }
+        if (!more) ring->prepAcceptMultishot(l.fd, cqe->user_data);
+        return;
+    }
+    if (op == OP_CANCEL) return;
+
+    Client* c = dataClient(cqe->user_data);
+    if (op == OP_RECV) {
+        if (!more) {
+            c->recvArmed = false;
+            c->inflight--;
+        }
+        if (cqe->res > 0) {
+            uint16_t bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            if (!c->closing) {
+                TRACE_SCOPE("recv");
+                feedInput(c, ring->buffer(bid), cqe->res);
+                c->lastInteraction = monotonicMs();
+            }
+            ring->recycleBuffer(bid);
+        }
+        if (c->closing) {
+            uringCloseClient(c);
+            return;
+        }
+        if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ENOBUFS && cqe->res != -ECANCELED)) {
+            freeClient(c);  // 客户端关闭或出错
+            return;
+        }
+        if (cqe->res > 0) {
+            if (c->querybuf.size() > QUERYBUF_MAX) {
+                std::cerr << "client fd=" << c->fd << " query buffer too big, closing" << std::endl;
+                freeClient(c);
+                return;
+            }
+            processInput(c);
+            if (c->closeAsap && c->reply.empty()) {
+                freeClient(c);
+                return;
+            }
+            if (c->replyBytes > 0 && !c->pendingSend) {
+                c->pendingSend = true;
+                pendingSends.push_back(c->fd);
+            }
+        }
+        //输出积压太多就停止接收(背压),缓冲区用完(ENOBUFS)或被取消后按需重新挂上
+        if (c->readPaused && c->recvArmed) ring->prepCancel(packData(c, OP_RECV), OP_CANCEL);
+        if (!c->recvArmed && !c->readPaused) uringArmRecv(c);
+        return;
+    }
+
+    if (op == OP_SEND) {
+        c->inflight--;
+        c->sendingChunks = 0;
+        if (c->closing) {
+            uringCloseClient(c);
+            return;
+        }
+        if (cqe->res < 0) {
+            freeClient(c);
+            return;
+        }
+        {
+            TRACE_SCOPE("send_done");
+            consumeReply(c, cqe->res);
+        }
+        if (!afterReplyWritten(c)) return;
+        if (!c->recvArmed && !c->readPaused) uringArmRecv(c);
+        if (c->replyBytes > 0 && !c->pendingSend) {
+            c->pendingSend = true;
+            pendingSends.push_back(c->fd);
+        }
+    }
+}
+
+void Server::uringArmRecv(Client* c) {
+    ring->prepRecvMultishot(c->fd, RECV_BGID, packData(c, OP_RECV));
+    c->recvArmed = true;
+    c->inflight++;
+}
+
+//批量提交:每个客户端一个 sendmsg,一次带上最多 16 个回复块
+void Server::uringFlushSends() {
+    TRACE_SCOPE("prep_sends");
+    for (int fd : pendingSends) {
+        auto it = clients.find(fd);
+        if (it == clients.end()) continue;
+        Client* c = it->second;
+        c->pendingSend = false;
+        if (c->sendingChunks || c->replyBytes == 0) continue;
+
+        size_t n = replyIov(c, c->iov, 16);
+        c->msg = msghdr{};
+        c->msg.msg_iov = c->iov;
+        c->msg.msg_iovlen = n;
+        c->sendingChunks = n;
+        c->inflight++;
+        ring->prepSendmsg(c->fd, &c->msg, packData(c, OP_SEND));
+    }
+    pendingSends.clear();
+}
+
+//先从 clients 摘除并取消 recv,所有提交中的请求都完成后才真正关闭并释放
+void Server::uringCloseClient(Client* c) {
+    if (!c->closing) {
+        c->closing = true;
+        clients.erase(c->fd);
+        if (c->recvArmed) ring->prepCancel(packData(c, OP_RECV), OP_CANCEL);
+    }
+    if (c->inflight == 0) {
+        close(c->fd);
+        delete c;
+    }
+}
@@ -0,0 +1,159 @@
+//有序集合:ZADD/ZINCRBY/ZREM/ZSCORE/ZCARD/ZRANK/ZREVRANK/ZRANGE/ZREVRANGE/ZRANGEBYSCORE/ZREVRANGEBYSCORE/ZCOUNT。
+//结构在 storage/zset.h;分数按 bulk 字符串回复,和 Redis 的 RESP2 一样
+#include "server.h"
+#include "resp.h"
+#include <strings.h>
+#include <cstdlib>
+#include <cmath>
+
+static const char* WRONGTYPE = "WRONGTYPE Operation against a key holding the wrong kind of value";
+static const char* NOT_FLOAT = "ERR value is not a valid float";
+static const char* NOT_INT = "ERR value is not an integer or out of range";
+
+static bool parseInt(const std::string& s, long long& v) {
+    char* end;
+    v = strtoll(s.c_str(), &end, 10);
+    return !s.empty() && !*end;
+}
+
+//范围的端点:"(" 开头表示不含端点,-inf/+inf 表示不限
+static bool parseRangeScore(const std::string& s, double& v, bool& exclusive) {
+    exclusive = !s.empty() && s[0] == '(';
+    return parseScore(exclusive ? s.substr(1) : s, v);
+}
+
+static std::string membersReply(const std::vector<std::pair<std::string, double>>& items, bool withScores) {
+    std::string r = Resp::arrayHeader(items.size() * (withScores ? 2 : 1));
+    for (auto& [member, score] : items) {
+        r += Resp::bulk(member);
+        if (withScores) r += Resp::bulk(formatScore(score));
+    }
+    return r;
+}
+
+// ZADD key [NX|XX] [GT|LT] [CH] [INCR] score member [score member ...] / ZINCRBY key increment member
+std::string Server::zaddCommand(const std::vector<std::string>& cmd, bool incrby) {
+    bool nx = false, xx = false, gt = false, lt = false, ch = false, incr = incrby;
+    size_t i = 2;
+    for (; !incrby && i < cmd.size(); i++) {
+        const char* opt = cmd[i].c_str();
+        if (!strcasecmp(opt, "NX")) nx = true;
+        else if (!strcasecmp(opt, "XX")) xx = true;
+        else if (!strcasecmp(opt, "GT")) gt = true;
+        else if (!strcasecmp(opt, "LT")) lt = true;
+        else if (!strcasecmp(opt, "CH")) ch = true;
+        else if (!strcasecmp(opt, "INCR")) incr = true;
+        else break;
+    }
+    size_t pairs = (cmd.size() - i) / 2;
+    if (pairs == 0 || (cmd.size() - i) % 2) return Resp::error("ERR syntax error");
+    if (nx && xx) return Resp::error("ERR XX and NX options at the same time are not compatible");
+    if ((gt && lt) || (nx && (gt || lt))) return Resp::error("ERR GT, LT, and/or NX options at the same time are not compatible");
+    if (incr && pairs > 1) return Resp::error("ERR INCR option supports a single increment-element pair");
+    std::vector<double> scores(pairs);
+    for (size_t k = 0; k < pairs; k++)
+        if (!parseScore(cmd[i + 2 * k], scores[k])) return Resp::error(NOT_FLOAT);
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+
+    ZSet* z = engine.zsetWrite(cmd[1], !xx);
+    long long added = 0, changed = 0;
+    double result = 0;
+    bool skipped = false;
+    for (size_t k = 0; z && k < pairs; k++) {
+        const std::string& member = cmd[i + 2 * k + 1];
+        double cur, score = scores[k];
+        bool exists = z->score(member, cur);
+        if ((nx && exists) || (xx && !exists)) {
+            skipped = true;
+            continue;
+        }
+        if (incr && exists) {
+            score += cur;
+            if (std::isnan(score)) return Resp::error("ERR resulting score is not a number (NaN)");
+        }
+        if (exists && ((gt && score <= cur) || (lt && score >= cur))) {
+            skipped = true;
+            continue;
+        }
+        result = score;
+        if (z->add(member, score)) added++;
+        else if (exists && score != cur) changed++;
+    }
+    if (z && z->size() == 0) engine.del(cmd[1]);     // XX 之类的选项让新建的集合一个成员都没加进去
+    if (incr) return skipped || !z ? Resp::nullBulk() : Resp::bulk(formatScore(result));
+    return Resp::integer(ch ? added + changed : added);
+}
+
+std::string Server::zremCommand(const std::vector<std::string>& cmd) {
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+    ZSet* z = engine.zsetWrite(cmd[1], false);
+    long long removed = 0;
+    for (size_t i = 2; z && i < cmd.size(); i++) removed += z->remove(cmd[i]);
+    if (z && z->size() == 0) engine.del(cmd[1]);
+    return Resp::integer(removed);
+}
+
+std::string Server::zscoreCommand(const std::vector<std::string>& cmd) {
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+    ZSet* z = engine.zsetRead(cmd[1]);
+    double score;
+    if (!z || !z->score(cmd[2], score)) return Resp::nullBulk();
+    return Resp::bulk(formatScore(score));
+}
+
+std::string Server::zrankCommand(const std::vector<std::string>& cmd, bool reverse) {
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+    ZSet* z = engine.zsetRead(cmd[1]);
+    long long r = z ? z->rank(cmd[2], reverse) : -1;
+    return r < 0 ? Resp::nullBulk() : Resp::integer(r);
+}
+
+// ZRANGE/ZREVRANGE key start stop [WITHSCORES]:负数下标从末尾数
+std::string Server::zrangeCommand(const std::vector<std::string>& cmd, bool reverse) {
+    long long start, stop;
+    if (!parseInt(cmd[2], start) || !parseInt(cmd[3], stop)) return Resp::error(NOT_INT);
+    bool withScores = cmd.size() == 5;
+    if (withScores && strcasecmp(cmd[4].c_str(), "WITHSCORES")) return Resp::error("ERR syntax error");
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+    ZSet* z = engine.zsetRead(cmd[1]);
+    if (!z) return Resp::arrayHeader(0);
+    long long len = z->size();
+    if (start < 0) start += len;
+    if (stop < 0) stop += len;
+    if (start < 0) start = 0;
+    if (start > stop || start >= len) return Resp::arrayHeader(0);
+    return membersReply(z->rangeByRank(start, stop, reverse), withScores);
+}
+
+// ZRANGEBYSCORE key min max [WITHSCORES] [LIMIT offset count];ZREVRANGEBYSCORE 先 max 后 min
+std::string Server::zrangebyscoreCommand(const std::vector<std::string>& cmd, bool reverse) {
+    ZRangeSpec range;
+    if (!parseRangeScore(cmd[reverse ? 3 : 2], range.min, range.minex) ||
+        !parseRangeScore(cmd[reverse ? 2 : 3], range.max, range.maxex))
+        return Resp::error("ERR min or max is not a float");
+    bool withScores = false;
+    long long offset = 0, count = -1;
+    for (size_t i = 4; i < cmd.size(); i++) {
+        if (!strcasecmp(cmd[i].c_str(), "WITHSCORES")) {
+            withScores = true;
+        } else if (!strcasecmp(cmd[i].c_str(), "LIMIT") && i + 2 < cmd.size()) {
+            if (!parseInt(cmd[i + 1], offset) || !parseInt(cmd[i + 2], count)) return Resp::error(NOT_INT);
+            i += 2;
+        } else {
+            return Resp::error("ERR syntax error");
+        }
+    }
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+    ZSet* z = engine.zsetRead(cmd[1]);
+    if (!z || offset < 0 || count == 0) return Resp::arrayHeader(0);
+    return membersReply(z->rangeByScore(range, reverse, offset, count < 0 ? 0 : count), withScores);
+}
+
+std::string Server::zcountCommand(const std::vector<std::string>& cmd) {
+    ZRangeSpec range;
+    if (!parseRangeScore(cmd[2], range.min, range.minex) || !parseRangeScore(cmd[3], range.max, range.maxex))
+        return Resp::error("ERR min or max is not a float");
+    if (!engine.checkType(cmd[1], OBJ_ZSET)) return Resp::error(WRONGTYPE);
+    ZSet* z = engine.zsetRead(cmd[1]);
+    return Resp::integer(z ? z->count(range) : 0);
+}
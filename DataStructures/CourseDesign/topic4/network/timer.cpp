@@ -0,0 +1,152 @@
+#include "timer.h"
+#include <ctime>
+
+uint64_t monotonicMs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+TimerWheel::TimerWheel(uint64_t nowMs) : now(nowMs) {
+    for (auto& h : heads) h = NIL;
+}
+
+//第 level 层(>= 1)的格子从第几位开始取
+static int levelShift(int level) {
+    return 8 + 6 * (level - 1);
+}
+
+//按剩余时间选层:第 0 层按到期时间的低 8 位放,第 L 层按对应的 6 位放
+void TimerWheel::place(uint32_t idx) {
+    Node& n = nodes[idx];
+    uint64_t expire = n.expire < now ? now : n.expire;
+    uint64_t delta = expire - now;
+    uint32_t b;
+    if (delta < LEVEL0_SIZE) {
+        b = expire & (LEVEL0_SIZE - 1);
+    } else {
+        int level = 1;
+        while (level < LEVELS - 1 && delta >= (1ULL << levelShift(level + 1))) level++;
+        if (delta >= (1ULL << levelShift(LEVELS))) {
+            expire = now + (1ULL << levelShift(LEVELS)) - 1;
+            n.expire = expire;
+        }
+        b = LEVEL0_SIZE + (level - 1) * LEVEL_SIZE + ((expire >> levelShift(level)) & (LEVEL_SIZE - 1));
+    }
+    n.bucket = b;
+    n.prev = NIL;
+    n.next = heads[b];
+    if (heads[b] != NIL) nodes[heads[b]].prev = idx;
+    heads[b] = idx;
+    occupied[b / 64] |= 1ULL << (b % 64);
+}
+
+void TimerWheel::unlink(uint32_t idx) {
+    Node& n = nodes[idx];
+    if (n.prev != NIL) nodes[n.prev].next = n.next;
+    else heads[n.bucket] = n.next;
+    if (n.next != NIL) nodes[n.next].prev = n.prev;
+    if (heads[n.bucket] == NIL) occupied[n.bucket / 64] &= ~(1ULL << (n.bucket % 64));
+}
+
+void TimerWheel::release(uint32_t idx) {
+    Node& n = nodes[idx];
+    n.bucket = NIL;
+    n.gen++;
+    n.cb = nullptr;
+    n.next = freeList;
+    freeList = idx;
+    count--;
+}
+
+TimerId TimerWheel::add(uint64_t expireMs, std::function<void()> cb) {
+    uint32_t idx;
+    if (freeList != NIL) {
+        idx = freeList;
+        freeList = nodes[idx].next;
+    } else {
+        idx = nodes.size();
+        nodes.push_back(Node{0, NIL, NIL, NIL, 0, nullptr});
+    }
+    nodes[idx].expire = expireMs;
+    nodes[idx].cb = std::move(cb);
+    place(idx);
+    count++;
+    return (uint64_t)nodes[idx].gen << 32 | idx;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    uint32_t idx = id & 0xFFFFFFFF;
+    if (idx >= nodes.size() || nodes[idx].gen != (id >> 32) || nodes[idx].bucket == NIL) return false;
+    unlink(idx);
+    release(idx);
+    return true;
+}
+
+//把第 level 层当前格子里的定时器全部重新放置,它们会落到更低的层
+void TimerWheel::cascade(int level) {
+    uint32_t b = LEVEL0_SIZE + (level - 1) * LEVEL_SIZE + ((now >> levelShift(level)) & (LEVEL_SIZE - 1));
+    uint32_t idx = heads[b];
+    heads[b] = NIL;
+    occupied[b / 64] &= ~(1ULL << (b % 64));
+    while (idx != NIL) {
+        uint32_t next = nodes[idx].next;
+        place(idx);
+        idx = next;
+    }
+}
+
+int64_t TimerWheel::nextLevel0(uint64_t from, uint64_t limit) const {
+    while (from < limit) {
+        uint32_t b = from & (LEVEL0_SIZE - 1);
+        uint64_t bits = occupied[b / 64] >> (b % 64);
+        if (bits) {
+            uint64_t t = from + __builtin_ctzll(bits);
+            return t < limit ? (int64_t)t : -1;
+        }
+        from += 64 - b % 64;
+    }
+    return -1;
+}
+
+void TimerWheel::advance(uint64_t nowMs) {
+    while (now <= nowMs) {
+        if ((now & (LEVEL0_SIZE - 1)) == 0) {
+            for (int level = 1; level < LEVELS; level++) {
+                cascade(level);
+                if ((now >> levelShift(level)) & (LEVEL_SIZE - 1)) break;
+            }
+        }
+        //一个一个摘下来执行:回调可能取消同一格里的其他定时器
+        uint32_t b = now & (LEVEL0_SIZE - 1);
+        while (heads[b] != NIL) {
+            uint32_t idx = heads[b];
+            unlink(idx);
+            std::function<void()> cb = std::move(nodes[idx].cb);
+            release(idx);
+            cb();
+        }
+        //跳到下一个非空格子,但不越过第 0 层一圈的终点(那里要级联)
+        uint64_t blockEnd = (now | (LEVEL0_SIZE - 1)) + 1;
+        int64_t next = nextLevel0(now + 1, blockEnd);
+        uint64_t target = next >= 0 ? (uint64_t)next : blockEnd;
+        now = target <= nowMs ? target : nowMs + 1;
+    }
+}
+
+int TimerWheel::nextTimeoutMs(uint64_t nowMs, int maxMs) const {
+    if (count == 0) return maxMs;
+    //第 0 层的格子是环形的:先看这一圈剩下的,再看绕回来的部分(属于下一圈)
+    uint64_t blockEnd = (now | (LEVEL0_SIZE - 1)) + 1;
+    int64_t t = nextLevel0(now, blockEnd);
+    if (t < 0) {
+        //高层有定时器就在下一个级联点醒来;now 正好在一圈的起点时,这次级联还没做
+        bool higher = false;
+        for (uint32_t i = LEVEL0_SIZE / 64; i < BUCKETS / 64; i++) higher = higher || occupied[i];
+        uint64_t cascadeAt = (now & (LEVEL0_SIZE - 1)) == 0 ? now : blockEnd;
+        int64_t wrapped = nextLevel0(blockEnd, blockEnd + (now & (LEVEL0_SIZE - 1)));
+        t = higher || wrapped < 0 ? (int64_t)cascadeAt : wrapped;
+    }
+    uint64_t wait = (uint64_t)t > nowMs ? t - nowMs : 0;
+    return maxMs >= 0 && wait > (uint64_t)maxMs ? maxMs : (int)wait;
+}
@@ -0,0 +1,61 @@
+/*分层时间轮(与 Linux 内核早期的 timer wheel 相同的思路),精度 1 毫秒:
+    第 0 层 256 格,每格 1ms,放 256ms 以内到期的定时器
+    第 1~4 层各 64 格,每格分别是 2^8、2^14、2^20、2^26 毫秒,最远约 49 天,更远的按 49 天算
+时间走到某一层一格的起点时,把上一层对应格子里的定时器重新分配到下面的层(级联),
+所以每个定时器最多被搬动 4 次。插入、取消都是 O(1),取消不需要查找。
+每个格子有一位"非空"标记,推进时间和计算下一次到期时直接跳过空格子。
+定时器节点放在数组里复用,TimerId 带代数,节点被复用后旧的 TimerId 取消时不会误删。
+时间都是单调时钟的毫秒数(monotonicMs)*/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+using TimerId = uint64_t;
+
+uint64_t monotonicMs();
+
+class TimerWheel {
+public:
+    explicit TimerWheel(uint64_t nowMs);
+
+    TimerId add(uint64_t expireMs, std::function<void()> cb);   // expireMs 是绝对时间
+    bool cancel(TimerId id);                                     //已经触发或不存在时返回 false
+    //执行所有到期的回调;回调里可以添加、取消定时器(包括同一轮里别的到期定时器)
+    void advance(uint64_t nowMs);
+    //距离下一次需要 advance 还有多少毫秒,没有定时器时返回 maxMs;事件循环用它当等待超时。
+    //只有高层有定时器时返回第 0 层转完一圈的时间,到时级联后再算
+    int nextTimeoutMs(uint64_t nowMs, int maxMs) const;
+    size_t size() const { return count; }
+
+private:
+    static const int LEVEL0_BITS = 8;
+    static const int LEVEL_BITS = 6;
+    static const int LEVELS = 5;
+    static const uint32_t LEVEL0_SIZE = 1 << LEVEL0_BITS;
+    static const uint32_t LEVEL_SIZE = 1 << LEVEL_BITS;
+    static const uint32_t BUCKETS = LEVEL0_SIZE + (LEVELS - 1) * LEVEL_SIZE;
+    static const uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        uint64_t expire;
+        uint32_t prev, next;     //同一个格子里的双向链表,下标;空闲节点用 next 串成空闲链表
+        uint32_t bucket;         //所在格子,NIL 表示空闲
+        uint32_t gen;
+        std::function<void()> cb;
+    };
+
+    void place(uint32_t idx);
+    void unlink(uint32_t idx);
+    void release(uint32_t idx);
+    void cascade(int level);
+    int64_t nextLevel0(uint64_t from, uint64_t limit) const;   //[from, limit) 里第一个非空格子的时间,没有返回 -1
+
+    std::vector<Node> nodes;
+    uint32_t freeList = NIL;
+    uint32_t heads[BUCKETS];
+    uint64_t occupied[BUCKETS / 64] = {0};
+    uint64_t now;            //下一个要处理的毫秒
+    size_t count = 0;
+};
@@ -0,0 +1,178 @@
+/*时间轮与二叉堆定时器队列的对比基准。
+二叉堆是常见的另一种实现(libevent、早期 nginx 用红黑树、Go 的 runtime 用四叉堆):
+插入、取消都是 O(log n),取消要靠每个节点记住自己在堆里的下标。
+场景(n 个定时器,到期时间在 [1ms, 60s] 内均匀分布):
+  add      连续插入 n 个
+  cancel   取消一半(随机顺序)
+  expire   时间以 1ms 为步长向前走,直到剩下的全部触发
+  churn    保持 n 个定时器,反复"取消一个再插一个"(客户端空闲超时被重置就是这样)
+编译: g++ -std=c++17 -O2 -o timer_benchmark timer_benchmark.cpp timer.cpp
+用法: ./timer_benchmark [n ...]     默认 10000 100000 1000000 */
+#include "timer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+//带下标的二叉最小堆,按到期时间排序
+class HeapTimers {
+public:
+    TimerId add(uint64_t expire, std::function<void()> cb) {
+        uint32_t idx;
+        if (!freeSlots.empty()) {
+            idx = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            idx = timers.size();
+            timers.emplace_back();
+        }
+        timers[idx] = Timer{expire, std::move(cb), (uint32_t)heap.size(), timers[idx].gen};
+        heap.push_back(idx);
+        up(heap.size() - 1);
+        return (uint64_t)timers[idx].gen << 32 | idx;
+    }
+
+    bool cancel(TimerId id) {
+        uint32_t idx = id & 0xFFFFFFFF;
+        if (idx >= timers.size() || timers[idx].gen != (id >> 32) || timers[idx].pos == NIL) return false;
+        removeAt(timers[idx].pos);
+        return true;
+    }
+
+    void advance(uint64_t now) {
+        while (!heap.empty() && timers[heap[0]].expire <= now) {
+            uint32_t idx = heap[0];
+            std::function<void()> cb = std::move(timers[idx].cb);
+            removeAt(0);
+            cb();
+        }
+    }
+
+    size_t size() const { return heap.size(); }
+
+private:
+    static const uint32_t NIL = UINT32_MAX;
+    struct Timer {
+        uint64_t expire = 0;
+        std::function<void()> cb;
+        uint32_t pos = NIL;
+        uint32_t gen = 0;
+    };
+
+    bool less(size_t a, size_t b) const { return timers[heap[a]].expire < timers[heap[b]].expire; }
+    void swapAt(size_t a, size_t b) {
+        std::swap(heap[a], heap[b]);
+        timers[heap[a]].pos = a;
+        timers[heap[b]].pos = b;
+    }
+    void up(size_t i) {
+        timers[heap[i]].pos = i;
+        while (i > 0 && less(i, (i - 1) / 2)) {
+            swapAt(i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+    }
+    void down(size_t i) {
+        while (true) {
+            size_t l = 2 * i + 1, m = i;
+            if (l < heap.size() && less(l, m)) m = l;
+            if (l + 1 < heap.size() && less(l + 1, m)) m = l + 1;
+            if (m == i) return;
+            swapAt(i, m);
+            i = m;
+        }
+    }
+    void removeAt(size_t i) {
+        uint32_t idx = heap[i];
+        swapAt(i, heap.size() - 1);
+        heap.pop_back();
+        if (i < heap.size()) {
+            down(i);
+            up(i);
+        }
+        timers[idx].pos = NIL;
+        timers[idx].gen++;
+        timers[idx].cb = nullptr;
+        freeSlots.push_back(idx);
+    }
+
+    std::vector<Timer> timers;
+    std::vector<uint32_t> heap;
+    std::vector<uint32_t> freeSlots;
+};
+
+struct Result {
+    double add, cancel, expire, churn;   //每次操作的纳秒数
+};
+
+static double nsPer(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+template <class Q>
+static Result run(size_t n, uint64_t seed) {
+    const uint64_t base = 1000000, span = 60000;
+    std::mt19937_64 rng(seed);
+    std::vector<uint64_t> expires(n);
+    for (auto& e : expires) e = base + 1 + rng() % span;
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; i++) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    Result r;
+    Q q(base);
+    size_t fired = 0;
+    std::vector<TimerId> ids(n);
+    auto t = Clock::now();
+    for (size_t i = 0; i < n; i++) ids[i] = q.add(expires[i], [&fired] { fired++; });
+    r.add = nsPer(t, n);
+
+    t = Clock::now();
+    for (size_t i = 0; i < n / 2; i++) q.cancel(ids[order[i]]);
+    r.cancel = nsPer(t, n / 2);
+
+    t = Clock::now();
+    for (uint64_t now = base; q.size() > 0; now++) q.advance(now);
+    r.expire = nsPer(t, n - n / 2);
+
+    //churn:先插满 n 个,再做 n 次"取消随机一个 + 插入一个新的"
+    for (size_t i = 0; i < n; i++) ids[i] = q.add(base + span + 1 + rng() % span, [&fired] { fired++; });
+    t = Clock::now();
+    for (size_t i = 0; i < n; i++) {
+        size_t k = order[i];
+        q.cancel(ids[k]);
+        ids[k] = q.add(base + span + 1 + rng() % span, [&fired] { fired++; });
+    }
+    r.churn = nsPer(t, n);
+    if (fired != n - n / 2) std::cerr << "unexpected fire count " << fired << std::endl;
+    return r;
+}
+
+//让 HeapTimers 和 TimerWheel 有同样的构造方式
+struct Heap : HeapTimers {
+    explicit Heap(uint64_t) {}
+};
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back(strtoull(argv[i], nullptr, 10));
+    if (sizes.empty()) sizes = {10000, 100000, 1000000};
+
+    std::cout << std::left << std::setw(10) << "n" << std::setw(8) << "queue"
+              << std::right << std::setw(10) << "add" << std::setw(10) << "cancel"
+              << std::setw(10) << "expire" << std::setw(10) << "churn" << "   (ns/op)\n";
+    for (size_t n : sizes) {
+        Result w = run<TimerWheel>(n, 42);
+        Result h = run<Heap>(n, 42);
+        for (auto& [name, r] : {std::make_pair("wheel", w), std::make_pair("heap", h)}) {
+            std::cout << std::left << std::setw(10) << n << std::setw(8) << name << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(10) << r.add << std::setw(10) << r.cancel
+                      << std::setw(10) << r.expire << std::setw(10) << r.churn << "\n";
+        }
+    }
+}
@@ -0,0 +1,253 @@
+#include "uring.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdlib>
+
+static int sysSetup(unsigned entries, io_uring_params* p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sysEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+static int sysRegister(int fd, unsigned op, void* arg, unsigned nr) {
+    return (int)syscall(__NR_io_uring_register, fd, op, arg, nr);
+}
+
+Uring::~Uring() {
+    if (bufRing) munmap(bufRing, bufRingSize);
+    free(bufBase);
+    if (sqes) munmap(sqes, sqesSize);
+    if (cqPtr && cqPtr != sqPtr) munmap(cqPtr, cqSize);
+    if (sqPtr) munmap(sqPtr, sqSize);
+    if (ringFd >= 0) close(ringFd);
+}
+
+bool Uring::init(unsigned entries) {
+    io_uring_params p{};
+    //单线程提交 + 协作式任务处理,能省掉一部分中断;老内核不支持就退回默认参数
+    p.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    ringFd = sysSetup(entries, &p);
+    if (ringFd < 0) {
+        memset(&p, 0, sizeof(p));
+        ringFd = sysSetup(entries, &p);
+    }
+    if (ringFd < 0) return false;
+
+    sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    extArg = p.features & IORING_FEAT_EXT_ARG;
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (cqSize > sqSize) sqSize = cqSize;
+        cqSize = sqSize;
+    }
+    sqPtr = mmap(nullptr, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqPtr == MAP_FAILED) { sqPtr = nullptr; return false; }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        cqPtr = sqPtr;
+    } else {
+        cqPtr = mmap(nullptr, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqPtr == MAP_FAILED) { cqPtr = nullptr; return false; }
+    }
+    sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+    void* s = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (s == MAP_FAILED) return false;
+    sqes = static_cast<io_uring_sqe*>(s);
+
+    char* sq = static_cast<char*>(sqPtr);
+    sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    sqEntries = p.sq_entries;
+    sqeTail = submitted = *sqTail;
+
+    char* cq = static_cast<char*>(cqPtr);
+    cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    return true;
+}
+
+bool Uring::setupBufRing(unsigned count, unsigned size, uint16_t bgid) {
+    bufCount = count;
+    bufSize = size;
+    bufGroup = bgid;
+    bufBase = static_cast<char*>(malloc((size_t)count * size));
+    if (!bufBase) return false;
+
+    bufRingSize = count * sizeof(io_uring_buf);
+    void* r = mmap(nullptr, bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (r != MAP_FAILED) {
+        bufRing = static_cast<io_uring_buf_ring*>(r);
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(bufRing);
+        reg.ring_entries = count;
+        reg.bgid = bgid;
+        if (sysRegister(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0) {
+            bufTail = 0;
+            for (unsigned i = 0; i < count; i++) recycleBuffer(i);
+            if (probeBufferSelect()) return true;
+            //有的内核能注册 buffer ring 却取不到缓冲区,注销掉改用老接口
+            sysRegister(ringFd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        }
+        munmap(bufRing, bufRingSize);
+        bufRing = nullptr;
+    }
+
+    // 5.7+ 都支持的 IORING_OP_PROVIDE_BUFFERS,一次把所有缓冲区交给内核
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = count;
+    sqe->addr = reinterpret_cast<uint64_t>(bufBase);
+    sqe->len = size;
+    sqe->off = 0;
+    sqe->buf_group = bgid;
+    if (submitAndWait(1) < 0) return false;
+    int res = -1;
+    forEachCqe([&](io_uring_cqe* cqe) { res = cqe->res; }, true);
+    return res >= 0 && probeBufferSelect();
+}
+
+//用一对本地 socket 试收一次,确认内核真的能从缓冲区组里挑出缓冲区
+bool Uring::probeBufferSelect() {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) return false;
+    bool ok = false;
+    if (write(sv[1], "x", 1) == 1) {
+        io_uring_sqe* sqe = getSqe();
+        if (sqe) {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = sv[0];
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = bufGroup;
+            if (submitAndWait(1) >= 0) {
+                forEachCqe([&](io_uring_cqe* cqe) {
+                    if (cqe->res == 1 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+                        ok = true;
+                        recycleBuffer(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+                    }
+                }, true);
+            }
+        }
+    }
+    close(sv[0]);
+    close(sv[1]);
+    return ok;
+}
+
+void Uring::recycleBuffer(uint16_t bid) {
+    if (!bufRing) {
+        //老接口:每还一个缓冲区要一个 SQE,跟着下一次提交一起发给内核
+        io_uring_sqe* sqe = getSqe();
+        if (!sqe) return;
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = 1;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer(bid));
+        sqe->len = bufSize;
+        sqe->off = bid;
+        sqe->buf_group = bufGroup;
+        return;
+    }
+    io_uring_buf* b = &bufRing->bufs[bufTail & (bufCount - 1)];
+    b->addr = reinterpret_cast<uint64_t>(buffer(bid));
+    b->len = bufSize;
+    b->bid = bid;
+    bufTail++;
+    __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+}
+
+io_uring_sqe* Uring::getSqe() {
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (sqeTail - head >= sqEntries) {
+        submitAndWait(0);
+        head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (sqeTail - head >= sqEntries) return nullptr;
+    }
+    unsigned idx = sqeTail & *sqMask;
+    sqArray[idx] = idx;
+    io_uring_sqe* sqe = &sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqeTail++;
+    return sqe;
+}
+
+int Uring::submitAndWait(unsigned waitNr) {
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = sqeTail - submitted;
+    submitted = sqeTail;
+    if (toSubmit == 0 && waitNr == 0) return 0;
+    return sysEnter(ringFd, toSubmit, waitNr, waitNr ? IORING_ENTER_GETEVENTS : 0);
+}
+
+//老内核没有 EXT_ARG:附带一个 IORING_OP_TIMEOUT,等到 waitNr 个完成或超时就结束,
+//它的 CQE 的 user_data 为 0,按内部请求处理
+int Uring::submitAndWait(unsigned waitNr, int timeoutMs) {
+    if (timeoutMs < 0) return submitAndWait(waitNr);
+    waitTs.tv_sec = timeoutMs / 1000;
+    waitTs.tv_nsec = timeoutMs % 1000 * 1000000LL;
+    if (!extArg) {
+        io_uring_sqe* sqe = getSqe();
+        if (sqe) {
+            sqe->opcode = IORING_OP_TIMEOUT;
+            sqe->fd = -1;
+            sqe->addr = reinterpret_cast<uint64_t>(&waitTs);
+            sqe->len = 1;
+            sqe->off = waitNr;
+        }
+        return submitAndWait(waitNr);
+    }
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = sqeTail - submitted;
+    submitted = sqeTail;
+    io_uring_getevents_arg arg{};
+    arg.ts = reinterpret_cast<uint64_t>(&waitTs);
+    return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, waitNr,
+                        IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+void Uring::prepAcceptMultishot(int fd, uint64_t data) {
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = data;
+}
+
+void Uring::prepRecvMultishot(int fd, uint16_t bgid, uint64_t data) {
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = bgid;
+    sqe->user_data = data;
+}
+
+void Uring::prepSendmsg(int fd, const msghdr* msg, uint64_t data) {
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = data;
+}
+
+void Uring::prepCancel(uint64_t target, uint64_t data) {
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    sqe->user_data = data;
+}
+
@@ -0,0 +1,74 @@
+/*不依赖 liburing 的最小 io_uring 封装,直接走系统调用。
+只实现服务器用到的几个操作:多发 accept、带 provided buffer ring 的多发 recv、
+sendmsg、取消,以及带超时的等待*/
+#pragma once
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/socket.h>
+#include <cstdint>
+#include <cstddef>
+
+class Uring {
+public:
+    ~Uring();
+    bool init(unsigned entries);
+    //注册一组 count 个、每个 size 字节的接收缓冲区,count 必须是 2 的幂。
+    //优先用 provided buffer ring,内核不支持时退回 IORING_OP_PROVIDE_BUFFERS
+    bool setupBufRing(unsigned count, unsigned size, uint16_t bgid);
+    bool usingBufRing() const { return bufRing != nullptr; }
+
+    io_uring_sqe* getSqe();              //取一个空闲 SQE,SQ 满时先提交已有的
+    int submitAndWait(unsigned waitNr);  //提交所有已准备的 SQE,至少等 waitNr 个完成
+    //同上,但最多等 timeoutMs 毫秒(负数表示一直等),超时返回 -1 且 errno 为 ETIME
+    int submitAndWait(unsigned waitNr, int timeoutMs);
+
+    //遍历当前所有已完成的 CQE,遍历完统一推进 CQ 头。
+    // user_data 为 0 的是内部请求(归还缓冲区等),默认不交给调用方
+    template <class F>
+    void forEachCqe(F f, bool internal = false) {
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            io_uring_cqe* cqe = &cqes[head & *cqMask];
+            if (internal || cqe->user_data != 0) f(cqe);
+            head++;
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    char* buffer(uint16_t bid) { return bufBase + (size_t)bid * bufSize; }
+    void recycleBuffer(uint16_t bid);    //把用完的接收缓冲区还给内核
+
+    void prepAcceptMultishot(int fd, uint64_t data);
+    void prepRecvMultishot(int fd, uint16_t bgid, uint64_t data);
+    void prepSendmsg(int fd, const msghdr* msg, uint64_t data);
+    void prepCancel(uint64_t target, uint64_t data);
+
+private:
+    int ringFd = -1;
+    void* sqPtr = nullptr;
+    size_t sqSize = 0;
+    void* cqPtr = nullptr;
+    size_t cqSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned sqEntries = 0;
+    unsigned sqeTail = 0;       //本地已准备到的位置
+    unsigned submitted = 0;     //已经交给内核的位置
+    bool extArg = false;        //内核支持 IORING_ENTER_EXT_ARG,等待超时可以直接传给 io_uring_enter
+    __kernel_timespec waitTs{};
+    unsigned *cqHead, *cqTail, *cqMask;
+    io_uring_cqe* cqes = nullptr;
+
+    bool probeBufferSelect();
+
+    io_uring_buf_ring* bufRing = nullptr;
+    size_t bufRingSize = 0;
+    char* bufBase = nullptr;
+    unsigned bufCount = 0;
+    unsigned bufSize = 0;
+    uint16_t bufTail = 0;
+    uint16_t bufGroup = 0;
+};
@@ -1,17 +1,572 @@
+/*存储引擎基准测试,用来对比不同提交之间的性能变化。
+每个用例:先预热(不计时),再重复测 repetitions 次,报告每次操作耗时的中位数/均值/标准差。
+准备数据(预先插入、生成 key 序列)不计入时间,同一个 seed 下每次运行的 key 序列完全相同。
+用例:
+    SET/GET_HIT/GET_MISS/DEL/OVERWRITE  ×  uniform/zipfian 分布  ×  16B/4096B 值
+    MEM/...  每个 key(或每个哈希字段)占用的堆内存
+    SET/GET_HIT/MEM .../json/<大小>/raw|lz4  JSON 值不压缩和 LZ4 压缩存放的耗时与内存对比
+    SET/DEL/PREFIX .../keyindex/on|off  维护 key 索引的额外开销,前缀查询用索引和全表扫描的对比
+    MEM/keyindex/<key 形状>  key 索引本身每个 key 占用的内存
+    XADD/XRANGE/MEM .../stream  流的追加、按 ID 范围读 10 条和每条消息的内存
+    GEOADD/GEOSEARCH/MEM .../geo  位置写入有序集合,1km 半径搜索只扫邻近格子(cells)和扫整个集合(scan)的对比
+用法:
+    ./benchmark [--seed 42] [--keys 100000] [--ops 200000] [--repetitions 5] [--warmup 0.2]
+                [--filter GET] [--json result.json] [--label <提交号>]
+编译: g++ -std=c++17 -O2 -pthread -o benchmark benchmark.cpp storage.cpp dict.cpp concurrent_dict.cpp \
+          epoch.cpp sds.cpp listpack.cpp object.cpp hashfunc.cpp slot.cpp hyperloglog.cpp bloom.cpp lazyfree.cpp \
+          lz4.cpp rax.cpp stream.cpp zset.cpp geo.cpp trace.cpp */
 #include "storage.h"
+#include "geo.h"
+#include <malloc.h>
+#include <unistd.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
-int main() {
-    StorageEngine engine;
-    const int N = 100000;
+using Clock = std::chrono::steady_clock;
 
-    auto start = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < N; ++i)
-        engine.set("key" + std::to_string(i), "value");
-    auto end = std::chrono::high_resolution_clock::now();
+struct Options {
+    uint64_t seed = 42;
+    size_t keys = 100000;
+    size_t ops = 200000;
+    int repetitions = 5;
+    double warmupSeconds = 0.2;
+    std::string filter;
+    std::string json;
+    std::string label;
+};
 
-    std::cout << "SET QPS: "
-              << N / std::chrono::duration<double>(end - start).count()
-              << std::endl;
+struct Result {
+    std::string name;
+    size_t ops = 0;                 //每次重复执行的操作数
+    std::vector<double> nsPerOp;    //每次重复的结果
+    double bytesPerItem = -1;       //内存用例才有
+};
+
+//YCSB 的 zipfian 生成器(Gray 等人的算法),theta 越大越集中在少数热点
+class Zipfian {
+public:
+    Zipfian(size_t n, double theta = 0.99) : n(n), theta(theta) {
+        zetan = zeta(n);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta(2) / zetan);
+    }
+    //返回排名(0 最热)
+    size_t next(std::mt19937_64& rng) {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        double uz = u * zetan;
+        if (uz < 1) return 0;
+        if (uz < 1 + std::pow(0.5, theta)) return 1;
+        return std::min(n - 1, (size_t)(n * std::pow(eta * u - eta + 1, alpha)));
+    }
+private:
+    double zeta(size_t m) const {
+        double s = 0;
+        for (size_t i = 1; i <= m; i++) s += 1 / std::pow((double)i, theta);
+        return s;
+    }
+    size_t n;
+    double theta, zetan, alpha, eta;
+};
+
+enum class Op { Set, GetHit, GetMiss, Del, Overwrite };
+enum class Dist { Uniform, Zipfian };
+
+static const char* opName(Op op) {
+    switch (op) {
+        case Op::Set: return "SET";
+        case Op::GetHit: return "GET_HIT";
+        case Op::GetMiss: return "GET_MISS";
+        case Op::Del: return "DEL";
+        case Op::Overwrite: return "OVERWRITE";
+    }
+    return "?";
+}
+
+static std::string keyName(size_t id) {
+    return "key:" + std::to_string(id);
+}
+
+//按分布生成 count 个 key 编号;zipfian 的排名打散到整个 key 空间,热点不会挤在一起
+static std::vector<size_t> keyIds(Dist dist, size_t keyspace, size_t count, std::mt19937_64& rng) {
+    std::vector<size_t> ids(count);
+    if (dist == Dist::Uniform) {
+        std::uniform_int_distribution<size_t> u(0, keyspace - 1);
+        for (auto& id : ids) id = u(rng);
+    } else {
+        Zipfian z(keyspace);
+        for (auto& id : ids) id = (z.next(rng) * 0x9E3779B97F4A7C15ull) % keyspace;
+    }
+    return ids;
+}
+
+static double seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static size_t heapUsed() {
+    return mallinfo2().uordblks;
+}
+
+class Runner {
+public:
+    explicit Runner(const Options& opts) : opts(opts) {}
+
+    //runOnce 自己准备数据,只返回计时部分的秒数
+    void timed(const std::string& name, size_t ops, const std::function<double()>& runOnce) {
+        if (!selected(name)) return;
+        auto warmStart = Clock::now();
+        do runOnce(); while (seconds(warmStart) < opts.warmupSeconds);
+        Result r;
+        r.name = name;
+        r.ops = ops;
+        for (int i = 0; i < opts.repetitions; i++) r.nsPerOp.push_back(runOnce() * 1e9 / ops);
+        print(r);
+        results.push_back(r);
+    }
+
+    void memory(const std::string& name, double bytesPerItem) {
+        Result r;
+        r.name = name;
+        r.bytesPerItem = bytesPerItem;
+        std::cout << std::left << std::setw(36) << name << std::right << std::setw(12) << std::fixed
+                  << std::setprecision(1) << bytesPerItem << " bytes/item" << std::endl;
+        results.push_back(r);
+    }
+
+    bool selected(const std::string& name) const {
+        return opts.filter.empty() || name.find(opts.filter) != std::string::npos;
+    }
+
+    void writeJson() const;
+
+private:
+    static double median(std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        size_t n = v.size();
+        return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+    }
+    static double mean(const std::vector<double>& v) {
+        double s = 0;
+        for (double x : v) s += x;
+        return s / v.size();
+    }
+    static double stddev(const std::vector<double>& v) {
+        if (v.size() < 2) return 0;
+        double m = mean(v), s = 0;
+        for (double x : v) s += (x - m) * (x - m);
+        return std::sqrt(s / (v.size() - 1));
+    }
+
+    void print(const Result& r) const {
+        double med = median(r.nsPerOp);
+        std::cout << std::left << std::setw(36) << r.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << med << " ns/op  ±" << std::setw(6) << stddev(r.nsPerOp)
+                  << std::setw(14) << (long long)(1e9 / med) << " ops/s" << std::endl;
+    }
+
+    const Options& opts;
+    std::vector<Result> results;
+};
+
+//字段名沿用 Google Benchmark 的 JSON 格式,方便用现成的对比脚本
+void Runner::writeJson() const {
+    std::ofstream out(opts.json);
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+    char date[64];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"host_name\": \"" << host << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"label\": \"" << opts.label << "\",\n"
+        << "    \"seed\": " << opts.seed << ",\n"
+        << "    \"keys\": " << opts.keys << ",\n"
+        << "    \"ops\": " << opts.ops << ",\n"
+        << "    \"repetitions\": " << opts.repetitions << "\n"
+        << "  },\n  \"benchmarks\": [\n";
+    out << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\"";
+        if (r.bytesPerItem >= 0) {
+            out << ", \"bytes_per_item\": " << r.bytesPerItem;
+        } else {
+            double med = median(r.nsPerOp);
+            out << ", \"iterations\": " << r.ops << ", \"time_unit\": \"ns\""
+                << ", \"real_time\": " << med << ", \"mean\": " << mean(r.nsPerOp)
+                << ", \"stddev\": " << stddev(r.nsPerOp) << ", \"items_per_second\": " << 1e9 / med
+                << ", \"repetitions\": [";
+            for (size_t j = 0; j < r.nsPerOp.size(); j++) out << (j ? ", " : "") << r.nsPerOp[j];
+            out << "]";
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    std::cout << "wrote " << opts.json << std::endl;
+}
+
+static void populate(StorageEngine& engine, size_t keyspace, const std::string& value) {
+    for (size_t i = 0; i < keyspace; i++) engine.set(keyName(i), value);
+}
+
+static void benchOp(Runner& runner, const Options& opts, Op op, Dist dist, size_t valueSize) {
+    //大值用例缩小 key 空间,免得占用几百 MB 内存
+    size_t keyspace = valueSize > 1024 ? std::max<size_t>(opts.keys / 8, 1) : opts.keys;
+    size_t ops = op == Op::Del ? keyspace : opts.ops;
+    std::string name = std::string(opName(op)) + "/" + (dist == Dist::Uniform ? "uniform" : "zipfian") + "/" +
+                       std::to_string(valueSize) + "B";
+    if (!runner.selected(name)) return;
+
+    std::mt19937_64 rng(opts.seed);
+    std::vector<std::string> keys;
+    if (op == Op::Del) {
+        //每个 key 删一次,顺序打乱
+        for (size_t i = 0; i < keyspace; i++) keys.push_back(keyName(i));
+        std::shuffle(keys.begin(), keys.end(), rng);
+    } else {
+        for (size_t id : keyIds(dist, keyspace, ops, rng))
+            keys.push_back(op == Op::GetMiss ? "miss:" + std::to_string(id) : keyName(id));
+    }
+    std::string value(valueSize, 'v');
+    volatile size_t sink = 0;
+
+    runner.timed(name, ops, [&]() -> double {
+        StorageEngine engine;
+        if (op != Op::Set) populate(engine, keyspace, value);
+        auto start = Clock::now();
+        switch (op) {
+            case Op::Set:
+            case Op::Overwrite:
+                for (auto& k : keys) engine.set(k, value);
+                break;
+            case Op::GetHit:
+            case Op::GetMiss:
+                for (auto& k : keys) sink += engine.get(k).has_value();
+                break;
+            case Op::Del:
+                for (auto& k : keys) sink += engine.del(k);
+                break;
+        }
+        return seconds(start);
+    });
+}
+
+//模拟缓存里的 JSON:重复的字段名、随机的数字和短单词,拼到正好 size 字节
+static std::string makeJson(size_t size, std::mt19937_64& rng) {
+    static const char* words[] = {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel"};
+    std::string s = "[";
+    while (s.size() < size) {
+        s += "{\"id\":" + std::to_string(rng() % 1000000) + ",\"name\":\"" + words[rng() % 8] + "_" +
+             std::to_string(rng() % 10000) + "\",\"active\":" + (rng() % 2 ? "true" : "false") +
+             ",\"score\":" + std::to_string(rng() % 10000 / 100.0) + ",\"tags\":[\"" + words[rng() % 8] +
+             "\",\"" + words[rng() % 8] + "\"],\"address\":{\"city\":\"" + words[rng() % 8] +
+             "\",\"zip\":\"" + std::to_string(10000 + rng() % 90000) + "\"}},";
+    }
+    s.resize(size);
+    return s;
+}
+
+//同一批 JSON 值分别原样存和压缩存:SET 的耗时含压缩,GET 的耗时含解压,MEM 看省下多少内存
+static void benchCompression(Runner& runner, const Options& opts) {
+    for (size_t valueSize : {2048, 16384, 49152}) {
+        //总数据量控制在 64MB 左右
+        size_t keyspace = std::max<size_t>(std::min(opts.keys / 8, (64u << 20) / valueSize), 1);
+        std::mt19937_64 rng(opts.seed);
+        std::vector<std::string> values;
+        for (int i = 0; i < 64; i++) values.push_back(makeJson(valueSize, rng));
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < keyspace; i++) keys.push_back(keyName(i));
+        auto fill = [&](StorageEngine& engine) {
+            for (size_t i = 0; i < keyspace; i++) engine.set(keys[i], values[i % values.size()]);
+        };
+
+        for (bool lz4 : {false, true}) {
+            std::string suffix = "/json/" + std::to_string(valueSize) + "B/" + (lz4 ? "lz4" : "raw");
+            runner.timed("SET" + suffix, keyspace, [&]() -> double {
+                StorageEngine engine;
+                if (lz4) engine.setStringCompression(1024);
+                auto start = Clock::now();
+                fill(engine);
+                return seconds(start);
+            });
+            if (runner.selected("GET_HIT" + suffix)) {
+                StorageEngine engine;
+                if (lz4) engine.setStringCompression(1024);
+                fill(engine);
+                volatile size_t sink = 0;
+                runner.timed("GET_HIT" + suffix, keyspace, [&]() -> double {
+                    auto start = Clock::now();
+                    for (auto& k : keys) sink += engine.get(k)->size();
+                    return seconds(start);
+                });
+            }
+            if (runner.selected("MEM" + suffix)) {
+                StorageEngine engine;
+                if (lz4) engine.setStringCompression(1024);
+                size_t base = heapUsed();
+                fill(engine);
+                runner.memory("MEM" + suffix, double(heapUsed() - base) / keyspace);
+            }
+        }
+    }
+}
+
+static void benchMemory(Runner& runner, const Options& opts) {
+    for (size_t valueSize : {16, 4096}) {
+        std::string name = "MEM/string/" + std::to_string(valueSize) + "B";
+        if (!runner.selected(name)) continue;
+        size_t keyspace = valueSize > 1024 ? std::max<size_t>(opts.keys / 8, 1) : opts.keys;
+        StorageEngine engine;
+        size_t base = heapUsed();
+        populate(engine, keyspace, std::string(valueSize, 'v'));
+        runner.memory(name, double(heapUsed() - base) / keyspace);
+    }
+    //同样的哈希数据分别用 listpack 和 Dict 存,按字段算
+    for (int fields : {16, 128}) {
+        for (bool listpack : {true, false}) {
+            std::string name = std::string("MEM/hash-") + (listpack ? "listpack/" : "hashtable/") +
+                               std::to_string(fields) + "fields";
+            if (!runner.selected(name)) continue;
+            const int keys = 1000;
+            StorageEngine engine;
+            engine.setHashListpackLimits(listpack ? 128 : 0, 64);
+            size_t base = heapUsed();
+            for (int k = 0; k < keys; ++k)
+                for (int f = 0; f < fields; ++f)
+                    engine.hset("user:" + std::to_string(k), "field" + std::to_string(f), "v" + std::to_string(f * 7));
+            runner.memory(name, double(heapUsed() - base) / (double(keys) * fields));
+        }
+    }
+}
+
+// user:<id>:<字段> 形状的 key,同一个用户的几个字段共享前缀
+static std::vector<std::string> userKeys(size_t count, std::mt19937_64& rng) {
+    static const char* fields[] = {"name", "email", "cart", "session"};
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; i++)
+        keys.push_back("user:" + std::to_string(rng() % (count / 2 + 1)) + ":" + fields[i % 4]);
+    return keys;
+}
+
+static void benchKeyIndex(Runner& runner, const Options& opts) {
+    std::mt19937_64 rng(opts.seed);
+    std::vector<std::string> keys = userKeys(opts.keys, rng);
+    //前缀查询:某个用户的全部字段,以及 user:<前几位> 这种一次返回上百个 key 的宽前缀
+    std::vector<std::string> prefixes;
+    for (int i = 0; i < 64; i++) {
+        std::string id = std::to_string(rng() % (opts.keys / 2 + 1));
+        prefixes.push_back(i % 2 ? "user:" + id + ":" : "user:" + id.substr(0, std::max<size_t>(id.size(), 3) - 2));
+    }
+    for (bool on : {false, true}) {
+        std::string suffix = std::string("/keyindex/") + (on ? "on" : "off");
+        runner.timed("SET" + suffix, keys.size(), [&]() -> double {
+            StorageEngine engine;
+            if (on) engine.enableKeyIndex();
+            auto start = Clock::now();
+            for (auto& k : keys) engine.set(k, "v");
+            return seconds(start);
+        });
+        runner.timed("DEL" + suffix, keys.size(), [&]() -> double {
+            StorageEngine engine;
+            if (on) engine.enableKeyIndex();
+            for (auto& k : keys) engine.set(k, "v");
+            auto start = Clock::now();
+            for (auto& k : keys) engine.del(k);
+            return seconds(start);
+        });
+        if (runner.selected("PREFIX" + suffix)) {
+            StorageEngine engine;
+            if (on) engine.enableKeyIndex();
+            for (auto& k : keys) engine.set(k, "v");
+            //全表扫描每次都要排序整个库,少查几次
+            size_t queries = on ? prefixes.size() : 4;
+            volatile size_t sink = 0;
+            runner.timed("PREFIX" + suffix, queries, [&]() -> double {
+                auto start = Clock::now();
+                for (size_t i = 0; i < queries; i++) sink += engine.keysWithPrefix(prefixes[i], nullptr, 1000).size();
+                return seconds(start);
+            });
+        }
+    }
+    //索引建在已有数据上,前后的堆内存差就是索引本身
+    for (bool user : {false, true}) {
+        std::string name = std::string("MEM/keyindex/") + (user ? "user:<id>:<field>" : "key:<id>");
+        if (!runner.selected(name)) continue;
+        StorageEngine engine;
+        for (size_t i = 0; i < opts.keys; i++) engine.set(user ? keys[i] : keyName(i), "v");
+        size_t base = heapUsed();
+        engine.enableKeyIndex();
+        runner.memory(name, double(heapUsed() - base) / engine.dbsize());
+    }
+}
+
+//日志型消息:每条的字段名相同,值是一个短字符串和两个数字
+static std::vector<std::string> logEntry(size_t i) {
+    return {"level", i % 10 ? "info" : "warn", "latency_us", std::to_string(100 + i % 900),
+            "path", "/api/v1/items/" + std::to_string(i % 5000)};
+}
+
+static void benchStream(Runner& runner, const Options& opts) {
+    size_t n = opts.keys;
+    runner.timed("XADD/stream", n, [&]() -> double {
+        StorageEngine engine;
+        Stream* s = engine.streamWrite("log", true);
+        auto start = Clock::now();
+        StreamID id;
+        for (size_t i = 0; i < n; i++) {
+            s->nextId(1700000000000ull + i / 4, id);
+            s->append(id, logEntry(i));
+        }
+        return seconds(start);
+    });
+    if (runner.selected("XRANGE/stream")) {
+        StorageEngine engine;
+        Stream* s = engine.streamWrite("log", true);
+        StreamID id;
+        for (size_t i = 0; i < n; i++) {
+            s->nextId(1700000000000ull + i / 4, id);
+            s->append(id, logEntry(i));
+        }
+        std::mt19937_64 rng(opts.seed);
+        std::vector<StreamID> starts;
+        for (size_t i = 0; i < opts.ops / 10; i++) starts.push_back({1700000000000ull + rng() % (n / 4 + 1), 0});
+        volatile size_t sink = 0;
+        runner.timed("XRANGE/stream", starts.size(), [&]() -> double {
+            auto start = Clock::now();
+            for (auto& from : starts) sink += s->range(from, StreamID::max(), false, 10).size();
+            return seconds(start);
+        });
+    }
+    if (runner.selected("MEM/stream")) {
+        StorageEngine engine;
+        size_t base = heapUsed();
+        Stream* s = engine.streamWrite("log", true);
+        StreamID id;
+        for (size_t i = 0; i < n; i++) {
+            s->nextId(1700000000000ull + i / 4, id);
+            s->append(id, logEntry(i));
+        }
+        runner.memory("MEM/stream", double(heapUsed() - base) / n);
+    }
+}
+
+//城市范围(约 50km 见方)里均匀分布的点
+static std::vector<std::pair<double, double>> geoPoints(size_t n, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> lon(116.1, 116.7), lat(39.7, 40.15);
+    std::vector<std::pair<double, double>> pts(n);
+    for (auto& p : pts) p = {lon(rng), lat(rng)};
+    return pts;
+}
+
+static void geoFill(ZSet* z, const std::vector<std::pair<double, double>>& pts, const std::vector<std::string>& names) {
+    for (size_t i = 0; i < pts.size(); i++) {
+        uint64_t bits;
+        geohashEncode(pts[i].first, pts[i].second, GEO_STEP_MAX, bits);
+        z->add(names[i], (double)bits);
+    }
+}
+
+static void benchGeo(Runner& runner, const Options& opts) {
+    size_t n = opts.keys;
+    auto pts = geoPoints(n, opts.seed);
+    std::vector<std::string> names(n);
+    for (size_t i = 0; i < n; i++) names[i] = "driver:" + std::to_string(i);
+    runner.timed("GEOADD/geo", n, [&]() -> double {
+        StorageEngine engine;
+        ZSet* z = engine.zsetWrite("drivers", true);
+        auto start = Clock::now();
+        geoFill(z, pts, names);
+        return seconds(start);
+    });
+    if (runner.selected("GEOSEARCH/geo")) {
+        StorageEngine engine;
+        ZSet* z = engine.zsetWrite("drivers", true);
+        geoFill(z, pts, names);
+        auto centers = geoPoints(opts.ops / 100, opts.seed + 1);
+        volatile size_t sink = 0;
+        runner.timed("GEOSEARCH/geo/1km/cells", centers.size(), [&]() -> double {
+            auto start = Clock::now();
+            for (auto& c : centers) {
+                GeoShape shape;
+                shape.lon = c.first;
+                shape.lat = c.second;
+                shape.radius = 1000;
+                sink += geoSearch(*z, shape, false, 0, false).size();
+            }
+            return seconds(start);
+        });
+        //对照:不按格子,逐个成员解码算距离;每次都扫全部成员,只测少量中心点
+        size_t scans = std::min<size_t>(centers.size(), 20);
+        runner.timed("GEOSEARCH/geo/1km/scan", scans, [&]() -> double {
+            auto start = Clock::now();
+            ZRangeSpec all{-INFINITY, INFINITY};
+            for (size_t i = 0; i < scans; i++) {
+                auto& c = centers[i];
+                GeoShape shape;
+                shape.lon = c.first;
+                shape.lat = c.second;
+                shape.radius = 1000;
+                size_t found = 0;
+                z->forEachInRange(all, [&](const char*, size_t, double score) {
+                    double lon, lat, dist;
+                    geohashDecode((uint64_t)score, GEO_STEP_MAX, lon, lat);
+                    found += geoWithin(shape, lon, lat, dist);
+                    return true;
+                });
+                sink += found;
+            }
+            return seconds(start);
+        });
+    }
+    if (runner.selected("MEM/geo")) {
+        StorageEngine engine;
+        size_t base = heapUsed();
+        geoFill(engine.zsetWrite("drivers", true), pts, names);
+        runner.memory("MEM/geo", double(heapUsed() - base) / n);
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string opt = argv[i];
+        if (opt == "--seed") opts.seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (opt == "--keys") opts.keys = strtoull(argv[i + 1], nullptr, 10);
+        else if (opt == "--ops") opts.ops = strtoull(argv[i + 1], nullptr, 10);
+        else if (opt == "--repetitions") opts.repetitions = std::max(1, atoi(argv[i + 1]));
+        else if (opt == "--warmup") opts.warmupSeconds = atof(argv[i + 1]);
+        else if (opt == "--filter") opts.filter = argv[i + 1];
+        else if (opt == "--json") opts.json = argv[i + 1];
+        else if (opt == "--label") opts.label = argv[i + 1];
+        else { std::cerr << "unknown option: " << opt << std::endl; return 1; }
+    }
+
+    Runner runner(opts);
+    std::cout << "seed=" << opts.seed << " keys=" << opts.keys << " ops=" << opts.ops
+              << " repetitions=" << opts.repetitions << std::endl;
+    for (size_t valueSize : {16, 4096})
+        for (Op op : {Op::Set, Op::GetHit, Op::GetMiss, Op::Overwrite, Op::Del})
+            for (Dist dist : {Dist::Uniform, Dist::Zipfian}) {
+                if (op == Op::Del && dist == Dist::Zipfian) continue;   // DEL 每个 key 只删一次,没有分布可言
+                benchOp(runner, opts, op, dist, valueSize);
+            }
+    benchMemory(runner, opts);
+    benchCompression(runner, opts);
+    benchKeyIndex(runner, opts);
+    benchStream(runner, opts);
+    benchGeo(runner, opts);
+    if (!opts.json.empty()) runner.writeJson();
 }
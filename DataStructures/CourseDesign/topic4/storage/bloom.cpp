@@ -0,0 +1,77 @@
+#include "bloom.h"
+#include "hashfunc.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//固定种子,两个种子给出两个独立的哈希
+static const uint64_t BLOOM_SEED1 = 0x5bd1e995ull;
+static const uint64_t BLOOM_SEED2 = 0x9e3779b97f4a7c15ull;
+
+BloomFilter* BloomFilter::create(double errorRate, uint64_t capacity) {
+    if (!(errorRate > 0 && errorRate < 1) || capacity == 0) return nullptr;
+    const double ln2 = std::log(2.0);
+    double m = std::ceil(-(double)capacity * std::log(errorRate) / (ln2 * ln2));
+    if (m > BLOOM_MAX_BYTES * 8.0) return nullptr;
+    BloomFilter* bf = new BloomFilter();
+    bf->nbits = ((uint64_t)m + 63) / 64 * 64;
+    bf->bits.assign(bf->nbits / 64, 0);
+    bf->k = std::max<uint32_t>(1, (uint32_t)std::lround(m / capacity * ln2));
+    bf->cap = capacity;
+    bf->error = errorRate;
+    return bf;
+}
+
+//格式:nbits k cap error inserted(各 8 字节,本机字节序),后面是位数组
+std::string BloomFilter::dump() const {
+    uint64_t head[5] = {nbits, k, cap, 0, inserted};
+    memcpy(&head[3], &error, sizeof(double));
+    std::string out(reinterpret_cast<const char*>(head), sizeof(head));
+    out.append(reinterpret_cast<const char*>(bits.data()), bytes());
+    return out;
+}
+
+BloomFilter* BloomFilter::restore(const std::string& data) {
+    uint64_t head[5];
+    if (data.size() < sizeof(head)) return nullptr;
+    memcpy(head, data.data(), sizeof(head));
+    double errorRate;
+    memcpy(&errorRate, &head[3], sizeof(double));
+    uint64_t nbits = head[0];
+    if (nbits == 0 || nbits % 64 || nbits / 8 > BLOOM_MAX_BYTES || head[1] == 0 || head[1] > nbits || head[2] == 0 ||
+        !(errorRate > 0 && errorRate < 1) || data.size() != sizeof(head) + nbits / 8)
+        return nullptr;
+    BloomFilter* bf = new BloomFilter();
+    bf->nbits = nbits;
+    bf->k = (uint32_t)head[1];
+    bf->cap = head[2];
+    bf->error = errorRate;
+    bf->inserted = head[4];
+    bf->bits.resize(nbits / 64);
+    memcpy(bf->bits.data(), data.data() + sizeof(head), nbits / 8);
+    return bf;
+}
+
+bool BloomFilter::add(const char* data, size_t len) {
+    uint64_t h1 = wyhash(data, len, BLOOM_SEED1), h2 = wyhash(data, len, BLOOM_SEED2) | 1;
+    bool added = false;
+    for (uint32_t i = 0; i < k; i++) {
+        uint64_t bit = (h1 + i * h2) % nbits;
+        uint64_t mask = 1ull << (bit & 63);
+        if (!(bits[bit >> 6] & mask)) {
+            bits[bit >> 6] |= mask;
+            added = true;
+        }
+    }
+    if (added) inserted++;
+    return added;
+}
+
+bool BloomFilter::contains(const char* data, size_t len) const {
+    uint64_t h1 = wyhash(data, len, BLOOM_SEED1), h2 = wyhash(data, len, BLOOM_SEED2) | 1;
+    for (uint32_t i = 0; i < k; i++) {
+        uint64_t bit = (h1 + i * h2) % nbits;
+        if (!(bits[bit >> 6] & (1ull << (bit & 63)))) return false;
+    }
+    return true;
+}
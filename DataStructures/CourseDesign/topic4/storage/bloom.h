@@ -0,0 +1,41 @@
+/*Bloom 过滤器:判断元素"一定不在"或"可能在"集合里。
+    位数 m = -n·ln(p) / ln2²,哈希函数个数 k = m/n·ln2 (n 是预计容量,p 是目标误判率)
+    k 个位置用双重哈希生成:h1 + i·h2 (Kirsch–Mitzenmacher),每个元素只算两次哈希
+大小固定,不会像 RedisBloom 那样加挂子过滤器;插入数量超过容量后误判率会逐渐升高*/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+
+static const size_t BLOOM_MAX_BYTES = 8 * 1024;        //单个 key 的位数组上限,1% 误判率时约能装 6800 个元素
+static const uint64_t BLOOM_DEFAULT_CAPACITY = 1000;   // BF.ADD 自动创建时的参数,约 1.2KB
+static const double BLOOM_DEFAULT_ERROR_RATE = 0.01;
+
+class BloomFilter {
+public:
+    //参数不合法或超过 BLOOM_MAX_BYTES 时返回 nullptr
+    static BloomFilter* create(double errorRate, uint64_t capacity);
+    //迁移用:参数和位数组一起导出;restore 遇到格式不对或超过 BLOOM_MAX_BYTES 返回 nullptr
+    std::string dump() const;
+    static BloomFilter* restore(const std::string& data);
+
+    bool add(const char* data, size_t len);             //新加入(有位从 0 变 1)时返回 true
+    bool contains(const char* data, size_t len) const;
+
+    uint64_t capacity() const { return cap; }
+    double errorRate() const { return error; }
+    uint64_t items() const { return inserted; }
+    uint32_t hashes() const { return k; }
+    size_t bytes() const { return bits.size() * sizeof(uint64_t); }
+
+private:
+    BloomFilter() = default;
+
+    std::vector<uint64_t> bits;
+    uint64_t nbits = 0;
+    uint32_t k = 0;
+    uint64_t cap = 0;
+    double error = 0;
+    uint64_t inserted = 0;
+};
@@ -0,0 +1,78 @@
+/*多线程读写混合基准:同一个 StorageEngine 被 N 个线程直接调用
+    mutex       单线程模式 + 外面一把全局锁(没有并发模式时只能这样用)
+    concurrent  并发模式:GET 无锁,SET 分段加锁
+两种写负载:
+    overwrite   只覆盖已有的 key,表结构不变
+    churn       不断插入新 key,攒够 CHURN_LAG 个后每插一个删掉最早的一个,表在读线程运行时扩容,
+                删掉的节点和扩容换下的旧表都走 epoch 回收
+编译: g++ -std=c++17 -O2 -pthread -o concurrent_benchmark concurrent_benchmark.cpp \
+          storage.cpp dict.cpp concurrent_dict.cpp epoch.cpp sds.cpp listpack.cpp object.cpp hashfunc.cpp \
+          slot.cpp hyperloglog.cpp bloom.cpp lazyfree.cpp lz4.cpp rax.cpp stream.cpp zset.cpp geo.cpp trace.cpp */
+#include "storage.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+static const int KEYS = 100000;
+static const int OPS_PER_THREAD = 500000;
+static const int CHURN_LAG = 50000;      //每个线程最多同时保留这么多自己插入的 key,1 个线程也足够让表扩容一次
+
+enum class WriteMix { Overwrite, Churn };
+
+//返回每秒总操作数(百万)
+static double run(StorageEngine& engine, std::mutex* lock, int threads, int readPercent, WriteMix mix) {
+    std::vector<std::string> keys;
+    for (int i = 0; i < KEYS; i++) keys.push_back("key:" + std::to_string(i));
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            unsigned seed = 12345 + t;
+            size_t hits = 0;
+            long long inserted = 0, deleted = 0;
+            std::string prefix = "new:" + std::to_string(t) + ":";
+            for (int i = 0; i < OPS_PER_THREAD; i++) {
+                seed = seed * 1103515245 + 12345;
+                const std::string& key = keys[(seed >> 8) % KEYS];
+                bool read = (int)((seed >> 4) % 100) < readPercent;
+                std::unique_lock<std::mutex> guard;
+                if (lock) guard = std::unique_lock<std::mutex>(*lock);
+                if (read) hits += engine.get(key).has_value();
+                else if (mix == WriteMix::Overwrite) engine.set(key, "value");
+                else if (inserted - deleted < CHURN_LAG) engine.set(prefix + std::to_string(inserted++), "value");
+                else engine.del(prefix + std::to_string(deleted++));
+            }
+            if (hits == 0 && readPercent > 0) std::cerr << "no hits?" << std::endl;
+        });
+    }
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * (double)OPS_PER_THREAD / secs / 1e6;
+}
+
+int main() {
+    unsigned cores = std::thread::hardware_concurrency();
+    std::cout << "hardware threads: " << cores << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "mix        threads  read%  mutex(Mops)  concurrent(Mops)" << std::endl;
+    struct Case { WriteMix mix; int readPercent; };
+    for (Case cs : {Case{WriteMix::Overwrite, 100}, Case{WriteMix::Overwrite, 95}, Case{WriteMix::Overwrite, 50},
+                    Case{WriteMix::Churn, 95}, Case{WriteMix::Churn, 50}}) {
+        int readPercent = cs.readPercent;
+        for (int threads : {1, 2, 4, 8, 16}) {
+            StorageEngine single, conc(StorageMode::Concurrent);
+            for (int i = 0; i < KEYS; i++) {
+                single.set("key:" + std::to_string(i), "value");
+                conc.set("key:" + std::to_string(i), "value");
+            }
+            std::mutex lock;
+            double a = run(single, &lock, threads, readPercent, cs.mix);
+            double b = run(conc, nullptr, threads, readPercent, cs.mix);
+            std::cout << std::left << std::setw(10) << (cs.mix == WriteMix::Churn ? "churn" : "overwrite")
+                      << std::right << std::setw(8) << threads << std::setw(7) << readPercent
+                      << std::setw(13) << a << std::setw(18) << b << std::endl;
+        }
+    }
+}
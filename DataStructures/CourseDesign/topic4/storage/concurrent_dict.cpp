@@ -0,0 +1,123 @@
+#include "concurrent_dict.h"
+#include "dict.h"
+#include <cstring>
+
+ConcurrentDict::Table::Table(size_t size) : mask(size - 1), buckets(new std::atomic<ConcurrentDictEntry*>[size]) {
+    for (size_t i = 0; i < size; i++) buckets[i].store(nullptr, std::memory_order_relaxed);
+}
+
+//段号只取哈希值的低位,表大小至少等于段数,所以同一个桶永远属于同一段,扩容也不变
+ConcurrentDict::ConcurrentDict(size_t size, void (*valDestructor)(void*)) : valDestructor(valDestructor) {
+    size_t s = STRIPES;
+    while (s < size) s <<= 1;
+    table.store(new Table(s));
+}
+
+ConcurrentDict::~ConcurrentDict() {
+    Table* t = table.load();
+    for (size_t i = 0; i <= t->mask; i++) {
+        ConcurrentDictEntry* e = t->buckets[i].load();
+        while (e) {
+            ConcurrentDictEntry* next = e->next.load();
+            sdsFree(e->key);
+            if (valDestructor) valDestructor(e->value.load());
+            delete e;
+            e = next;
+        }
+    }
+    delete t;
+}
+
+ConcurrentDictEntry* ConcurrentDict::find(const char* key, size_t len) {
+    uint64_t h = dictHash(key, len);
+    Table* t = table.load(std::memory_order_acquire);
+    ConcurrentDictEntry* e = t->buckets[h & t->mask].load(std::memory_order_acquire);
+    while (e) {
+        if (e->hash == h && e->key->len == len && memcmp(e->key->buf, key, len) == 0) return e;
+        e = e->next.load(std::memory_order_acquire);
+    }
+    return nullptr;
+}
+
+static void freeEntryWithKey(void* p) {
+    auto* e = static_cast<ConcurrentDictEntry*>(p);
+    sdsFree(e->key);
+    delete e;
+}
+
+//扩容后旧节点的 key 和值都被新节点接管,只释放节点本身
+static void freeEntryOnly(void* p) {
+    delete static_cast<ConcurrentDictEntry*>(p);
+}
+
+void ConcurrentDict::freeTable(void* t) {
+    delete static_cast<Table*>(t);
+}
+
+void ConcurrentDict::set(SDS* key, void* value) {
+    uint64_t h = dictHash(key->buf, key->len);
+    bool grow;
+    {
+        std::lock_guard<std::mutex> lock(stripes[h & (STRIPES - 1)]);
+        Table* t = table.load(std::memory_order_relaxed);
+        std::atomic<ConcurrentDictEntry*>& bucket = t->buckets[h & t->mask];
+        for (auto* e = bucket.load(std::memory_order_relaxed); e; e = e->next.load(std::memory_order_relaxed)) {
+            if (e->hash == h && e->key->len == key->len && memcmp(e->key->buf, key->buf, key->len) == 0) {
+                void* old = e->value.exchange(value, std::memory_order_acq_rel);
+                if (valDestructor && old != value) epochRetire(old, valDestructor);
+                sdsFree(key);
+                return;
+            }
+        }
+        auto* ne = new ConcurrentDictEntry{key, {value}, {bucket.load(std::memory_order_relaxed)}, h};
+        //节点内容写完后再发布,读者通过 acquire 读到指针时一定能看到完整节点
+        bucket.store(ne, std::memory_order_release);
+        grow = count.fetch_add(1, std::memory_order_relaxed) + 1 > t->mask + 1;
+    }
+    if (grow) expand();
+}
+
+bool ConcurrentDict::del(const char* key, size_t len) {
+    uint64_t h = dictHash(key, len);
+    std::lock_guard<std::mutex> lock(stripes[h & (STRIPES - 1)]);
+    Table* t = table.load(std::memory_order_relaxed);
+    std::atomic<ConcurrentDictEntry*>* ref = &t->buckets[h & t->mask];
+    for (auto* e = ref->load(std::memory_order_relaxed); e; ref = &e->next, e = ref->load(std::memory_order_relaxed)) {
+        if (e->hash == h && e->key->len == len && memcmp(e->key->buf, key, len) == 0) {
+            //摘下后正在 e 上的读者仍能通过 e->next 继续往后走
+            ref->store(e->next.load(std::memory_order_relaxed), std::memory_order_release);
+            if (valDestructor) epochRetire(e->value.load(std::memory_order_relaxed), valDestructor);
+            epochRetire(e, freeEntryWithKey);
+            count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+//不能原地改旧节点的 next(读者可能正走在旧链上,会跳到别的链漏掉 key),所以复制一份
+void ConcurrentDict::expand() {
+    std::unique_lock<std::mutex> locks[STRIPES];
+    for (size_t i = 0; i < STRIPES; i++) locks[i] = std::unique_lock<std::mutex>(stripes[i]);
+    Table* old = table.load(std::memory_order_relaxed);
+    if (count.load(std::memory_order_relaxed) <= old->mask + 1) return;   //别的线程已经扩过了
+
+    Table* t = new Table((old->mask + 1) * 2);
+    for (size_t i = 0; i <= old->mask; i++) {
+        for (auto* e = old->buckets[i].load(std::memory_order_relaxed); e; e = e->next.load(std::memory_order_relaxed)) {
+            std::atomic<ConcurrentDictEntry*>& bucket = t->buckets[e->hash & t->mask];
+            bucket.store(new ConcurrentDictEntry{e->key, {e->value.load(std::memory_order_relaxed)},
+                                                 {bucket.load(std::memory_order_relaxed)}, e->hash},
+                         std::memory_order_relaxed);
+        }
+    }
+    table.store(t, std::memory_order_release);
+    for (size_t i = 0; i <= old->mask; i++) {
+        for (auto* e = old->buckets[i].load(std::memory_order_relaxed); e; ) {
+            auto* next = e->next.load(std::memory_order_relaxed);
+            epochRetire(e, freeEntryOnly);
+            e = next;
+        }
+    }
+    epochRetire(old, freeTable);
+}
@@ -0,0 +1,60 @@
+/*并发哈希表:读操作不加锁,写操作按哈希值分段加锁。
+    读:在 EpochGuard 里沿原子指针遍历桶链,不写任何共享数据,可以随核数线性扩展
+    写:同一段(哈希值低位相同)的写操作互斥,不同段并行;节点插到链头,一次原子 store 发布
+    删除/覆盖:摘下的节点和旧值交给 epochRetire,等读者离开后再释放
+    扩容:拿到所有段锁后复制节点建新表,一次性替换表指针,旧表和旧节点同样延迟释放
+键和值的所有权约定与 Dict 相同*/
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include "sds.h"
+#include "epoch.h"
+
+struct ConcurrentDictEntry {
+    SDS* key;                                   //插入后不再修改
+    std::atomic<void*> value;
+    std::atomic<ConcurrentDictEntry*> next;
+    uint64_t hash;
+};
+
+class ConcurrentDict {
+public:
+    ConcurrentDict(size_t size = 16, void (*valDestructor)(void*) = nullptr);
+    ~ConcurrentDict();   //调用时不能有其他线程还在访问
+
+    void set(SDS* key, void* value);
+    bool del(const char* key, size_t len);
+    //读到的值只在调用方的 EpochGuard 内有效,fn 里应该把需要的内容拷出来
+    template <class F>
+    bool read(const char* key, size_t len, F&& fn) {
+        EpochGuard guard;
+        ConcurrentDictEntry* e = find(key, len);
+        if (!e) return false;
+        fn(e->value.load(std::memory_order_acquire));
+        return true;
+    }
+    //调用方必须已经在 EpochGuard 里
+    void* get(const char* key, size_t len) {
+        ConcurrentDictEntry* e = find(key, len);
+        return e ? e->value.load(std::memory_order_acquire) : nullptr;
+    }
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    struct Table {
+        size_t mask;
+        std::unique_ptr<std::atomic<ConcurrentDictEntry*>[]> buckets;
+        explicit Table(size_t size);
+    };
+    static const size_t STRIPES = 64;   //段数,必须是 2 的幂并且不超过最小表大小
+
+    ConcurrentDictEntry* find(const char* key, size_t len);
+    void expand();
+    static void freeTable(void* t);
+
+    std::atomic<Table*> table;
+    std::mutex stripes[STRIPES];
+    std::atomic<size_t> count{0};
+    void (*valDestructor)(void*);
+};
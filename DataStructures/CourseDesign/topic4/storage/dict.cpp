@@ -1,7 +1,32 @@
 #include "dict.h"
-#include <cstring>
+#include "hashfunc.h"
 
-Dict::Dict(size_t size) : table(size, nullptr) {}
+static DictHashFunction hashFunction = DictHashFunction::Wyhash;
+static uint8_t hashSeed[16];
+
+void dictSetHashFunction(DictHashFunction fn) {
+    hashFunction = fn;
+}
+
+void dictSetHashSeed(const uint8_t seed[16]) {
+    memcpy(hashSeed, seed, sizeof(hashSeed));
+}
+
+uint64_t dictHash(const char* key, size_t len) {
+    if (hashFunction == DictHashFunction::SipHash) return siphash(key, len, hashSeed);
+    uint64_t seed;
+    memcpy(&seed, hashSeed, 8);
+    return wyhash(key, len, seed);
+}
+
+static size_t nextPower(size_t n) {
+    size_t s = 4;
+    while (s < n) s <<= 1;
+    return s;
+}
+
+Dict::Dict(size_t size, void (*valDestructor)(void*))
+    : table(nextPower(size), nullptr), mask(table.size() - 1), valDestructor(valDestructor) {}
 
 Dict::~Dict() {
     for (auto& head : table) {
@@ -9,57 +34,90 @@ Dict::~Dict() {
             DictEntry* tmp = head;
             head = head->next;
             sdsFree(tmp->key);
+            if (valDestructor) valDestructor(tmp->value);
             delete tmp;
         }
     }
 }
 
-size_t Dict::hash(const char* key) {
-    size_t h = 5381;
-    while (*key)
-        h = ((h << 5) + h) + *key++;
-    return h % table.size();
+//返回指向目标节点的那个指针(桶头或前一个节点的 next),没找到时 *ref 为空。
+//先比哈希值,再比长度,最后才 memcmp,冲突链上绝大多数节点在第一步就被排除
+DictEntry** Dict::findRef(const char* key, size_t len, uint64_t h) {
+    DictEntry** ref = &table[h & mask];
+    while (*ref) {
+        DictEntry* e = *ref;
+        if (e->hash == h && e->key->len == len && memcmp(e->key->buf, key, len) == 0) break;
+        ref = &e->next;
+    }
+    return ref;
 }
 
-void Dict::set(SDS* key, void* value) {
-    size_t idx = hash(key->buf);
-    DictEntry* e = table[idx];
-    while (e) {
-        if (strcmp(e->key->buf, key->buf) == 0) {
-            e->value = value;
-            return;
+//全部节点挪到新表,节点里存了哈希值所以不用重新计算
+void Dict::expand(size_t size) {
+    std::vector<DictEntry*> newTable(size, nullptr);
+    size_t newMask = size - 1;
+    for (DictEntry* head : table) {
+        while (head) {
+            DictEntry* next = head->next;
+            DictEntry*& bucket = newTable[head->hash & newMask];
+            head->next = bucket;
+            bucket = head;
+            head = next;
         }
-        e = e->next;
     }
-    auto* ne = new DictEntry{key, value, table[idx]};
-    table[idx] = ne;
+    table.swap(newTable);
+    mask = newMask;
 }
 
-void* Dict::get(const char* key) {
-    size_t idx = hash(key);
-    DictEntry* e = table[idx];
-    while (e) {
-        if (strcmp(e->key->buf, key) == 0)
-            return e->value;
-        e = e->next;
+void Dict::set(SDS* key, void* value) {
+    uint64_t h = dictHash(key->buf, key->len);
+    DictEntry** ref = findRef(key->buf, key->len, h);
+    if (DictEntry* e = *ref) {
+        if (valDestructor && e->value != value) valDestructor(e->value);
+        e->value = value;
+        sdsFree(key);
+        return;
     }
-    return nullptr;
+    if (count >= table.size()) expand(table.size() * 2);
+    DictEntry*& bucket = table[h & mask];
+    bucket = new DictEntry{key, value, bucket, h};
+    count++;
 }
 
-bool Dict::del(const char* key) {
-    size_t idx = hash(key);
-    DictEntry* e = table[idx];
-    DictEntry* prev = nullptr;
-    while (e) {
-        if (strcmp(e->key->buf, key) == 0) {
-            if (prev) prev->next = e->next;
-            else table[idx] = e->next;
-            sdsFree(e->key);
-            delete e;
-            return true;
-        }
-        prev = e;
-        e = e->next;
-    }
-    return false;
+void* Dict::get(const char* key, size_t len) {
+    DictEntry* e = *findRef(key, len, dictHash(key, len));
+    return e ? e->value : nullptr;
+}
+
+bool Dict::del(const char* key, size_t len) {
+    DictEntry** ref = findRef(key, len, dictHash(key, len));
+    DictEntry* e = *ref;
+    if (!e) return false;
+    *ref = e->next;
+    sdsFree(e->key);
+    if (valDestructor) valDestructor(e->value);
+    delete e;
+    count--;
+    return true;
+}
+
+void Dict::forEach(const std::function<void(SDS* key, void* value)>& fn) const {
+    for (DictEntry* head : table)
+        for (DictEntry* e = head; e; e = e->next)
+            fn(e->key, e->value);
+}
+
+static size_t reverseBits(size_t v) {
+    size_t r = 0;
+    for (size_t i = 0; i < sizeof(v) * 8; i++, v >>= 1) r = (r << 1) | (v & 1);
+    return r;
+}
+
+//游标的高位在前加一:扩容后一个桶拆成的几个桶在游标序列里是相邻的,已经遍历过的不会再出现在后面
+size_t Dict::scan(size_t cursor, const std::function<void(SDS* key, void* value)>& fn) const {
+    for (DictEntry* e = table[cursor & mask]; e; e = e->next) fn(e->key, e->value);
+    cursor |= ~mask;
+    cursor = reverseBits(cursor);
+    cursor++;
+    return reverseBits(cursor);
 }
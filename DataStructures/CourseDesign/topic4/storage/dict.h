@@ -1,23 +1,48 @@
 #pragma once
 #include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstring>
 #include "sds.h"
 
 struct DictEntry {
     SDS* key;
     void* value;
     DictEntry* next;
+    uint64_t hash;     //完整哈希值:扩容时不用重算,比较 key 之前先比它
 };
 
+enum class DictHashFunction { Wyhash, SipHash };
+
+//全局哈希函数和种子,要在创建任何 Dict 之前设置
+void dictSetHashFunction(DictHashFunction fn);
+void dictSetHashSeed(const uint8_t seed[16]);
+uint64_t dictHash(const char* key, size_t len);
+
 class Dict {
 public:
-    Dict(size_t size = 1024);
+    //valDestructor 用来释放被覆盖/删除的值,为空表示值由调用方管理
+    //size 会向上取整到 2 的幂,元素数达到桶数时扩容一倍
+    Dict(size_t size = 16, void (*valDestructor)(void*) = nullptr);
     ~Dict();
 
-    void set(SDS* key, void* value);
-    void* get(const char* key);
-    bool del(const char* key);
+    void set(SDS* key, void* value);   //接管 key 的所有权,key 已存在时释放传入的 key
+    void* get(const char* key, size_t len);
+    void* get(const char* key) { return get(key, strlen(key)); }
+    bool del(const char* key, size_t len);
+    bool del(const char* key) { return del(key, strlen(key)); }
+    size_t size() const { return count; }
+    size_t buckets() const { return table.size(); }
+    void forEach(const std::function<void(SDS* key, void* value)>& fn) const;
+    //渐进遍历(与 Redis SCAN 相同的反向二进制游标):回调 cursor 指向的一个桶,返回下一个游标,
+    //回到 0 表示遍历完。两次调用之间表扩容了也不会漏掉元素,只可能重复
+    size_t scan(size_t cursor, const std::function<void(SDS* key, void* value)>& fn) const;
 
 private:
-    size_t hash(const char* key);
+    DictEntry** findRef(const char* key, size_t len, uint64_t h);
+    void expand(size_t size);
     std::vector<DictEntry*> table;
+    size_t mask;
+    size_t count = 0;
+    void (*valDestructor)(void*);
 };
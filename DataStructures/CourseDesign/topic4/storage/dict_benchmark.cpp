@@ -0,0 +1,104 @@
+/*Dict 哈希函数与查找的微基准:不同 key 长度下
+  1. 单次哈希耗时:djb2(原来的逐字节实现)、wyhash、SipHash-1-3
+  2. Dict 命中查找耗时:旧实现(djb2 + 取模 + strcmp)与新 Dict(wyhash/SipHash)
+编译: g++ -std=c++17 -O2 -o dict_benchmark dict_benchmark.cpp dict.cpp sds.cpp hashfunc.cpp */
+#include "dict.h"
+#include "hashfunc.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static size_t djb2(const char* key) {
+    size_t h = 5381;
+    while (*key) h = ((h << 5) + h) + *key++;
+    return h;
+}
+
+//原来的 Dict:djb2、取模、链上逐个 strcmp,只保留查找需要的部分。
+//原来固定 1024 个桶;再给一个桶数和新 Dict 相同的版本,单独看哈希和比较的差别
+struct LegacyDict {
+    struct Entry { std::string key; Entry* next; };
+    std::vector<Entry*> table;
+    explicit LegacyDict(size_t buckets) : table(buckets, nullptr) {}
+    ~LegacyDict() {
+        for (Entry* e : table)
+            while (e) { Entry* n = e->next; delete e; e = n; }
+    }
+    void add(const std::string& k) {
+        size_t idx = djb2(k.c_str()) % table.size();
+        table[idx] = new Entry{k, table[idx]};
+    }
+    bool get(const char* k) {
+        for (Entry* e = table[djb2(k) % table.size()]; e; e = e->next)
+            if (strcmp(e->key.c_str(), k) == 0) return true;
+        return false;
+    }
+};
+
+static std::vector<std::string> makeKeys(size_t n, size_t len) {
+    std::vector<std::string> keys;
+    unsigned seed = 42;
+    for (size_t i = 0; i < n; i++) {
+        std::string k = std::to_string(i);   //编号开头保证互不相同,后面用随机字母补到 len
+        while (k.size() < len) {
+            seed = seed * 1103515245 + 12345;
+            k += 'a' + (seed >> 16) % 26;
+        }
+        keys.push_back(k);
+    }
+    return keys;
+}
+
+template <class F>
+static double nsPerOp(size_t ops, F&& fn) {
+    auto start = Clock::now();
+    fn();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+int main() {
+    const size_t N = 200000, ROUNDS = 5;
+    uint8_t seed[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    dictSetHashSeed(seed);
+    volatile uint64_t sink = 0;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "keylen | hash ns: djb2  wyhash  siphash | get ns: legacy(1024)  legacy(same)  wyhash  siphash" << std::endl;
+    for (size_t len : {6, 8, 16, 32, 64, 128, 256, 1024}) {
+        auto keys = makeKeys(N, len);
+        double hDjb = nsPerOp(N * ROUNDS, [&] {
+            for (size_t r = 0; r < ROUNDS; r++) for (auto& k : keys) sink += djb2(k.c_str());
+        });
+        double hWy = nsPerOp(N * ROUNDS, [&] {
+            for (size_t r = 0; r < ROUNDS; r++) for (auto& k : keys) sink += wyhash(k.data(), k.size(), 1);
+        });
+        double hSip = nsPerOp(N * ROUNDS, [&] {
+            for (size_t r = 0; r < ROUNDS; r++) for (auto& k : keys) sink += siphash(k.data(), k.size(), seed);
+        });
+
+        LegacyDict legacy(1024), legacySame(0);
+        double gNew[2];
+        DictHashFunction fns[2] = {DictHashFunction::Wyhash, DictHashFunction::SipHash};
+        for (int f = 0; f < 2; f++) {
+            dictSetHashFunction(fns[f]);
+            Dict d;
+            for (auto& k : keys) d.set(sdsNewLen(k.data(), k.size()), nullptr);
+            if (f == 0) legacySame.table.assign(d.buckets(), nullptr);
+            gNew[f] = nsPerOp(N * ROUNDS, [&] {
+                for (size_t r = 0; r < ROUNDS; r++) for (auto& k : keys) sink += (uintptr_t)d.get(k.data(), k.size());
+            });
+        }
+        for (auto& k : keys) legacy.add(k), legacySame.add(k);
+        double gLegacy = nsPerOp(N, [&] { for (auto& k : keys) sink += legacy.get(k.c_str()); });
+        double gSame = nsPerOp(N * ROUNDS, [&] {
+            for (size_t r = 0; r < ROUNDS; r++) for (auto& k : keys) sink += legacySame.get(k.c_str());
+        });
+        std::cout << std::setw(6) << len << " | " << std::setw(14) << hDjb << std::setw(8) << hWy
+                  << std::setw(9) << hSip << " | " << std::setw(20) << gLegacy << std::setw(14) << gSame << std::setw(8) << gNew[0]
+                  << std::setw(9) << gNew[1] << std::endl;
+    }
+}
@@ -0,0 +1,126 @@
+#include "epoch.h"
+#include <atomic>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+static const int MAX_THREADS = 256;
+static const size_t RECLAIM_BATCH = 64;   //每攒够这么多待释放对象尝试回收一次
+
+struct Retired {
+    void* p;
+    void (*fn)(void*);
+    uint64_t epoch;
+};
+
+//每个槽独占一条 cache line,读线程更新自己的 active 不会干扰别人
+struct alignas(64) EpochSlot {
+    std::atomic<uint64_t> active{0};     //进入临界区时的全局 epoch,0 表示不在临界区
+    std::atomic<bool> used{false};
+    std::vector<Retired> retired;        //只有占用槽位的线程访问
+};
+
+static EpochSlot slots[MAX_THREADS];
+static std::atomic<uint64_t> globalEpoch{1};
+
+//已退出线程留下的待释放对象
+static std::mutex orphanLock;
+static std::vector<Retired> orphans;
+static std::atomic<size_t> orphanCount{0};
+
+static void adoptOrphans(std::vector<Retired>& retired) {
+    if (retired.empty()) return;
+    std::lock_guard<std::mutex> g(orphanLock);
+    orphans.insert(orphans.end(), retired.begin(), retired.end());
+    orphanCount.store(orphans.size(), std::memory_order_relaxed);
+    retired.clear();
+}
+
+//释放孤儿列表里已经安全的对象;别的线程正在处理时直接跳过
+static void reclaimOrphans(uint64_t g) {
+    if (orphanCount.load(std::memory_order_relaxed) == 0) return;
+    std::unique_lock<std::mutex> lock(orphanLock, std::try_to_lock);
+    if (!lock.owns_lock()) return;
+    size_t kept = 0;
+    for (auto& r : orphans) {
+        if (r.epoch + 2 <= g) r.fn(r.p);
+        else orphans[kept++] = r;
+    }
+    orphans.resize(kept);
+    orphanCount.store(kept, std::memory_order_relaxed);
+}
+
+struct ThreadEpoch {
+    EpochSlot* slot = nullptr;
+    int depth = 0;
+    ~ThreadEpoch() {
+        if (!slot) return;
+        epochReclaim();
+        adoptOrphans(slot->retired);
+        slot->used.store(false, std::memory_order_release);
+    }
+};
+
+static thread_local ThreadEpoch self;
+
+static EpochSlot& mySlot() {
+    if (!self.slot) {
+        for (auto& s : slots) {
+            bool expected = false;
+            if (!s.used.load(std::memory_order_relaxed) && s.used.compare_exchange_strong(expected, true)) {
+                self.slot = &s;
+                break;
+            }
+        }
+        if (!self.slot) {
+            std::cerr << "epoch: more than " << MAX_THREADS << " threads" << std::endl;
+            abort();
+        }
+    }
+    return *self.slot;
+}
+
+void epochEnter() {
+    if (self.depth++ > 0) return;
+    EpochSlot& s = mySlot();
+    s.active.store(globalEpoch.load());
+    //先公布自己的 epoch,再读共享结构;seq_cst 保证写线程推进 epoch 时能看到这次公布
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void epochExit() {
+    if (--self.depth > 0) return;
+    self.slot->active.store(0, std::memory_order_release);
+}
+
+//所有在临界区里的线程都已经看到当前 epoch 时推进一步
+static void tryAdvance() {
+    uint64_t e = globalEpoch.load();
+    for (auto& s : slots) {
+        if (!s.used.load(std::memory_order_acquire)) continue;
+        uint64_t a = s.active.load();
+        if (a != 0 && a != e) return;
+    }
+    globalEpoch.compare_exchange_strong(e, e + 1);
+}
+
+size_t epochReclaim() {
+    EpochSlot& s = mySlot();
+    tryAdvance();
+    uint64_t g = globalEpoch.load();
+    size_t kept = 0;
+    for (auto& r : s.retired) {
+        if (r.epoch + 2 <= g) r.fn(r.p);
+        else s.retired[kept++] = r;
+    }
+    s.retired.resize(kept);
+    reclaimOrphans(g);
+    return kept;
+}
+
+void epochRetire(void* p, void (*fn)(void*)) {
+    EpochSlot& s = mySlot();
+    s.retired.push_back({p, fn, globalEpoch.load()});
+    if (s.retired.size() >= RECLAIM_BATCH) epochReclaim();
+}
@@ -0,0 +1,28 @@
+/*基于 epoch 的内存回收(EBR):读线程不加锁遍历共享结构,写线程摘下的节点不能马上释放,
+而是交给 epochRetire,等所有可能还在读它的线程都离开临界区后再释放。
+    全局 epoch 单调递增;线程进入读临界区时记下当前全局 epoch,离开时清零。
+    只有所有活跃线程都已经看到当前 epoch,全局 epoch 才能前进一步。
+    在 epoch e 退休的对象,全局 epoch 到达 e+2 时一定没有读者持有它,可以释放。
+每个线程第一次使用时占一个槽位,线程退出时归还;没释放完的对象转到全局的孤儿列表,
+之后任何线程回收时顺带释放,不用等有线程再占到这个槽位*/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+void epochEnter();
+void epochExit();
+//p 从共享结构摘下之后调用,安全时由 fn(p) 释放
+void epochRetire(void* p, void (*fn)(void*));
+//尝试推进 epoch 并释放本线程能释放的对象,返回本线程还没释放的对象个数
+size_t epochReclaim();
+
+//读临界区,可以嵌套;enabled 为 false 时什么都不做(单线程模式不付出额外开销)
+class EpochGuard {
+public:
+    explicit EpochGuard(bool enabled = true) : enabled(enabled) { if (enabled) epochEnter(); }
+    ~EpochGuard() { if (enabled) epochExit(); }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+private:
+    bool enabled;
+};
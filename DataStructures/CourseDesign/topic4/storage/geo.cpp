@@ -0,0 +1,173 @@
+#include "geo.h"
+#include <cmath>
+#include <algorithm>
+
+static double degRad(double d) { return d * M_PI / 180.0; }
+static double radDeg(double r) { return r / (M_PI / 180.0); }
+
+//把 32 位数的各位分散到 64 位数的偶数位上(位运算的分组移位,不用逐位循环)
+static uint64_t spread(uint32_t v) {
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
+
+static uint32_t squash(uint64_t x) {
+    x &= 0x5555555555555555ULL;
+    x = (x | (x >> 1)) & 0x3333333333333333ULL;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    return (uint32_t)x;
+}
+
+// x 的位放在偶数位,y 的位放在奇数位
+static uint64_t interleave(uint32_t x, uint32_t y) {
+    return spread(x) | (spread(y) << 1);
+}
+
+static void deinterleave(uint64_t bits, uint32_t& x, uint32_t& y) {
+    x = squash(bits);
+    y = squash(bits >> 1);
+}
+
+//坐标在 [lo, hi] 里的格子编号
+static uint32_t cellIndex(double v, double lo, double hi, int step) {
+    double cells = (double)(1ULL << step);
+    double idx = (v - lo) / (hi - lo) * cells;
+    return idx >= cells ? (uint32_t)(cells - 1) : (uint32_t)idx;
+}
+
+static bool encodeRange(double lon, double lat, double latMin, double latMax, int step, uint64_t& bits) {
+    if (lon < GEO_LONG_MIN || lon > GEO_LONG_MAX || lat < latMin || lat > latMax) return false;
+    bits = interleave(cellIndex(lat, latMin, latMax, step), cellIndex(lon, GEO_LONG_MIN, GEO_LONG_MAX, step));
+    return true;
+}
+
+bool geohashEncode(double lon, double lat, int step, uint64_t& bits) {
+    return encodeRange(lon, lat, GEO_LAT_MIN, GEO_LAT_MAX, step, bits);
+}
+
+void geohashDecode(uint64_t bits, int step, double& lon, double& lat) {
+    uint32_t ilat, ilon;
+    deinterleave(bits, ilat, ilon);
+    double cells = (double)(1ULL << step);
+    double h = (GEO_LAT_MAX - GEO_LAT_MIN) / cells, w = (GEO_LONG_MAX - GEO_LONG_MIN) / cells;
+    lat = std::min(GEO_LAT_MAX, GEO_LAT_MIN + (ilat + 0.5) * h);
+    lon = std::min(GEO_LONG_MAX, GEO_LONG_MIN + (ilon + 0.5) * w);
+}
+
+double geoDistance(double lon1, double lat1, double lon2, double lat2) {
+    double lat1r = degRad(lat1), lat2r = degRad(lat2);
+    double u = sin((lat2r - lat1r) / 2), v = sin(degRad(lon2 - lon1) / 2);
+    return 2.0 * GEO_EARTH_RADIUS * asin(sqrt(u * u + cos(lat1r) * cos(lat2r) * v * v));
+}
+
+std::string geohashString(uint64_t bits) {
+    static const char* alphabet = "0123456789bcdefghjkmnpqrstuvwxyz";
+    double lon, lat;
+    geohashDecode(bits, GEO_STEP_MAX, lon, lat);
+    uint64_t std90;
+    encodeRange(lon, lat, -90, 90, GEO_STEP_MAX, std90);
+    std::string s(11, '0');
+    // 52 位只够 10 个字符,最后一个补 0
+    for (int i = 0; i < 10; i++) s[i] = alphabet[(std90 >> (52 - (i + 1) * 5)) & 0x1f];
+    return s;
+}
+
+//查询区域在纬度、经度方向上的半径(度);经度方向按区域里离赤道最远的纬度算,那里一度经度最短
+static void searchSpan(const GeoShape& s, double& dLat, double& dLon) {
+    double halfH = s.box ? s.height / 2 : s.radius, halfW = s.box ? s.width / 2 : s.radius;
+    dLat = radDeg(halfH / GEO_EARTH_RADIUS);
+    double maxLat = std::min(90.0, fabs(s.lat) + dLat);
+    double c = cos(degRad(maxLat));
+    dLon = c < 1e-12 ? 360 : radDeg(halfW / (GEO_EARTH_RADIUS * c));
+}
+
+//选格子的精度:格子的宽、高都不小于查询区域的半宽、半高时,中心格子加一圈邻居一定能盖住整个区域
+static int searchStep(double dLat, double dLon) {
+    int step = GEO_STEP_MAX;
+    while (step > 1) {
+        double cells = (double)(1ULL << step);
+        if ((GEO_LAT_MAX - GEO_LAT_MIN) / cells >= dLat && (GEO_LONG_MAX - GEO_LONG_MIN) / cells >= dLon) break;
+        step--;
+    }
+    return step;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> geoSearchRanges(const GeoShape& shape) {
+    double dLat, dLon;
+    searchSpan(shape, dLat, dLon);
+    int step = searchStep(dLat, dLon);
+    uint64_t center;
+    geohashEncode(shape.lon, std::max(GEO_LAT_MIN, std::min(GEO_LAT_MAX, shape.lat)), step, center);
+    uint32_t ilat, ilon;
+    deinterleave(center, ilat, ilon);
+    int64_t cells = 1LL << step;
+    int shift = 2 * (GEO_STEP_MAX - step);
+    //区域没越过中心格子哪条边,那一侧的邻居就不用扫;通常只剩 4 个格子
+    double h = (GEO_LAT_MAX - GEO_LAT_MIN) / cells, w = (GEO_LONG_MAX - GEO_LONG_MIN) / cells;
+    double lat0 = GEO_LAT_MIN + ilat * h, lon0 = GEO_LONG_MIN + ilon * w;
+    bool need[2][3] = {{shape.lat - dLat < lat0, true, shape.lat + dLat > lat0 + h},
+                       {shape.lon - dLon < lon0, true, shape.lon + dLon > lon0 + w}};
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    for (int di = -1; di <= 1; di++) {
+        int64_t i = (int64_t)ilat + di;
+        if (i < 0 || i >= cells || !need[0][di + 1]) continue;      //纬度不绕回
+        for (int dj = -1; dj <= 1; dj++) {
+            if (!need[1][dj + 1]) continue;
+            int64_t j = ((int64_t)ilon + dj + cells) % cells;   //经度在 ±180 处绕回
+            uint64_t hash = interleave(i, j);
+            ranges.push_back({hash << shift, (hash + 1) << shift});
+        }
+    }
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<uint64_t, uint64_t>> merged;
+    for (auto& r : ranges) {
+        if (!merged.empty() && r.first <= merged.back().second) merged.back().second = std::max(merged.back().second, r.second);
+        else merged.push_back(r);
+    }
+    return merged;
+}
+
+bool geoWithin(const GeoShape& s, double lon, double lat, double& dist) {
+    //先用纬度差粗筛:南北方向的距离只和纬度差有关,超出的不用再算三角函数
+    double halfH = s.box ? s.height / 2 : s.radius;
+    if (GEO_EARTH_RADIUS * fabs(degRad(lat - s.lat)) > halfH) return false;
+    if (!s.box) {
+        dist = geoDistance(s.lon, s.lat, lon, lat);
+        return dist <= s.radius;
+    }
+    //矩形:南北方向沿经线量(上面已经查过),东西方向沿点所在的纬线量
+    if (geoDistance(lon, lat, s.lon, lat) > s.width / 2) return false;
+    dist = geoDistance(s.lon, s.lat, lon, lat);
+    return true;
+}
+
+std::vector<GeoResult> geoSearch(const ZSet& zs, const GeoShape& shape, bool desc, size_t limit, bool any) {
+    std::vector<GeoResult> out;
+    for (auto& r : geoSearchRanges(shape)) {
+        ZRangeSpec range{(double)r.first, (double)r.second, false, true};
+        zs.forEachInRange(range, [&](const char* member, size_t len, double score) {
+            GeoResult g;
+            g.hash = (uint64_t)score;
+            geohashDecode(g.hash, GEO_STEP_MAX, g.lon, g.lat);
+            if (geoWithin(shape, g.lon, g.lat, g.dist)) {
+                g.member.assign(member, len);
+                out.push_back(std::move(g));
+            }
+            return !(any && limit && out.size() >= limit);
+        });
+        if (any && limit && out.size() >= limit) break;
+    }
+    std::sort(out.begin(), out.end(), [desc](const GeoResult& a, const GeoResult& b) {
+        return desc ? a.dist > b.dist : a.dist < b.dist;
+    });
+    if (limit && out.size() > limit) out.resize(limit);
+    return out;
+}
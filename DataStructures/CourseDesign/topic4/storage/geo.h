@@ -0,0 +1,49 @@
+/*GEO:位置存成有序集合里的成员,分数是 52 位的 geohash(经度、纬度各 26 位交错,经度在高位),
+double 能精确表示 52 位整数。geohash 的前缀相同就在同一个格子里,一个格子正好是一段连续的分数,
+所以半径/矩形搜索只要算出覆盖查询区域的格子(中心格子加 8 个邻居),
+在跳表里查这几段分数区间,再按实际距离过滤,不用扫描整个集合。
+纬度范围和 Redis 一样限制在 Web 墨卡托的 ±85.05112878 度*/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include "zset.h"
+
+static const int GEO_STEP_MAX = 26;
+static const double GEO_LAT_MIN = -85.05112878;
+static const double GEO_LAT_MAX = 85.05112878;
+static const double GEO_LONG_MIN = -180;
+static const double GEO_LONG_MAX = 180;
+static const double GEO_EARTH_RADIUS = 6372797.560856;     //米,和 Redis 相同
+
+//坐标超出范围返回 false
+bool geohashEncode(double lon, double lat, int step, uint64_t& bits);
+//格子中心的坐标
+void geohashDecode(uint64_t bits, int step, double& lon, double& lat);
+double geoDistance(double lon1, double lat1, double lon2, double lat2);    //大圆距离(米)
+// GEOHASH 命令返回的 11 位标准 base32 geohash(纬度范围按 ±90 重新编码)
+std::string geohashString(uint64_t bits);
+
+//查询区域:以 (lon, lat) 为中心,半径 radius 的圆,或者宽 width 高 height 的矩形(米)
+struct GeoShape {
+    double lon, lat;
+    bool box = false;
+    double radius = 0, width = 0, height = 0;
+};
+
+//要扫的分数区间 [first, second),相邻的已经合并,最多 9 段(区域没越过的那几侧的邻居不算在内)
+std::vector<std::pair<uint64_t, uint64_t>> geoSearchRanges(const GeoShape& shape);
+//到中心的距离,不在区域内返回 false
+bool geoWithin(const GeoShape& shape, double lon, double lat, double& dist);
+
+struct GeoResult {
+    std::string member;
+    double dist;
+    uint64_t hash;
+    double lon, lat;
+};
+
+// GEOSEARCH 的主体:只扫 geoSearchRanges 的几段分数区间。limit 为 0 表示不限;
+// 给了 limit 且 any 时找够 limit 个就停(结果不保证最近),否则收集全部再排序截断
+std::vector<GeoResult> geoSearch(const ZSet& zs, const GeoShape& shape, bool desc, size_t limit, bool any);
@@ -0,0 +1,110 @@
+#include "hashfunc.h"
+#include <cstring>
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// 64x64 位乘法,结果的低 64 位放 a,高 64 位放 b
+static inline void mum(uint64_t* a, uint64_t* b) {
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+}
+
+static inline uint64_t mix(uint64_t a, uint64_t b) {
+    mum(&a, &b);
+    return a ^ b;
+}
+
+static const uint64_t WYP[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+                                0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+uint64_t wyhash(const void* key, size_t len, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(key);
+    seed ^= mix(seed ^ WYP[0], WYP[1]);
+    uint64_t a, b;
+    if (len <= 16) {
+        //短 key 不循环:用首尾重叠的两次 4 字节读取覆盖全部字节
+        if (len >= 4) {
+            size_t mid = (len >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + mid);
+            b = (read32(p + len - 4) << 32) | read32(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t s1 = seed, s2 = seed;
+            do {
+                seed = mix(read64(p) ^ WYP[1], read64(p + 8) ^ seed);
+                s1 = mix(read64(p + 16) ^ WYP[2], read64(p + 24) ^ s1);
+                s2 = mix(read64(p + 32) ^ WYP[3], read64(p + 40) ^ s2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= s1 ^ s2;
+        }
+        while (i > 16) {
+            seed = mix(read64(p) ^ WYP[1], read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
+    }
+    a ^= WYP[1];
+    b ^= seed;
+    mum(&a, &b);
+    return mix(a ^ WYP[0] ^ len, b ^ WYP[1]);
+}
+
+#define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define SIPROUND                                                       \
+    do {                                                               \
+        v0 += v1; v1 = ROTL(v1, 13); v1 ^= v0; v0 = ROTL(v0, 32);      \
+        v2 += v3; v3 = ROTL(v3, 16); v3 ^= v2;                         \
+        v0 += v3; v3 = ROTL(v3, 21); v3 ^= v0;                         \
+        v2 += v1; v1 = ROTL(v1, 17); v1 ^= v2; v2 = ROTL(v2, 32);      \
+    } while (0)
+
+// SipHash-c-d,Redis 用的是 1-3(每块 1 轮、结束 3 轮)
+template <int C, int D>
+static uint64_t siphashRounds(const uint8_t* in, size_t len, const uint8_t k[16]) {
+    uint64_t k0 = read64(k), k1 = read64(k + 8);
+    uint64_t v0 = 0x736f6d6570736575ull ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dull ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ull ^ k0;
+    uint64_t v3 = 0x7465646279746573ull ^ k1;
+    const uint8_t* end = in + len - (len % 8);
+    for (; in != end; in += 8) {
+        uint64_t m = read64(in);
+        v3 ^= m;
+        for (int i = 0; i < C; i++) SIPROUND;
+        v0 ^= m;
+    }
+    uint64_t b = (uint64_t)len << 56;
+    for (size_t i = 0; i < (len & 7); i++) b |= (uint64_t)in[i] << (8 * i);
+    v3 ^= b;
+    for (int i = 0; i < C; i++) SIPROUND;
+    v0 ^= b;
+    v2 ^= 0xff;
+    for (int i = 0; i < D; i++) SIPROUND;
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+uint64_t siphash(const void* key, size_t len, const uint8_t k[16]) {
+    return siphashRounds<1, 3>(static_cast<const uint8_t*>(key), len, k);
+}
@@ -0,0 +1,10 @@
+/*Dict 用的哈希函数:
+    wyhash   每次处理 8 字节(长 key 每轮 48 字节三路并行),靠 64x64->128 位乘法混合,速度快、分布好
+    SipHash  SipHash-1-3,带 128 位密钥,外部无法构造大量冲突的 key(抗 HashDoS),速度慢一些
+两者都带种子,进程启动时随机生成,同一个 key 在不同进程里哈希值不同*/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+uint64_t wyhash(const void* key, size_t len, uint64_t seed);
+uint64_t siphash(const void* key, size_t len, const uint8_t k[16]);
@@ -0,0 +1,139 @@
+#include "hyperloglog.h"
+#include "hashfunc.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//固定种子:同一个元素在任何进程里都落在同一个寄存器,不同节点的 HLL 才能合并
+static const uint64_t HLL_SEED = 0xadc83b19ull;
+
+HyperLogLog::~HyperLogLog() {
+    free(dense);
+}
+
+size_t HyperLogLog::bytes() const {
+    return dense ? HLL_REGISTERS : sparse.size() * sizeof(uint32_t);
+}
+
+bool HyperLogLog::add(const char* data, size_t len) {
+    uint64_t h = wyhash(data, len, HLL_SEED);
+    int index = h & (HLL_REGISTERS - 1);
+    //最高位补一个 1,保证剩下的位全为 0 时观测值也不超过 HLL_Q + 1
+    uint64_t rest = (h >> HLL_P) | (1ull << HLL_Q);
+    return set(index, __builtin_ctzll(rest) + 1);
+}
+
+bool HyperLogLog::set(int index, uint8_t value) {
+    if (dense) {
+        if (dense[index] >= value) return false;
+        dense[index] = value;
+        cached = -1;
+        return true;
+    }
+    uint32_t key = (uint32_t)index << 8;
+    auto it = std::lower_bound(sparse.begin(), sparse.end(), key);
+    if (it != sparse.end() && (*it >> 8) == (uint32_t)index) {
+        if ((*it & 0xFF) >= value) return false;
+        *it = key | value;
+    } else {
+        sparse.insert(it, key | value);
+    }
+    cached = -1;
+    if (sparse.size() * sizeof(uint32_t) > HLL_SPARSE_MAX_BYTES) toDense();
+    return true;
+}
+
+void HyperLogLog::registers(uint8_t* out) const {
+    if (dense) {
+        memcpy(out, dense, HLL_REGISTERS);
+        return;
+    }
+    memset(out, 0, HLL_REGISTERS);
+    for (uint32_t e : sparse) out[e >> 8] = e & 0xFF;
+}
+
+std::string HyperLogLog::dump() const {
+    std::string out(HLL_REGISTERS, '\0');
+    registers(reinterpret_cast<uint8_t*>(&out[0]));
+    return out;
+}
+
+bool HyperLogLog::restore(const std::string& regs) {
+    if (regs.size() != (size_t)HLL_REGISTERS) return false;
+    for (unsigned char v : regs)
+        if (v > HLL_Q + 1) return false;
+    for (int i = 0; i < HLL_REGISTERS; i++)
+        if (regs[i]) set(i, regs[i]);
+    return true;
+}
+
+void HyperLogLog::toDense() {
+    uint8_t* d = static_cast<uint8_t*>(aligned_alloc(16, HLL_REGISTERS));
+    registers(d);
+    dense = d;
+    std::vector<uint32_t>().swap(sparse);
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    if (!other.dense) {
+        for (uint32_t e : other.sparse) set(e >> 8, e & 0xFF);
+        return;
+    }
+    if (!dense) toDense();
+#ifdef __SSE2__
+    for (int i = 0; i < HLL_REGISTERS; i += 16) {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(dense + i));
+        __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(other.dense + i));
+        _mm_store_si128(reinterpret_cast<__m128i*>(dense + i), _mm_max_epu8(a, b));
+    }
+#else
+    for (int i = 0; i < HLL_REGISTERS; i++) dense[i] = std::max(dense[i], other.dense[i]);
+#endif
+    cached = -1;
+}
+
+static double hllSigma(double x) {
+    if (x == 1.0) return INFINITY;
+    double y = 1, z = x, zPrev;
+    do {
+        x *= x;
+        zPrev = z;
+        z += x * y;
+        y += y;
+    } while (zPrev != z);
+    return z;
+}
+
+static double hllTau(double x) {
+    if (x == 0.0 || x == 1.0) return 0;
+    double y = 1, z = 1 - x, zPrev;
+    do {
+        x = std::sqrt(x);
+        zPrev = z;
+        y *= 0.5;
+        z -= (1 - x) * (1 - x) * y;
+    } while (zPrev != z);
+    return z / 3;
+}
+
+// Ertl, "New cardinality estimation algorithms for HyperLogLog sketches"
+uint64_t HyperLogLog::count() const {
+    if (cached >= 0) return cached;
+    int hist[HLL_Q + 2] = {0};
+    if (dense) {
+        for (int i = 0; i < HLL_REGISTERS; i++) hist[dense[i]]++;
+    } else {
+        hist[0] = HLL_REGISTERS - sparse.size();
+        for (uint32_t e : sparse) hist[e & 0xFF]++;
+    }
+    const double m = HLL_REGISTERS;
+    double z = m * hllTau((m - hist[HLL_Q + 1]) / m);
+    for (int k = HLL_Q; k >= 1; k--) z = 0.5 * (z + hist[k]);
+    z += m * hllSigma(hist[0] / m);
+    cached = llroundl(0.5 / std::log(2.0) * m * m / z);
+    return cached;
+}
@@ -0,0 +1,43 @@
+/*HyperLogLog:用固定的几 KB 估计集合里不同元素的个数,标准误差约 1.04/sqrt(4096) = 1.6%。
+    元素的 64 位哈希:低 12 位选寄存器,剩下的位里第一个 1 出现的位置(从 1 数起)是观测值,
+    每个寄存器记最大观测值。寄存器用整字节存,合并时可以用 SSE2 一次比较 16 个。
+两种编码:
+    稀疏  只存非零寄存器,按下标排序的 (下标<<8 | 值),元素少时只占几十字节
+    稠密  4096 个字节,稀疏部分超过 HLL_SPARSE_MAX_BYTES 时转换,之后不再转回
+估计值用 Ertl 的改进算法(Redis 也用它),各个基数范围都不需要偏差修正表*/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+
+static const int HLL_P = 12;
+static const int HLL_REGISTERS = 1 << HLL_P;
+static const int HLL_Q = 64 - HLL_P;                     //观测值最大是 HLL_Q + 1
+static const size_t HLL_SPARSE_MAX_BYTES = 3000;
+
+class HyperLogLog {
+public:
+    HyperLogLog() = default;
+    ~HyperLogLog();
+    HyperLogLog(const HyperLogLog&) = delete;
+    HyperLogLog& operator=(const HyperLogLog&) = delete;
+
+    bool add(const char* data, size_t len);   //有寄存器变大时返回 true
+    uint64_t count() const;
+    void merge(const HyperLogLog& other);     //取每个寄存器的最大值
+    bool isDense() const { return dense != nullptr; }
+    size_t bytes() const;                     //寄存器部分占的字节数
+    //迁移用:导出为 4096 个寄存器字节;restore 只能用在空的 HLL 上,长度或取值不对时返回 false
+    std::string dump() const;
+    bool restore(const std::string& regs);
+
+private:
+    bool set(int index, uint8_t value);
+    void toDense();
+    void registers(uint8_t* out) const;       //展开成 4096 个寄存器
+
+    std::vector<uint32_t> sparse;
+    uint8_t* dense = nullptr;                 // 16 字节对齐
+    mutable int64_t cached = -1;              //上次算出的基数,修改后失效
+};
@@ -0,0 +1,47 @@
+#include "lazyfree.h"
+#include "dict.h"
+#include "rax.h"
+
+LazyFree::~LazyFree() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        stopping = true;
+    }
+    cv.notify_one();
+    worker.join();
+}
+
+void LazyFree::freeDict(Dict* d) {
+    if (d->size() < LAZYFREE_THRESHOLD) delete d;
+    else submit([d] { delete d; }, d->size());
+}
+
+void LazyFree::freeRax(Rax* r) {
+    if (r->size() < LAZYFREE_THRESHOLD) delete r;
+    else submit([r] { delete r; }, r->size());
+}
+
+void LazyFree::submit(std::function<void()> job, size_t objects) {
+    pendingObjects.fetch_add(objects, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        queue.emplace_back(std::move(job), objects);
+        if (!worker.joinable()) worker = std::thread(&LazyFree::run, this);
+    }
+    cv.notify_one();
+}
+
+void LazyFree::run() {
+    std::unique_lock<std::mutex> lk(mu);
+    while (true) {
+        cv.wait(lk, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) return;      // stopping 且队列已空
+        auto job = std::move(queue.front());
+        queue.pop_front();
+        lk.unlock();
+        job.first();
+        pendingObjects.fetch_sub(job.second, std::memory_order_relaxed);
+        lk.lock();
+    }
+}
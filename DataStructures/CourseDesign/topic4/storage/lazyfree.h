@@ -0,0 +1,41 @@
+/*后台释放:FLUSHDB/FLUSHALL ASYNC 把整张表从库里摘下来交给后台线程 delete,
+清空千万级 key 的库时事件循环不会被逐个释放对象卡住。
+对象的引用计数是原子的,网络层正在发送的大值即使所在的表在后台被释放,也要等发送完才真正释放*/
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <cstddef>
+
+class Dict;
+class Rax;
+
+static const size_t LAZYFREE_THRESHOLD = 64;    //元素少于它的表直接同步释放,不值得交给后台
+
+class LazyFree {
+public:
+    LazyFree() = default;
+    ~LazyFree();    //等队列里的表全部释放完
+    LazyFree(const LazyFree&) = delete;
+    LazyFree& operator=(const LazyFree&) = delete;
+
+    //接管 d;小表当场释放,大表放进队列(第一次用到时才启动线程)
+    void freeDict(Dict* d);
+    void freeRax(Rax* r);
+    size_t pending() const { return pendingObjects.load(std::memory_order_relaxed); }   //还没释放的元素数
+
+private:
+    void submit(std::function<void()> job, size_t objects);
+    void run();
+
+    std::thread worker;
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<std::pair<std::function<void()>, size_t>> queue;     //释放任务和它释放的元素数
+    bool stopping = false;
+    std::atomic<size_t> pendingObjects{0};
+};
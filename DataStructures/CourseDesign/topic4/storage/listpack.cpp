@@ -0,0 +1,321 @@
+#include "listpack.h"
+#include <cstring>
+#include <cstdlib>
+
+static const size_t LP_HDR = 8;
+static const unsigned char LP_EOF = 0xFF;
+
+static uint32_t readU32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void writeU32(unsigned char* p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+//只接受规范写法的整数("12" 可以,"012"、"+1"、"-0" 不行),保证取出来和存进去一模一样
+static bool stringToInt64(const char* s, size_t len, int64_t* out) {
+    if (len == 0 || len > 20) return false;
+    size_t i = 0;
+    bool neg = false;
+    if (s[0] == '-') {
+        neg = true;
+        i = 1;
+        if (len == 1) return false;
+    }
+    if (s[i] == '0' && (len > i + 1 || neg)) return false;
+    uint64_t v = 0;
+    for (; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        uint64_t d = s[i] - '0';
+        if (v > (UINT64_MAX - d) / 10) return false;
+        v = v * 10 + d;
+    }
+    if (neg) {
+        if (v > (uint64_t)INT64_MAX + 1) return false;
+        *out = (int64_t)(0 - v);
+    } else {
+        if (v > (uint64_t)INT64_MAX) return false;
+        *out = (int64_t)v;
+    }
+    return true;
+}
+
+static size_t backlenSize(size_t l) {
+    if (l < 128) return 1;
+    if (l < 16384) return 2;
+    if (l < 2097152) return 3;
+    if (l < 268435456) return 4;
+    return 5;
+}
+
+//每字节 7 位,低位在最右边;除最左边一个字节外最高位都是 1,倒着读时据此判断是否继续
+static void writeBacklen(unsigned char* p, size_t l) {
+    size_t n = backlenSize(l);
+    for (size_t i = 0; i < n; i++)
+        p[n - 1 - i] = ((l >> (7 * i)) & 127) | (i < n - 1 ? 128 : 0);
+}
+
+// p 指向 backlen 的最后一个字节
+static size_t readBacklen(const unsigned char* p) {
+    size_t v = 0, shift = 0;
+    while (true) {
+        v |= (size_t)(*p & 127) << shift;
+        if (!(*p & 128)) break;
+        p--;
+        shift += 7;
+    }
+    return v;
+}
+
+static size_t encodeInteger(unsigned char* buf, int64_t v) {
+    if (v >= 0 && v <= 127) {
+        buf[0] = (unsigned char)v;
+        return 1;
+    }
+    int bytes;
+    if (v >= INT16_MIN && v <= INT16_MAX) { buf[0] = 0xF1; bytes = 2; }
+    else if (v >= -(1 << 23) && v < (1 << 23)) { buf[0] = 0xF2; bytes = 3; }
+    else if (v >= INT32_MIN && v <= INT32_MAX) { buf[0] = 0xF3; bytes = 4; }
+    else { buf[0] = 0xF4; bytes = 8; }
+    uint64_t u = (uint64_t)v;
+    for (int i = 0; i < bytes; i++) buf[1 + i] = (u >> (8 * i)) & 0xFF;
+    return 1 + bytes;
+}
+
+//编码后的 "编码+数据" 长度,buf 为空时只计算长度
+static size_t encodeString(unsigned char* buf, const char* s, size_t len) {
+    int64_t v;
+    if (stringToInt64(s, len, &v)) {
+        unsigned char tmp[9];
+        size_t n = encodeInteger(tmp, v);
+        if (buf) memcpy(buf, tmp, n);
+        return n;
+    }
+    size_t hdr;
+    if (len < 64) hdr = 1;
+    else if (len < 8192) hdr = 2;
+    else hdr = 5;
+    if (!buf) return hdr + len;
+    if (hdr == 1) {
+        buf[0] = 0x80 | len;
+    } else if (hdr == 2) {
+        buf[0] = 0xC0 | (len >> 8);
+        buf[1] = len & 0xFF;
+    } else {
+        buf[0] = 0xF0;
+        writeU32(buf + 1, len);
+    }
+    memcpy(buf + hdr, s, len);
+    return hdr + len;
+}
+
+//元素 "编码+数据" 部分的长度
+static size_t encodedSize(const unsigned char* p) {
+    unsigned char b = p[0];
+    if (b < 0x80) return 1;
+    if ((b & 0xC0) == 0x80) return 1 + (b & 0x3F);
+    if ((b & 0xE0) == 0xC0) return 2 + (((b & 0x1F) << 8) | p[1]);
+    switch (b) {
+        case 0xF1: return 3;
+        case 0xF2: return 4;
+        case 0xF3: return 5;
+        case 0xF4: return 9;
+        default: return 5 + readU32(p + 1);  // 0xF0
+    }
+}
+
+static size_t entrySize(const unsigned char* p) {
+    size_t l = encodedSize(p);
+    return l + backlenSize(l);
+}
+
+unsigned char* lpNew() {
+    unsigned char* lp = static_cast<unsigned char*>(malloc(LP_HDR + 1));
+    writeU32(lp, LP_HDR + 1);
+    writeU32(lp + 4, 0);
+    lp[LP_HDR] = LP_EOF;
+    return lp;
+}
+
+void lpFree(unsigned char* lp) {
+    free(lp);
+}
+
+size_t lpBytes(const unsigned char* lp) {
+    return readU32(lp);
+}
+
+uint32_t lpLength(const unsigned char* lp) {
+    return readU32(lp + 4);
+}
+
+unsigned char* lpFirst(unsigned char* lp) {
+    unsigned char* p = lp + LP_HDR;
+    return *p == LP_EOF ? nullptr : p;
+}
+
+unsigned char* lpNext(unsigned char*, unsigned char* p) {
+    p += entrySize(p);
+    return *p == LP_EOF ? nullptr : p;
+}
+
+unsigned char* lpPrev(unsigned char* lp, unsigned char* p) {
+    if (p == lp + LP_HDR) return nullptr;
+    size_t l = readBacklen(p - 1);
+    return p - backlenSize(l) - l;
+}
+
+unsigned char* lpLast(unsigned char* lp) {
+    unsigned char* eof = lp + lpBytes(lp) - 1;
+    return lpPrev(lp, eof);
+}
+
+const unsigned char* lpGet(const unsigned char* p, uint32_t* len, int64_t* ival) {
+    unsigned char b = p[0];
+    if (b < 0x80) {
+        *ival = b;
+        return nullptr;
+    }
+    if ((b & 0xC0) == 0x80) {
+        *len = b & 0x3F;
+        return p + 1;
+    }
+    if ((b & 0xE0) == 0xC0) {
+        *len = ((b & 0x1F) << 8) | p[1];
+        return p + 2;
+    }
+    if (b == 0xF0) {
+        *len = readU32(p + 1);
+        return p + 5;
+    }
+    int bytes = b == 0xF1 ? 2 : b == 0xF2 ? 3 : b == 0xF3 ? 4 : 8;
+    uint64_t u = 0;
+    for (int i = 0; i < bytes; i++) u |= (uint64_t)p[1 + i] << (8 * i);
+    //符号扩展
+    if (bytes < 8 && (u >> (bytes * 8 - 1)) & 1) u |= ~0ULL << (bytes * 8);
+    *ival = (int64_t)u;
+    return nullptr;
+}
+
+std::string lpGetString(const unsigned char* p) {
+    uint32_t len;
+    int64_t v;
+    const unsigned char* s = lpGet(p, &len, &v);
+    if (s) return std::string(reinterpret_cast<const char*>(s), len);
+    return std::to_string(v);
+}
+
+int64_t lpGetInteger(const unsigned char* p) {
+    uint32_t len;
+    int64_t v = 0;
+    const unsigned char* s = lpGet(p, &len, &v);
+    if (s) stringToInt64(reinterpret_cast<const char*>(s), len, &v);
+    return v;
+}
+
+//在 offset 处插入一段已经编码好的 "编码+数据"
+static unsigned char* insertEncoded(unsigned char* lp, size_t offset, const unsigned char* enc, size_t encLen) {
+    size_t blen = backlenSize(encLen);
+    size_t add = encLen + blen;
+    size_t old = lpBytes(lp);
+    lp = static_cast<unsigned char*>(realloc(lp, old + add));
+    memmove(lp + offset + add, lp + offset, old - offset);
+    memcpy(lp + offset, enc, encLen);
+    writeBacklen(lp + offset + encLen, encLen);
+    writeU32(lp, old + add);
+    writeU32(lp + 4, lpLength(lp) + 1);
+    return lp;
+}
+
+unsigned char* lpInsert(unsigned char* lp, size_t offset, const char* s, size_t len) {
+    size_t encLen = encodeString(nullptr, s, len);
+    unsigned char small[64];
+    unsigned char* enc = encLen <= sizeof(small) ? small : static_cast<unsigned char*>(malloc(encLen));
+    encodeString(enc, s, len);
+    lp = insertEncoded(lp, offset, enc, encLen);
+    if (enc != small) free(enc);
+    return lp;
+}
+
+unsigned char* lpAppend(unsigned char* lp, const char* s, size_t len) {
+    return lpInsert(lp, lpBytes(lp) - 1, s, len);
+}
+
+//一次追加多个元素,只 realloc 一次
+unsigned char* lpAppendBatch(unsigned char* lp, const std::string* items, size_t n) {
+    size_t add = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t l = encodeString(nullptr, items[i].data(), items[i].size());
+        add += l + backlenSize(l);
+    }
+    size_t old = lpBytes(lp);
+    lp = static_cast<unsigned char*>(realloc(lp, old + add));
+    unsigned char* p = lp + old - 1;
+    for (size_t i = 0; i < n; i++) {
+        size_t l = encodeString(p, items[i].data(), items[i].size());
+        writeBacklen(p + l, l);
+        p += l + backlenSize(l);
+    }
+    *p = LP_EOF;
+    writeU32(lp, old + add);
+    writeU32(lp + 4, lpLength(lp) + n);
+    return lp;
+}
+
+unsigned char* lpAppendInteger(unsigned char* lp, int64_t v) {
+    unsigned char enc[9];
+    size_t n = encodeInteger(enc, v);
+    return insertEncoded(lp, lpBytes(lp) - 1, enc, n);
+}
+
+unsigned char* lpDelete(unsigned char* lp, size_t offset, uint32_t num) {
+    unsigned char* p = lp + offset;
+    uint32_t deleted = 0;
+    while (deleted < num && *p != LP_EOF) {
+        p += entrySize(p);
+        deleted++;
+    }
+    size_t span = p - (lp + offset);
+    size_t old = lpBytes(lp);
+    memmove(lp + offset, p, old - offset - span);
+    writeU32(lp, old - span);
+    writeU32(lp + 4, lpLength(lp) - deleted);
+    return static_cast<unsigned char*>(realloc(lp, old - span));
+}
+
+unsigned char* lpReplace(unsigned char* lp, size_t offset, const char* s, size_t len) {
+    lp = lpDelete(lp, offset, 1);
+    return lpInsert(lp, offset, s, len);
+}
+
+//长度不变时原地改写(计数器之类的小整数几乎总是这样),不用移动后面的数据
+unsigned char* lpReplaceInteger(unsigned char* lp, size_t offset, int64_t v) {
+    unsigned char enc[9];
+    size_t n = encodeInteger(enc, v);
+    if (n == encodedSize(lp + offset)) {
+        memcpy(lp + offset, enc, n);
+        return lp;
+    }
+    lp = lpDelete(lp, offset, 1);
+    return insertEncoded(lp, offset, enc, n);
+}
+
+unsigned char* lpFind(unsigned char* lp, unsigned char* p, const char* s, size_t len, uint32_t skip) {
+    int64_t sval;
+    bool sIsInt = stringToInt64(s, len, &sval);
+    while (p) {
+        uint32_t elen;
+        int64_t ival;
+        const unsigned char* e = lpGet(p, &elen, &ival);
+        //能转成整数的字符串一定按整数存,所以类型不同就不可能相等
+        if (e) {
+            if (!sIsInt && elen == len && memcmp(e, s, len) == 0) return p;
+        } else if (sIsInt && ival == sval) {
+            return p;
+        }
+        p = lpNext(lp, p);
+        for (uint32_t i = 0; i < skip && p; i++) p = lpNext(lp, p);
+    }
+    return nullptr;
+}
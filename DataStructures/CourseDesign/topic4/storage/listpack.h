@@ -0,0 +1,49 @@
+/*listpack:紧凑列表,所有元素连续放在一块内存里,没有指针和 DictEntry 的开销,
+适合元素少、元素小的集合。布局:
+    <总字节数 uint32> <元素个数 uint32> <元素1> <元素2> ... <0xFF 结束符>
+每个元素:
+    <编码+数据> <backlen>
+编码(参考 Redis listpack):
+    0xxxxxxx                    7 位无符号整数
+    10xxxxxx <数据>              长度 < 64 的字符串
+    110xxxxx xxxxxxxx <数据>     长度 < 8192 的字符串
+    11110001 <2 字节>            int16
+    11110010 <3 字节>            int24
+    11110011 <4 字节>            int32
+    11110100 <8 字节>            int64
+    11110000 <4 字节长度> <数据> 长字符串
+backlen 是 "编码+数据" 的长度,倒着存,用于从后往前遍历。
+能表示成整数的字符串(如 "123")按整数存,更省空间。
+修改操作可能 realloc,返回新的指针,调用方要用返回值替换旧指针*/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+unsigned char* lpNew();
+void lpFree(unsigned char* lp);
+size_t lpBytes(const unsigned char* lp);
+uint32_t lpLength(const unsigned char* lp);
+
+//遍历:没有元素时返回 nullptr
+unsigned char* lpFirst(unsigned char* lp);
+unsigned char* lpLast(unsigned char* lp);
+unsigned char* lpNext(unsigned char* lp, unsigned char* p);
+unsigned char* lpPrev(unsigned char* lp, unsigned char* p);
+
+//读取元素:字符串返回数据指针并写 *len;整数返回 nullptr 并写 *ival
+const unsigned char* lpGet(const unsigned char* p, uint32_t* len, int64_t* ival);
+std::string lpGetString(const unsigned char* p);
+int64_t lpGetInteger(const unsigned char* p);   //元素必须是整数或可解析成整数的字符串
+
+//修改:offset 是元素相对 lp 起点的偏移(lpFirst 等返回的指针减 lp)
+unsigned char* lpAppend(unsigned char* lp, const char* s, size_t len);
+unsigned char* lpAppendInteger(unsigned char* lp, int64_t v);
+unsigned char* lpAppendBatch(unsigned char* lp, const std::string* items, size_t n);
+unsigned char* lpInsert(unsigned char* lp, size_t offset, const char* s, size_t len);
+unsigned char* lpReplace(unsigned char* lp, size_t offset, const char* s, size_t len);
+unsigned char* lpReplaceInteger(unsigned char* lp, size_t offset, int64_t v);
+unsigned char* lpDelete(unsigned char* lp, size_t offset, uint32_t num);
+
+//从 p 开始查找内容等于 s 的元素,每比较一个后跳过 skip 个(哈希表里跳过 value 只比较 field)
+unsigned char* lpFind(unsigned char* lp, unsigned char* p, const char* s, size_t len, uint32_t skip);
@@ -0,0 +1,179 @@
+#include "lz4.h"
+#include <cstdint>
+#include <cstring>
+
+static const size_t MINMATCH = 4;
+static const size_t LASTLITERALS = 5;      //最后这么多字节必须是字面量
+static const size_t MFLIMIT = 12;          //匹配必须在结尾前这么多字节之前开始
+static const size_t MAX_DISTANCE = 65535;
+static const int HASH_LOG = 12;
+
+static uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static uint32_t hash4(uint32_t seq) {
+    return (seq * 2654435761U) >> (32 - HASH_LOG);
+}
+
+//长度续写:先减掉 token 里放下的 15,再每字节 255 地写
+static uint8_t* writeLength(uint8_t* op, size_t len) {
+    for (; len >= 255; len -= 255) *op++ = 255;
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+size_t lz4Compress(const char* src, size_t n, char* dst, size_t cap) {
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* ip = base;
+    const uint8_t* anchor = base;
+    const uint8_t* end = base + n;
+    uint8_t* op = reinterpret_cast<uint8_t*>(dst);
+    uint8_t* oend = op + cap;
+    //位置从 0 开始,0 也可能是真实位置;候选位置都会比对内容,初始的 0 最多白比一次
+    uint32_t table[1 << HASH_LOG] = {0};
+
+    if (n >= MFLIMIT + 1) {
+        const uint8_t* mflimit = end - MFLIMIT;
+        const uint8_t* matchlimit = end - LASTLITERALS;
+        ip++;
+        while (ip < mflimit) {
+            uint32_t seq = read32(ip);
+            uint32_t h = hash4(seq);
+            const uint8_t* ref = base + table[h];
+            table[h] = (uint32_t)(ip - base);
+            if (ref >= ip || (size_t)(ip - ref) > MAX_DISTANCE || read32(ref) != seq) {
+                //越久找不到匹配步子越大,不可压缩的数据很快扫过去
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            //每次比 8 字节,第一个不同的字节由异或结果的末尾 0 个数算出来(小端)
+            const uint8_t* mp = ip + MINMATCH;
+            const uint8_t* rp = ref + MINMATCH;
+            while (mp + 8 <= matchlimit) {
+                uint64_t diff = read64(mp) ^ read64(rp);
+                if (diff) {
+                    mp += __builtin_ctzll(diff) >> 3;
+                    goto matched;
+                }
+                mp += 8;
+                rp += 8;
+            }
+            while (mp < matchlimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+        matched:
+            size_t lit = ip - anchor, match = mp - ip - MINMATCH;
+            if ((size_t)(oend - op) < 1 + lit / 255 + 1 + lit + 2 + match / 255 + 1 + 1 + LASTLITERALS) return 0;
+            uint8_t* token = op++;
+            if (lit >= 15) {
+                *token = 15 << 4;
+                op = writeLength(op, lit - 15);
+            } else {
+                *token = (uint8_t)(lit << 4);
+            }
+            memcpy(op, anchor, lit);
+            op += lit;
+            size_t offset = ip - ref;
+            *op++ = offset & 0xFF;
+            *op++ = offset >> 8;
+            if (match >= 15) {
+                *token |= 15;
+                op = writeLength(op, match - 15);
+            } else {
+                *token |= (uint8_t)match;
+            }
+            ip = anchor = mp;
+            //匹配中间的位置也登记一个,提高下一次命中的概率
+            if (ip - 2 > base && ip < mflimit) table[hash4(read32(ip - 2))] = (uint32_t)(ip - 2 - base);
+        }
+    }
+
+    size_t lit = end - anchor;
+    if ((size_t)(oend - op) < 1 + lit / 255 + 1 + lit) return 0;
+    if (lit >= 15) {
+        *op++ = 15 << 4;
+        op = writeLength(op, lit - 15);
+    } else {
+        *op++ = (uint8_t)(lit << 4);
+    }
+    memcpy(op, anchor, lit);
+    op += lit;
+    return op - reinterpret_cast<uint8_t*>(dst);
+}
+
+//读长度续写,数据不够时返回 false
+static bool readLength(const uint8_t*& ip, const uint8_t* iend, size_t& len) {
+    uint8_t b;
+    do {
+        if (ip >= iend) return false;
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+//每次复制 8 字节,可能多写最多 7 字节;调用方保证 dst 后面有这么多空间。
+// src 和 dst 相距不小于 8 时,重叠也不影响结果
+static void wildCopy8(uint8_t* dst, const uint8_t* src, size_t n) {
+    uint8_t* end = dst + n;
+    do {
+        memcpy(dst, src, 8);
+        dst += 8;
+        src += 8;
+    } while (dst < end);
+}
+
+bool lz4Decompress(const char* src, size_t n, char* dst, size_t rawLen) {
+    const uint8_t* ip = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* iend = ip + n;
+    uint8_t* const obase = reinterpret_cast<uint8_t*>(dst);
+    uint8_t* op = obase;
+    uint8_t* oend = obase + rawLen;
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !readLength(ip, iend, lit)) return false;
+        if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op)) return false;
+        //离两边的结尾都还远时整块复制,多写的部分马上会被后面的数据覆盖
+        if (lit + 8 <= (size_t)(iend - ip) && lit + 8 <= (size_t)(oend - op)) wildCopy8(op, ip, lit);
+        else memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == iend) break;      //最后一个序列只有字面量
+
+        if (iend - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - obase)) return false;
+        size_t match = token & 15;
+        if (match == 15 && !readLength(ip, iend, match)) return false;
+        match += MINMATCH;
+        if (match > (size_t)(oend - op)) return false;
+        const uint8_t* ref = op - offset;
+        if (offset >= 8 && match + 8 <= (size_t)(oend - op)) {
+            wildCopy8(op, ref, match);
+            op += match;
+        } else if (offset >= match) {
+            memcpy(op, ref, match);
+            op += match;
+        } else {
+            //重叠复制(比如 offset 为 1 表示重复上一个字节),只能逐字节来
+            for (size_t i = 0; i < match; i++) *op++ = ref[i];
+        }
+    }
+    return op == oend;
+}
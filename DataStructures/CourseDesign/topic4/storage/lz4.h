@@ -0,0 +1,16 @@
+/*LZ4 块格式的压缩/解压,给大字符串值用。输出与官方 LZ4 的 block 格式兼容,
+只实现最快的贪心模式:4 字节哈希找候选位置,找到就向两边扩展,不做更深的搜索。
+块由若干个序列组成,每个序列:
+    <token> [字面量长度续写] <字面量> <偏移 2 字节小端> [匹配长度续写]
+token 高 4 位是字面量长度,低 4 位是匹配长度减 4;等于 15 时后面逐字节续写,直到某个字节小于 255。
+最后一个序列只有字面量;最后 5 个字节必须是字面量,最后一次匹配不能晚于结尾前 12 字节开始*/
+#pragma once
+#include <cstddef>
+
+//最坏情况(完全不可压缩)下压缩结果的长度上限
+inline size_t lz4Bound(size_t n) { return n + n / 255 + 16; }
+
+//压缩 src 到 dst,返回压缩后的长度;dst 放不下时返回 0
+size_t lz4Compress(const char* src, size_t n, char* dst, size_t cap);
+//解压整个块,结果必须正好 rawLen 字节;数据损坏或长度不符时返回 false,不会越界读写
+bool lz4Decompress(const char* src, size_t n, char* dst, size_t rawLen);
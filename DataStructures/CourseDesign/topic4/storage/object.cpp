@@ -0,0 +1,171 @@
+#include "object.h"
+#include "listpack.h"
+#include "dict.h"
+#include "hyperloglog.h"
+#include "bloom.h"
+#include "lz4.h"
+#include "stream.h"
+#include "zset.h"
+#include <deque>
+#include <iostream>
+#include <cstdlib>
+#include <ctime>
+
+Object* createStringObject(const char* s, size_t len) {
+    return new Object(OBJ_STRING, OBJ_ENCODING_RAW, 1, sdsNewLen(s, len));
+}
+
+Object* createStringObjectFromSds(SDS* s) {
+    return new Object(OBJ_STRING, OBJ_ENCODING_RAW, 1, s);
+}
+
+Object* createCompressedStringObject(const char* s, size_t len) {
+    if (len > UINT32_MAX) return nullptr;
+    //压缩缓冲区每个线程一块,反复使用
+    thread_local std::string scratch;
+    scratch.resize(4 + lz4Bound(len));
+    size_t clen = lz4Compress(s, len, &scratch[4], scratch.size() - 4);
+    if (clen == 0 || clen + 4 > len - len / 8) return nullptr;
+    for (int i = 0; i < 4; i++) scratch[i] = (char)(len >> (8 * i));
+    return new Object(OBJ_STRING, OBJ_ENCODING_LZ4, 1, sdsNewLen(scratch.data(), clen + 4));
+}
+
+std::string stringObjectValue(const Object* o) {
+    auto* v = static_cast<SDS*>(o->ptr);
+    if (o->encoding == OBJ_ENCODING_RAW) return std::string(v->buf, v->len);
+    //压缩值只由 createCompressedStringObject 写入,头部不全或解不开说明内存已经被破坏,
+    //和 Redis 的 serverPanic 一样直接退出,不把错误的内容返回给客户端
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(v->buf);
+    size_t len = v->len < 4 ? 0 : p[0] | (p[1] << 8) | (p[2] << 16) | ((size_t)p[3] << 24);
+    std::string out(len, '\0');
+    if (v->len < 4 || !lz4Decompress(v->buf + 4, v->len - 4, &out[0], len)) {
+        std::cerr << "corrupt LZ4 string value: " << v->len << " bytes stored, " << len << " expected raw" << std::endl;
+        abort();
+    }
+    return out;
+}
+
+Object* createHashObject() {
+    return new Object(OBJ_HASH, OBJ_ENCODING_LISTPACK, 1, lpNew());
+}
+
+Object* createListObject() {
+    return new Object(OBJ_LIST, OBJ_ENCODING_LISTPACK, 1, lpNew());
+}
+
+Object* createHllObject() {
+    return new Object(OBJ_HLL, OBJ_ENCODING_HLL_SPARSE, 1, new HyperLogLog());
+}
+
+Object* createBloomObject(BloomFilter* bf) {
+    return new Object(OBJ_BLOOM, OBJ_ENCODING_BLOOM, 1, bf);
+}
+
+Object* createStreamObject() {
+    return new Object(OBJ_STREAM, OBJ_ENCODING_STREAM, 1, new Stream());
+}
+
+Object* createZsetObject() {
+    return new Object(OBJ_ZSET, OBJ_ENCODING_SKIPLIST, 1, new ZSet());
+}
+
+void incrRefCount(Object* o) {
+    o->refcount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void decrRefCount(Object* o) {
+    if (o->refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) freeObject(o);
+}
+
+void freeObject(Object* o) {
+    if (!o) return;
+    switch (o->encoding) {
+        case OBJ_ENCODING_RAW:
+        case OBJ_ENCODING_LZ4: sdsFree(static_cast<SDS*>(o->ptr)); break;
+        case OBJ_ENCODING_LISTPACK: lpFree(static_cast<unsigned char*>(o->ptr)); break;
+        case OBJ_ENCODING_HT: delete static_cast<Dict*>(o->ptr); break;
+        case OBJ_ENCODING_HLL_SPARSE:
+        case OBJ_ENCODING_HLL_DENSE: delete static_cast<HyperLogLog*>(o->ptr); break;
+        case OBJ_ENCODING_BLOOM: delete static_cast<BloomFilter*>(o->ptr); break;
+        case OBJ_ENCODING_STREAM: delete static_cast<Stream*>(o->ptr); break;
+        case OBJ_ENCODING_SKIPLIST: delete static_cast<ZSet*>(o->ptr); break;
+        case OBJ_ENCODING_DEQUE: {
+            auto* d = static_cast<std::deque<SDS*>*>(o->ptr);
+            for (SDS* s : *d) sdsFree(s);
+            delete d;
+            break;
+        }
+    }
+    delete o;
+}
+
+void freeObjectVoid(void* o) {
+    decrRefCount(static_cast<Object*>(o));
+}
+
+void freeSdsVoid(void* s) {
+    sdsFree(static_cast<SDS*>(s));
+}
+
+const char* encodingName(uint8_t encoding) {
+    switch (encoding) {
+        case OBJ_ENCODING_RAW: return "raw";
+        case OBJ_ENCODING_LISTPACK: return "listpack";
+        case OBJ_ENCODING_HT: return "hashtable";
+        case OBJ_ENCODING_HLL_SPARSE: return "sparse";
+        case OBJ_ENCODING_HLL_DENSE: return "dense";
+        case OBJ_ENCODING_BLOOM: return "bloom";
+        case OBJ_ENCODING_DEQUE: return "deque";
+        case OBJ_ENCODING_LZ4: return "lz4";
+        case OBJ_ENCODING_STREAM: return "stream";
+        case OBJ_ENCODING_SKIPLIST: return "skiplist";
+    }
+    return "unknown";
+}
+
+const char* typeName(uint8_t type) {
+    switch (type) {
+        case OBJ_STRING: return "string";
+        case OBJ_HASH: return "hash";
+        case OBJ_HLL: return "string";     //和 Redis 一样,HLL 对外就是字符串
+        case OBJ_BLOOM: return "bloom";
+        case OBJ_LIST: return "list";
+        case OBJ_STREAM: return "stream";
+        case OBJ_ZSET: return "zset";
+    }
+    return "unknown";
+}
+
+uint16_t lfuClock = time(nullptr) / 60;
+
+void lfuUpdateClock() {
+    lfuClock = time(nullptr) / 60;
+}
+
+//距离上次访问过了几个衰减周期(时钟 16 位回绕也能算对)
+static uint8_t lfuDecayed(const Object* o) {
+    uint16_t elapsed = lfuClock - o->lfuTime;
+    unsigned periods = elapsed / LFU_DECAY_MINUTES;
+    return periods >= o->lfuCounter ? 0 : o->lfuCounter - periods;
+}
+
+uint8_t lfuFrequency(const Object* o) {
+    return lfuDecayed(o);
+}
+
+//计数越大加一的概率越小:p = 1 / ((counter - LFU_INIT_VAL) * LFU_LOG_FACTOR + 1)
+uint8_t lfuTouch(Object* o) {
+    static thread_local uint64_t rng = 0x9e3779b97f4a7c15ull;
+    uint8_t counter = lfuDecayed(o);
+    if (counter < 255) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        double r = (rng >> 11) * (1.0 / 9007199254740992.0);
+        double base = counter > LFU_INIT_VAL ? counter - LFU_INIT_VAL : 0;
+        if (r < 1.0 / (base * LFU_LOG_FACTOR + 1)) counter++;
+    }
+    o->lfuCounter = counter;
+    o->lfuTime = lfuClock;
+    return counter;
+}
@@ -0,0 +1,82 @@
+/*存储引擎里的值对象:同一种类型可以有不同的内部编码,
+比如小哈希用 listpack 省内存,变大后转成 Dict;HyperLogLog 先稀疏后稠密*/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string>
+#include "sds.h"
+
+class BloomFilter;
+class Stream;
+class ZSet;
+
+static const uint8_t LFU_INIT_VAL = 5;      //新 key 的初始计数,免得刚写入就被当成最冷的
+static const int LFU_LOG_FACTOR = 10;
+static const int LFU_DECAY_MINUTES = 1;
+extern uint16_t lfuClock;                   //以分钟为单位的粗略时钟,取低 16 位
+
+enum ObjType : uint8_t {
+    OBJ_STRING = 0,
+    OBJ_HASH = 1,
+    OBJ_HLL = 2,
+    OBJ_BLOOM = 3,
+    OBJ_LIST = 4,
+    OBJ_STREAM = 5,
+    OBJ_ZSET = 6,
+};
+
+enum ObjEncoding : uint8_t {
+    OBJ_ENCODING_RAW = 0,        // ptr 是 SDS*
+    OBJ_ENCODING_LISTPACK = 1,   // ptr 是 listpack(unsigned char*)
+    OBJ_ENCODING_HT = 2,         // ptr 是 Dict*
+    OBJ_ENCODING_HLL_SPARSE = 3, // ptr 是 HyperLogLog*,随对象内部转换更新
+    OBJ_ENCODING_HLL_DENSE = 4,
+    OBJ_ENCODING_BLOOM = 5,      // ptr 是 BloomFilter*
+    OBJ_ENCODING_DEQUE = 6,      // ptr 是 std::deque<SDS*>*,大列表用
+    OBJ_ENCODING_LZ4 = 7,        // ptr 是 SDS*:<原始长度 uint32 小端> <LZ4 块>,大字符串压缩后存放
+    OBJ_ENCODING_STREAM = 8,     // ptr 是 Stream*
+    OBJ_ENCODING_SKIPLIST = 9,   // ptr 是 ZSet*(跳表 + Dict)
+};
+
+//refcount:存储本身持有一份;网络层发送大值时直接引用对象再加一份,
+//这样 key 在发送途中被覆盖或删除也不会释放正在发送的数据。
+//refcount 是原子的:FLUSHDB ASYNC 在后台线程释放整张表时,网络层可能同时持有其中的对象。
+//lfuCounter/lfuTime:访问频率(与 Redis 的 LFU 相同),加上它们对象从 16 字节变成 24 字节,
+//但 malloc 的最小块本来就是 32 字节,实际不多占内存
+struct Object {
+    uint8_t type;
+    uint8_t encoding;
+    uint8_t lfuCounter = LFU_INIT_VAL;
+    uint16_t lfuTime = lfuClock;
+    std::atomic<uint32_t> refcount;
+    void* ptr;
+
+    Object(uint8_t t, uint8_t e, uint32_t rc, void* p) : type(t), encoding(e), refcount(rc), ptr(p) {}
+};
+
+//访问频率 = 8 位对数计数器:越大越难再加一,255 大约对应百万次访问;
+//每空闲 LFU_DECAY_MINUTES 分钟减一,冷下来的 key 频率会降回去
+uint8_t lfuTouch(Object* o);        //记一次访问,返回衰减并累加后的计数
+uint8_t lfuFrequency(const Object* o);   //只读,计算衰减后的计数
+void lfuUpdateClock();              //刷新 lfuClock,服务器在 cron 里调用
+
+Object* createStringObject(const char* s, size_t len);
+Object* createStringObjectFromSds(SDS* s);   //接管 s,不拷贝
+//压缩后能省下至少 1/8 才用 LZ4 编码,否则返回 nullptr,调用方照常存原始值
+Object* createCompressedStringObject(const char* s, size_t len);
+std::string stringObjectValue(const Object* o);   //字符串对象的内容,压缩的先解压
+Object* createHashObject();     //新哈希总是先用 listpack
+Object* createListObject();     //新列表总是先用 listpack
+Object* createHllObject();
+Object* createBloomObject(BloomFilter* bf);   //接管 bf
+Object* createStreamObject();
+Object* createZsetObject();
+void incrRefCount(Object* o);
+void decrRefCount(Object* o);   //减到 0 时释放
+void freeObject(Object* o);
+void freeObjectVoid(void* o);   //给 Dict 当值析构函数用,等价于 decrRefCount
+void freeSdsVoid(void* s);
+const char* encodingName(uint8_t encoding);
+//TYPE 命令和 SCAN TYPE 用的名字;HLL 和 Redis 一样报 "string",Bloom 过滤器报 "bloom"
+const char* typeName(uint8_t type);
@@ -0,0 +1,259 @@
+#include "rax.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+struct RaxNode {
+    void* value;            // isKey 时有效
+    uint32_t labelLen;      //从父节点到这里的边上的字节数,根节点为 0
+    uint16_t nchildren;
+    uint8_t isKey;
+    uint8_t unused;
+};
+
+static size_t ptrOffset(uint32_t labelLen, uint32_t n) {
+    return (sizeof(RaxNode) + labelLen + n + 7) & ~(size_t)7;
+}
+
+static size_t nodeBytes(uint32_t labelLen, uint32_t n) {
+    return ptrOffset(labelLen, n) + n * sizeof(RaxNode*);
+}
+
+static unsigned char* label(RaxNode* n) {
+    return reinterpret_cast<unsigned char*>(n) + sizeof(RaxNode);
+}
+
+//孩子 label 的首字节,升序,和孩子指针一一对应
+static unsigned char* edges(RaxNode* n) {
+    return label(n) + n->labelLen;
+}
+
+static RaxNode** children(RaxNode* n) {
+    return reinterpret_cast<RaxNode**>(reinterpret_cast<unsigned char*>(n) + ptrOffset(n->labelLen, n->nchildren));
+}
+
+static int findChild(RaxNode* n, unsigned char c) {
+    const void* p = memchr(edges(n), c, n->nchildren);
+    return p ? (int)(static_cast<const unsigned char*>(p) - edges(n)) : -1;
+}
+
+Rax::Rax() {
+    head = alloc(0, 0);
+}
+
+Rax::~Rax() {
+    freeTree(head);
+}
+
+void Rax::freeTree(RaxNode* n) {
+    for (int i = 0; i < n->nchildren; i++) freeTree(children(n)[i]);
+    release(n);
+}
+
+RaxNode* Rax::alloc(uint32_t labelLen, uint32_t nchildren) {
+    size_t size = nodeBytes(labelLen, nchildren);
+    auto* n = static_cast<RaxNode*>(malloc(size));
+    n->value = nullptr;
+    n->labelLen = labelLen;
+    n->nchildren = nchildren;
+    n->isKey = 0;
+    n->unused = 0;
+    allocBytes += size;
+    numNodes++;
+    return n;
+}
+
+void Rax::release(RaxNode* n) {
+    allocBytes -= nodeBytes(n->labelLen, n->nchildren);
+    numNodes--;
+    free(n);
+}
+
+RaxNode* Rax::newLeaf(const char* lbl, size_t len, void* value) {
+    RaxNode* n = alloc(len, 0);
+    memcpy(label(n), lbl, len);
+    n->isKey = 1;
+    n->value = value;
+    return n;
+}
+
+//复制出一个多了 child 的新节点,释放旧节点
+RaxNode* Rax::withChild(RaxNode* n, RaxNode* child) {
+    unsigned char c = label(child)[0];
+    int at = 0;
+    while (at < n->nchildren && edges(n)[at] < c) at++;
+    RaxNode* m = alloc(n->labelLen, n->nchildren + 1);
+    m->isKey = n->isKey;
+    m->value = n->value;
+    memcpy(label(m), label(n), n->labelLen);
+    memcpy(edges(m), edges(n), at);
+    edges(m)[at] = c;
+    memcpy(edges(m) + at + 1, edges(n) + at, n->nchildren - at);
+    memcpy(children(m), children(n), at * sizeof(RaxNode*));
+    children(m)[at] = child;
+    memcpy(children(m) + at + 1, children(n) + at, (n->nchildren - at) * sizeof(RaxNode*));
+    release(n);
+    return m;
+}
+
+RaxNode* Rax::withoutChild(RaxNode* n, int idx) {
+    RaxNode* m = alloc(n->labelLen, n->nchildren - 1);
+    m->isKey = n->isKey;
+    m->value = n->value;
+    memcpy(label(m), label(n), n->labelLen);
+    memcpy(edges(m), edges(n), idx);
+    memcpy(edges(m) + idx, edges(n) + idx + 1, n->nchildren - idx - 1);
+    memcpy(children(m), children(n), idx * sizeof(RaxNode*));
+    memcpy(children(m) + idx, children(n) + idx + 1, (n->nchildren - idx - 1) * sizeof(RaxNode*));
+    release(n);
+    return m;
+}
+
+// lbl 可以指向 n 自己的 label,复制完才释放 n
+RaxNode* Rax::withLabel(RaxNode* n, const unsigned char* lbl, uint32_t len) {
+    RaxNode* m = alloc(len, n->nchildren);
+    m->isKey = n->isKey;
+    m->value = n->value;
+    memcpy(label(m), lbl, len);
+    memcpy(edges(m), edges(n), n->nchildren);
+    memcpy(children(m), children(n), n->nchildren * sizeof(RaxNode*));
+    release(n);
+    return m;
+}
+
+//不是 key 且只剩一个孩子的节点和孩子合成一个:label 接起来,其余都用孩子的
+RaxNode* Rax::merge(RaxNode* n, RaxNode* child) {
+    RaxNode* m = alloc(n->labelLen + child->labelLen, child->nchildren);
+    m->isKey = child->isKey;
+    m->value = child->value;
+    memcpy(label(m), label(n), n->labelLen);
+    memcpy(label(m) + n->labelLen, label(child), child->labelLen);
+    memcpy(edges(m), edges(child), child->nchildren);
+    memcpy(children(m), children(child), child->nchildren * sizeof(RaxNode*));
+    release(n);
+    release(child);
+    return m;
+}
+
+bool Rax::find(const char* key, size_t len, void** value) const {
+    RaxNode* n = head;
+    size_t pos = 0;
+    while (pos < len) {
+        int i = findChild(n, key[pos]);
+        if (i < 0) return false;
+        n = children(n)[i];
+        if (n->labelLen > len - pos || memcmp(label(n), key + pos, n->labelLen) != 0) return false;
+        pos += n->labelLen;
+    }
+    if (!n->isKey) return false;
+    if (value) *value = n->value;
+    return true;
+}
+
+bool Rax::insert(const char* key, size_t len, void* value, void** old) {
+    RaxNode** ref = &head;      //指向当前节点的那个指针,节点重新分配后要改它
+    size_t pos = 0;
+    while (true) {
+        RaxNode* n = *ref;
+        if (pos == len) {
+            bool isNew = !n->isKey;
+            if (!isNew && old) *old = n->value;
+            n->isKey = 1;
+            n->value = value;
+            if (isNew) count++;
+            return isNew;
+        }
+        int i = findChild(n, key[pos]);
+        if (i < 0) {
+            *ref = withChild(n, newLeaf(key + pos, len - pos, value));
+            count++;
+            return true;
+        }
+        RaxNode** cref = &children(n)[i];
+        RaxNode* c = *cref;
+        uint32_t j = 0, lim = c->labelLen < len - pos ? c->labelLen : len - pos;
+        while (j < lim && label(c)[j] == (unsigned char)key[pos + j]) j++;
+        if (j == c->labelLen) {
+            ref = cref;
+            pos += j;
+            continue;
+        }
+        //边只匹配了前 j 个字节:在第 j 个字节处拆开,中间插一个节点
+        RaxNode* mid = alloc(j, 0);
+        memcpy(label(mid), label(c), j);
+        RaxNode* rest = withLabel(c, label(c) + j, c->labelLen - j);
+        mid = withChild(mid, rest);
+        pos += j;
+        if (pos == len) {
+            mid->isKey = 1;
+            mid->value = value;
+        } else {
+            mid = withChild(mid, newLeaf(key + pos, len - pos, value));
+        }
+        *cref = mid;
+        count++;
+        return true;
+    }
+}
+
+bool Rax::remove(const char* key, size_t len, void** old) {
+    std::vector<RaxNode**> parents;     //从根到当前节点路上每个节点的引用
+    RaxNode** ref = &head;
+    size_t pos = 0;
+    while (pos < len) {
+        RaxNode* n = *ref;
+        int i = findChild(n, key[pos]);
+        if (i < 0) return false;
+        RaxNode* c = children(n)[i];
+        if (c->labelLen > len - pos || memcmp(label(c), key + pos, c->labelLen) != 0) return false;
+        parents.push_back(ref);
+        ref = &children(n)[i];
+        pos += c->labelLen;
+    }
+    RaxNode* n = *ref;
+    if (!n->isKey) return false;
+    if (old) *old = n->value;
+    n->isKey = 0;
+    n->value = nullptr;
+    count--;
+    if (n == head) return true;
+
+    //没有孩子的节点直接摘掉;父节点因此可能只剩一个孩子,接着检查它能不能合并
+    if (n->nchildren == 0) {
+        RaxNode** pref = parents.back();
+        RaxNode* p = *pref;
+        int i = findChild(p, label(n)[0]);
+        release(n);
+        *pref = withoutChild(p, i);
+        ref = pref;
+        n = *ref;
+        if (n == head) return true;
+    }
+    if (!n->isKey && n->nchildren == 1) *ref = merge(n, children(n)[0]);
+    return true;
+}
+
+bool Rax::walkNode(RaxNode* n, std::string& path, const std::string* lo, const std::string* hi, bool reverse,
+                   const WalkFn& fn) const {
+    path.append(reinterpret_cast<const char*>(label(n)), n->labelLen);
+    bool cont = true;
+    //子树里的 key 都以 path 开头:path 已经大于 hi,或者在不是 lo 前缀的情况下小于 lo,整棵子树都不用看
+    bool skip = (hi && path.compare(*hi) > 0) ||
+                (lo && path.compare(*lo) < 0 && lo->compare(0, path.size(), path) != 0);
+    if (!skip) {
+        bool self = n->isKey && (!lo || path.compare(*lo) >= 0);
+        if (!reverse && self) cont = fn(path, n->value);
+        for (int k = 0; cont && k < n->nchildren; k++) {
+            int i = reverse ? n->nchildren - 1 - k : k;
+            cont = walkNode(children(n)[i], path, lo, hi, reverse, fn);
+        }
+        if (cont && reverse && self) cont = fn(path, n->value);
+    }
+    path.resize(path.size() - n->labelLen);
+    return cont;
+}
+
+void Rax::walk(const std::string* lo, const std::string* hi, bool reverse, const WalkFn& fn) const {
+    std::string path;
+    walkNode(head, path, lo, hi, reverse, fn);
+}
@@ -0,0 +1,52 @@
+/*rax:压缩前缀树(radix tree),按字节串的字典序存放 key -> value。
+不是 key 且只有一个孩子的节点会和孩子合并,一条边上可以有多个字节(压缩路径),
+所以节点数不超过 key 数的两倍,共享的前缀只存一次。
+每个节点是一块连续内存:
+    <头部 16 字节> <边上的字节 label> <各孩子 label 的首字节,升序> <补齐到 8 字节> <孩子指针>
+插入、删除会改变节点大小,这时整块重新分配,再改写父节点里指向它的指针。
+只管节点内存,value 由调用方管理*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <functional>
+
+struct RaxNode;
+
+class Rax {
+public:
+    Rax();
+    ~Rax();
+    Rax(const Rax&) = delete;
+    Rax& operator=(const Rax&) = delete;
+
+    //插入或覆盖,新 key 返回 true;old 非空且 key 已存在时写入被覆盖的旧值
+    bool insert(const char* key, size_t len, void* value, void** old = nullptr);
+    bool remove(const char* key, size_t len, void** old = nullptr);
+    bool find(const char* key, size_t len, void** value = nullptr) const;
+    size_t size() const { return count; }
+    size_t nodes() const { return numNodes; }
+    size_t bytes() const { return allocBytes; }     //所有节点占用的内存(不含 malloc 自己的开销)
+
+    //按字典序遍历 [lo, hi] 内的 key(nullptr 表示这一端不限),reverse 时从大到小;fn 返回 false 时停止。
+    //不在范围内的子树整个跳过,从中间开始遍历只需要沿一条路径下去
+    using WalkFn = std::function<bool(const std::string& key, void* value)>;
+    void walk(const std::string* lo, const std::string* hi, bool reverse, const WalkFn& fn) const;
+
+private:
+    RaxNode* alloc(uint32_t labelLen, uint32_t nchildren);
+    void release(RaxNode* n);
+    RaxNode* newLeaf(const char* label, size_t len, void* value);
+    RaxNode* withChild(RaxNode* n, RaxNode* child);
+    RaxNode* withoutChild(RaxNode* n, int idx);
+    RaxNode* withLabel(RaxNode* n, const unsigned char* label, uint32_t len);
+    RaxNode* merge(RaxNode* n, RaxNode* child);
+    void freeTree(RaxNode* n);
+    bool walkNode(RaxNode* n, std::string& path, const std::string* lo, const std::string* hi, bool reverse,
+                  const WalkFn& fn) const;
+
+    RaxNode* head;      //根节点:label 为空,可以没有孩子,永远不合并
+    size_t count = 0;
+    size_t numNodes = 0;
+    size_t allocBytes = 0;
+};
@@ -3,12 +3,15 @@
 #include <cstdlib>
 
 SDS* sdsCreate(const char* init) {
-    size_t len = strlen(init);
+    return sdsNewLen(init, strlen(init));
+}
+
+SDS* sdsNewLen(const char* init, size_t len) {
     SDS* s = new SDS;
     s->len = len;
     s->cap = len + 1;
     s->buf = new char[s->cap];
-    memcpy(s->buf, init, len);
+    if (init) memcpy(s->buf, init, len);
     s->buf[len] = '\0';
     return s;
 }
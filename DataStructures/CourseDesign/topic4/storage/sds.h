@@ -8,4 +8,5 @@ struct SDS {
 };
 
 SDS* sdsCreate(const char* init);
+SDS* sdsNewLen(const char* init, size_t len);  //二进制安全,可以包含 '\0'
 void sdsFree(SDS* s);
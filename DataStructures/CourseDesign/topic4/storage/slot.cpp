@@ -0,0 +1,34 @@
+#include "slot.h"
+
+//多项式 0x1021,初值 0,第一次调用时生成查表
+static uint16_t crcTable[256];
+static bool crcTableReady = false;
+
+static void buildTable() {
+    for (int i = 0; i < 256; i++) {
+        uint16_t c = i << 8;
+        for (int b = 0; b < 8; b++) c = (c & 0x8000) ? (c << 1) ^ 0x1021 : c << 1;
+        crcTable[i] = c;
+    }
+    crcTableReady = true;
+}
+
+uint16_t crc16(const char* buf, size_t len) {
+    if (!crcTableReady) buildTable();
+    uint16_t crc = 0;
+    for (size_t i = 0; i < len; i++)
+        crc = (crc << 8) ^ crcTable[((crc >> 8) ^ (uint8_t)buf[i]) & 0xFF];
+    return crc;
+}
+
+int keyHashSlot(const char* key, size_t len) {
+    size_t s = 0;
+    while (s < len && key[s] != '{') s++;
+    if (s < len) {
+        size_t e = s + 1;
+        while (e < len && key[e] != '}') e++;
+        // "{}" 或没有右括号时仍然对整个 key 求哈希
+        if (e < len && e > s + 1) return crc16(key + s + 1, e - s - 1) & (CLUSTER_SLOTS - 1);
+    }
+    return crc16(key, len) & (CLUSTER_SLOTS - 1);
+}
@@ -0,0 +1,10 @@
+/*集群哈希槽:key 的 CRC16(XMODEM)对 16384 取模。
+key 里有 {tag} 时只对第一对花括号里的内容求哈希,这样相关的 key 可以放进同一个槽*/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+static const int CLUSTER_SLOTS = 16384;
+
+uint16_t crc16(const char* buf, size_t len);
+int keyHashSlot(const char* key, size_t len);
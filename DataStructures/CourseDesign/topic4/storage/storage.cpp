@@ -1,18 +1,739 @@
 #include "storage.h"
+#include "listpack.h"
+#include "slot.h"
+#include "hyperloglog.h"
+#include "bloom.h"
+#include "lazyfree.h"
+#include "rax.h"
+#include "stream.h"
+#include "trace.h"
+#include <algorithm>
+#include <deque>
+#include <cstring>
+
+StorageEngine::StorageEngine(StorageMode mode, int dbnum) {
+    //并发模式只有一个库,数据放在 cdict 里
+    if (mode == StorageMode::Concurrent) {
+        cdict.reset(new ConcurrentDict(1024, freeObjectVoid));
+        dbnum = 1;
+    }
+    dbs.resize(dbnum < 1 ? 1 : dbnum);
+    for (auto& d : dbs) d.dict.reset(new Dict(1024, freeObjectVoid));
+    db = &dbs[0];
+}
+
+Object* StorageEngine::lookup(const std::string& key) {
+    if (cdict) return static_cast<Object*>(cdict->get(key.data(), key.size()));
+    return static_cast<Object*>(db->dict->get(key.data(), key.size()));
+}
+
+Object* StorageEngine::lookupRead(const std::string& key) {
+    TRACE_SCOPE("lookupRead");
+    Object* o = lookup(key);
+    if (!cdict) {
+        if (o) {
+            hits++;
+            lfuTouch(o);
+        } else {
+            misses++;
+        }
+    }
+    return o;
+}
+
+Object* StorageEngine::lookupWrite(const std::string& key) {
+    TRACE_SCOPE("lookupWrite");
+    Object* o = lookup(key);
+    if (o && !cdict) lfuTouch(o);
+    if (o && keyModified) keyModified(key);
+    return o;
+}
+
+void StorageEngine::dbAdd(const std::string& key, Object* o) {
+    TRACE_SCOPE("dbAdd");
+    SDS* k = sdsNewLen(key.data(), key.size());
+    if (keyModified) keyModified(key);
+    if (cdict) {
+        cdict->set(k, o);
+        return;
+    }
+    //二级索引只关心新增的 key,覆盖不用动
+    if ((!db->slotKeys.empty() || db->keyIndex) && !db->dict->get(key.data(), key.size())) {
+        if (!db->slotKeys.empty()) {
+            auto& index = db->slotKeys[keyHashSlot(key.data(), key.size())];
+            if (!index) index.reset(new Dict());
+            index->set(sdsNewLen(key.data(), key.size()), nullptr);
+        }
+        if (db->keyIndex) db->keyIndex->insert(key.data(), key.size(), nullptr);
+    }
+    db->dict->set(k, o);
+}
+
+bool StorageEngine::dbDelete(const std::string& key) {
+    TRACE_SCOPE("dbDelete");
+    if (cdict) {
+        if (!cdict->del(key.data(), key.size())) return false;
+        if (keyModified) keyModified(key);
+        return true;
+    }
+    if (!db->dict->del(key.data(), key.size())) return false;
+    if (keyModified) keyModified(key);
+    if (!db->slotKeys.empty()) {
+        auto& index = db->slotKeys[keyHashSlot(key.data(), key.size())];
+        index->del(key.data(), key.size());
+        if (index->size() == 0) index.reset();
+    }
+    if (db->keyIndex) db->keyIndex->remove(key.data(), key.size());
+    return true;
+}
+
+std::unique_lock<std::mutex> StorageEngine::lockComplex() {
+    if (cdict) return std::unique_lock<std::mutex>(complexLock);
+    return std::unique_lock<std::mutex>();
+}
 
 bool StorageEngine::set(const std::string& key, const std::string& value) {
-    SDS* k = sdsCreate(key.c_str());
-    SDS* v = sdsCreate(value.c_str());
-    dict.set(k, v);
+    Object* o = nullptr;
+    if (compressMinSize && value.size() >= compressMinSize) o = createCompressedStringObject(value.data(), value.size());
+    dbAdd(key, o ? o : createStringObject(value.data(), value.size()));
     return true;
 }
 
+void StorageEngine::setOwned(const std::string& key, SDS* value) {
+    Object* o = nullptr;
+    if (compressMinSize && value->len >= compressMinSize) o = createCompressedStringObject(value->buf, value->len);
+    if (o) sdsFree(value);
+    dbAdd(key, o ? o : createStringObjectFromSds(value));
+}
+
+Object* StorageEngine::getStringObject(const std::string& key) {
+    Object* o = lookupRead(key);
+    return o && o->type == OBJ_STRING ? o : nullptr;
+}
+
 std::optional<std::string> StorageEngine::get(const std::string& key) {
-    auto* v = static_cast<SDS*>(dict.get(key.c_str()));
-    if (!v) return std::nullopt;
-    return std::string(v->buf);
+    std::optional<std::string> result;
+    auto copy = [&](void* p) {
+        auto* o = static_cast<Object*>(p);
+        if (o->type != OBJ_STRING) return;
+        result.emplace(stringObjectValue(o));
+    };
+    if (cdict) {
+        cdict->read(key.data(), key.size(), copy);
+    } else if (Object* o = lookupRead(key)) {
+        copy(o);
+    }
+    return result;
 }
 
 bool StorageEngine::del(const std::string& key) {
-    return dict.del(key.c_str());
+    return dbDelete(key);
+}
+
+bool StorageEngine::exists(const std::string& key) {
+    EpochGuard guard(concurrent());
+    return lookup(key) != nullptr;
+}
+
+bool StorageEngine::checkType(const std::string& key, ObjType type) {
+    EpochGuard guard(concurrent());
+    Object* o = lookup(key);
+    return !o || o->type == type;
+}
+
+const char* StorageEngine::objectEncoding(const std::string& key) {
+    EpochGuard guard(concurrent());
+    Object* o = lookup(key);
+    return o ? encodingName(o->encoding) : nullptr;
+}
+
+const char* StorageEngine::objectType(const std::string& key) {
+    EpochGuard guard(concurrent());
+    Object* o = lookup(key);
+    return o ? typeName(o->type) : nullptr;
+}
+
+size_t StorageEngine::dbsize() {
+    return cdict ? cdict->size() : db->dict->size();
+}
+
+size_t StorageEngine::dbsize(int id) {
+    if (id < 0 || id >= dbCount()) return 0;
+    return cdict ? cdict->size() : dbs[id].dict->size();
+}
+
+bool StorageEngine::select(int id) {
+    if (id < 0 || id >= dbCount()) return false;
+    db = &dbs[id];
+    return true;
+}
+
+//交换两个库的全部内容(包括槽索引),对已经 SELECT 了它们的客户端立即可见
+bool StorageEngine::swapdb(int a, int b) {
+    if (cdict || a < 0 || b < 0 || a >= dbCount() || b >= dbCount()) return false;
+    std::swap(dbs[a].dict, dbs[b].dict);
+    std::swap(dbs[a].slotKeys, dbs[b].slotKeys);
+    std::swap(dbs[a].keyIndex, dbs[b].keyIndex);
+    return true;
+}
+
+//换上一张空表,旧表同步释放或者交给后台线程;槽索引、key 索引保持开启
+void StorageEngine::emptyDb(Db& d, bool async) {
+    Dict* old = d.dict.release();
+    d.dict.reset(new Dict(1024, freeObjectVoid));
+    if (async) lazyfree.freeDict(old);
+    else delete old;
+    for (auto& index : d.slotKeys) {
+        if (!index) continue;
+        if (async) lazyfree.freeDict(index.release());
+        else index.reset();
+    }
+    if (d.keyIndex) {
+        Rax* oldIndex = d.keyIndex.release();
+        d.keyIndex.reset(new Rax());
+        if (async) lazyfree.freeRax(oldIndex);
+        else delete oldIndex;
+    }
+}
+
+void StorageEngine::flushdb(bool async) {
+    if (!cdict) emptyDb(*db, async);
+}
+
+void StorageEngine::flushall(bool async) {
+    if (cdict) return;
+    for (auto& d : dbs) emptyDb(d, async);
+}
+
+size_t StorageEngine::lazyfreePending() const {
+    return lazyfree.pending();
+}
+
+int StorageEngine::objectFreq(const std::string& key) {
+    EpochGuard guard(concurrent());
+    Object* o = lookup(key);
+    return o ? lfuFrequency(o) : -1;
+}
+
+size_t StorageEngine::scan(size_t cursor, size_t count, std::vector<std::string>& keys, int type) {
+    if (cdict) return 0;
+    //和 Redis 一样:凑够 count 个 key 才返回,但最多看 count*10 个桶,
+    //表很稀疏(Dict 扩容后不缩)时不会为了一页结果把整张表扫一遍
+    size_t start = keys.size();
+    size_t budget = std::max<size_t>(count, 1) * 10;
+    do {
+        cursor = db->dict->scan(cursor, [&](SDS* k, void* v) {
+            if (type < 0 || !strcmp(typeName(static_cast<Object*>(v)->type), typeName(type)))
+                keys.emplace_back(k->buf, k->len);
+        });
+    } while (cursor != 0 && --budget > 0 && keys.size() - start < count);
+    return cursor;
+}
+
+void StorageEngine::setHashListpackLimits(size_t entries, size_t value) {
+    hashMaxListpackEntries = entries;
+    hashMaxListpackValue = value;
+}
+
+//listpack 编码转成 Dict 编码,一旦转换不再转回
+void StorageEngine::hashConvertToDict(Object* o) {
+    auto* lp = static_cast<unsigned char*>(o->ptr);
+    Dict* d = new Dict(lpLength(lp) / 2, freeSdsVoid);
+    for (unsigned char* p = lpFirst(lp); p; ) {
+        std::string field = lpGetString(p);
+        p = lpNext(lp, p);
+        std::string value = lpGetString(p);
+        p = lpNext(lp, p);
+        d->set(sdsNewLen(field.data(), field.size()), sdsNewLen(value.data(), value.size()));
+    }
+    lpFree(lp);
+    o->ptr = d;
+    o->encoding = OBJ_ENCODING_HT;
+}
+
+int StorageEngine::hset(const std::string& key, const std::string& field, const std::string& value) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupWrite(key);
+    if (!o) {
+        o = createHashObject();
+        dbAdd(key, o);
+    }
+    if (o->encoding == OBJ_ENCODING_LISTPACK &&
+        (field.size() > hashMaxListpackValue || value.size() > hashMaxListpackValue))
+        hashConvertToDict(o);
+
+    if (o->encoding == OBJ_ENCODING_LISTPACK) {
+        auto* lp = static_cast<unsigned char*>(o->ptr);
+        unsigned char* f = lpFind(lp, lpFirst(lp), field.data(), field.size(), 1);
+        if (f) {
+            unsigned char* v = lpNext(lp, f);
+            o->ptr = lpReplace(lp, v - lp, value.data(), value.size());
+            return 0;
+        }
+        lp = lpAppend(lp, field.data(), field.size());
+        lp = lpAppend(lp, value.data(), value.size());
+        o->ptr = lp;
+        if (lpLength(lp) / 2 > hashMaxListpackEntries) hashConvertToDict(o);
+        return 1;
+    }
+
+    Dict* d = static_cast<Dict*>(o->ptr);
+    bool existed = d->get(field.data(), field.size()) != nullptr;
+    d->set(sdsNewLen(field.data(), field.size()), sdsNewLen(value.data(), value.size()));
+    return existed ? 0 : 1;
+}
+
+std::optional<std::string> StorageEngine::hget(const std::string& key, const std::string& field) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupRead(key);
+    if (!o || o->type != OBJ_HASH) return std::nullopt;
+    if (o->encoding == OBJ_ENCODING_LISTPACK) {
+        auto* lp = static_cast<unsigned char*>(o->ptr);
+        unsigned char* f = lpFind(lp, lpFirst(lp), field.data(), field.size(), 1);
+        if (!f) return std::nullopt;
+        return lpGetString(lpNext(lp, f));
+    }
+    auto* v = static_cast<SDS*>(static_cast<Dict*>(o->ptr)->get(field.data(), field.size()));
+    if (!v) return std::nullopt;
+    return std::string(v->buf, v->len);
+}
+
+bool StorageEngine::hdel(const std::string& key, const std::string& field) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupWrite(key);
+    if (!o || o->type != OBJ_HASH) return false;
+    bool deleted;
+    if (o->encoding == OBJ_ENCODING_LISTPACK) {
+        auto* lp = static_cast<unsigned char*>(o->ptr);
+        unsigned char* f = lpFind(lp, lpFirst(lp), field.data(), field.size(), 1);
+        deleted = f != nullptr;
+        if (f) o->ptr = lpDelete(lp, f - lp, 2);
+    } else {
+        deleted = static_cast<Dict*>(o->ptr)->del(field.data(), field.size());
+    }
+    //哈希删空了就把 key 一起删掉
+    if (deleted && hashLength(o) == 0) dbDelete(key);
+    return deleted;
+}
+
+size_t StorageEngine::hashLength(Object* o) {
+    if (o->encoding == OBJ_ENCODING_LISTPACK) return lpLength(static_cast<unsigned char*>(o->ptr)) / 2;
+    return static_cast<Dict*>(o->ptr)->size();
+}
+
+size_t StorageEngine::hlen(const std::string& key) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupRead(key);
+    return o && o->type == OBJ_HASH ? hashLength(o) : 0;
+}
+
+std::vector<std::pair<std::string, std::string>> StorageEngine::hgetall(const std::string& key) {
+    std::vector<std::pair<std::string, std::string>> result;
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupRead(key);
+    if (!o || o->type != OBJ_HASH) return result;
+    if (o->encoding == OBJ_ENCODING_LISTPACK) {
+        auto* lp = static_cast<unsigned char*>(o->ptr);
+        for (unsigned char* p = lpFirst(lp); p; ) {
+            std::string field = lpGetString(p);
+            p = lpNext(lp, p);
+            result.emplace_back(std::move(field), lpGetString(p));
+            p = lpNext(lp, p);
+        }
+    } else {
+        static_cast<Dict*>(o->ptr)->forEach([&](SDS* k, void* v) {
+            auto* s = static_cast<SDS*>(v);
+            result.emplace_back(std::string(k->buf, k->len), std::string(s->buf, s->len));
+        });
+    }
+    return result;
+}
+
+void StorageEngine::listConvertToDeque(Object* o) {
+    auto* lp = static_cast<unsigned char*>(o->ptr);
+    auto* d = new std::deque<SDS*>();
+    for (unsigned char* p = lpFirst(lp); p; p = lpNext(lp, p)) {
+        std::string v = lpGetString(p);
+        d->push_back(sdsNewLen(v.data(), v.size()));
+    }
+    lpFree(lp);
+    o->ptr = d;
+    o->encoding = OBJ_ENCODING_DEQUE;
+}
+
+size_t StorageEngine::listLength(Object* o) {
+    if (o->encoding == OBJ_ENCODING_LISTPACK) return lpLength(static_cast<unsigned char*>(o->ptr));
+    return static_cast<std::deque<SDS*>*>(o->ptr)->size();
+}
+
+size_t StorageEngine::push(const std::string& key, const std::vector<std::string>& values, bool left) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupWrite(key);
+    if (!o) {
+        o = createListObject();
+        dbAdd(key, o);
+    }
+    if (o->type != OBJ_LIST) return 0;
+    for (auto& v : values) {
+        if (o->encoding == OBJ_ENCODING_LISTPACK &&
+            (v.size() > listMaxListpackValue || lpLength(static_cast<unsigned char*>(o->ptr)) >= listMaxListpackEntries))
+            listConvertToDeque(o);
+        if (o->encoding == OBJ_ENCODING_LISTPACK) {
+            auto* lp = static_cast<unsigned char*>(o->ptr);
+            unsigned char* first = lpFirst(lp);
+            o->ptr = left && first ? lpInsert(lp, first - lp, v.data(), v.size()) : lpAppend(lp, v.data(), v.size());
+        } else {
+            auto* d = static_cast<std::deque<SDS*>*>(o->ptr);
+            SDS* s = sdsNewLen(v.data(), v.size());
+            if (left) d->push_front(s);
+            else d->push_back(s);
+        }
+    }
+    return listLength(o);
+}
+
+std::optional<std::string> StorageEngine::pop(const std::string& key, bool left) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupWrite(key);
+    if (!o || o->type != OBJ_LIST) return std::nullopt;
+    std::string v;
+    if (o->encoding == OBJ_ENCODING_LISTPACK) {
+        auto* lp = static_cast<unsigned char*>(o->ptr);
+        unsigned char* p = left ? lpFirst(lp) : lpLast(lp);
+        if (!p) return std::nullopt;
+        v = lpGetString(p);
+        o->ptr = lpDelete(lp, p - lp, 1);
+    } else {
+        auto* d = static_cast<std::deque<SDS*>*>(o->ptr);
+        SDS* s = left ? d->front() : d->back();
+        if (left) d->pop_front();
+        else d->pop_back();
+        v.assign(s->buf, s->len);
+        sdsFree(s);
+    }
+    if (listLength(o) == 0) dbDelete(key);
+    return v;
+}
+
+size_t StorageEngine::llen(const std::string& key) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupRead(key);
+    return o && o->type == OBJ_LIST ? listLength(o) : 0;
+}
+
+//下标规则与 Redis 相同:负数从末尾数起,越界的部分截掉
+std::vector<std::string> StorageEngine::lrange(const std::string& key, long long start, long long stop) {
+    std::vector<std::string> result;
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupRead(key);
+    if (!o || o->type != OBJ_LIST) return result;
+    long long len = listLength(o);
+    if (start < 0) start += len;
+    if (stop < 0) stop += len;
+    if (start < 0) start = 0;
+    if (stop >= len) stop = len - 1;
+    if (start > stop) return result;
+    if (o->encoding == OBJ_ENCODING_LISTPACK) {
+        auto* lp = static_cast<unsigned char*>(o->ptr);
+        unsigned char* p = lpFirst(lp);
+        for (long long i = 0; i < start; i++) p = lpNext(lp, p);
+        for (long long i = start; i <= stop; i++, p = lpNext(lp, p)) result.push_back(lpGetString(p));
+    } else {
+        auto* d = static_cast<std::deque<SDS*>*>(o->ptr);
+        for (long long i = start; i <= stop; i++) result.emplace_back((*d)[i]->buf, (*d)[i]->len);
+    }
+    return result;
+}
+
+int StorageEngine::pfadd(const std::string& key, const std::vector<std::string>& elements) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupWrite(key);
+    int changed = 0;
+    if (!o) {
+        o = createHllObject();
+        dbAdd(key, o);
+        changed = 1;
+    }
+    if (o->type != OBJ_HLL) return 0;
+    auto* h = static_cast<HyperLogLog*>(o->ptr);
+    for (auto& e : elements)
+        if (h->add(e.data(), e.size())) changed = 1;
+    if (h->isDense()) o->encoding = OBJ_ENCODING_HLL_DENSE;
+    return changed;
+}
+
+uint64_t StorageEngine::pfcount(const std::vector<std::string>& keys) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    if (keys.size() == 1) {
+        Object* o = lookupRead(keys[0]);
+        return o && o->type == OBJ_HLL ? static_cast<HyperLogLog*>(o->ptr)->count() : 0;
+    }
+    HyperLogLog merged;
+    for (auto& k : keys) {
+        Object* o = lookupRead(k);
+        if (o && o->type == OBJ_HLL) merged.merge(*static_cast<HyperLogLog*>(o->ptr));
+    }
+    return merged.count();
+}
+
+void StorageEngine::pfmerge(const std::string& dest, const std::vector<std::string>& sources) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* d = lookupWrite(dest);
+    if (!d) {
+        d = createHllObject();
+        dbAdd(dest, d);
+    }
+    if (d->type != OBJ_HLL) return;
+    auto* h = static_cast<HyperLogLog*>(d->ptr);
+    for (auto& k : sources) {
+        Object* o = lookupRead(k);
+        if (o && o != d && o->type == OBJ_HLL) h->merge(*static_cast<HyperLogLog*>(o->ptr));
+    }
+    if (h->isDense()) d->encoding = OBJ_ENCODING_HLL_DENSE;
+}
+
+bool StorageEngine::bfReserve(const std::string& key, double errorRate, uint64_t capacity) {
+    BloomFilter* bf = BloomFilter::create(errorRate, capacity);
+    if (!bf) return false;
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    dbAdd(key, createBloomObject(bf));
+    return true;
+}
+
+int StorageEngine::bfAdd(const std::string& key, const std::string& item) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupWrite(key);
+    if (!o) {
+        o = createBloomObject(BloomFilter::create(BLOOM_DEFAULT_ERROR_RATE, BLOOM_DEFAULT_CAPACITY));
+        dbAdd(key, o);
+    }
+    if (o->type != OBJ_BLOOM) return 0;
+    return static_cast<BloomFilter*>(o->ptr)->add(item.data(), item.size()) ? 1 : 0;
+}
+
+bool StorageEngine::bfExists(const std::string& key, const std::string& item) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupRead(key);
+    return o && o->type == OBJ_BLOOM && static_cast<BloomFilter*>(o->ptr)->contains(item.data(), item.size());
+}
+
+void StorageEngine::enableKeyIndex() {
+    if (cdict) return;
+    for (auto& d : dbs) {
+        if (d.keyIndex) continue;
+        d.keyIndex.reset(new Rax());
+        d.dict->forEach([&](SDS* k, void*) { d.keyIndex->insert(k->buf, k->len, nullptr); });
+    }
+}
+
+size_t StorageEngine::keyIndexBytes() const {
+    size_t total = 0;
+    for (auto& d : dbs)
+        if (d.keyIndex) total += d.keyIndex->bytes();
+    return total;
+}
+
+//没开索引时退化成全表扫描再排序,结果相同
+std::vector<std::string> StorageEngine::sortedKeys(const std::string* lo, const std::string* hi) {
+    std::vector<std::string> keys;
+    db->dict->forEach([&](SDS* k, void*) {
+        std::string key(k->buf, k->len);
+        if ((!lo || key >= *lo) && (!hi || key <= *hi)) keys.push_back(std::move(key));
+    });
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+Stream* StorageEngine::streamRead(const std::string& key) {
+    Object* o = lookupRead(key);
+    return o && o->type == OBJ_STREAM ? static_cast<Stream*>(o->ptr) : nullptr;
+}
+
+Stream* StorageEngine::streamWrite(const std::string& key, bool create) {
+    Object* o = lookupWrite(key);
+    if (!o && create) {
+        o = createStreamObject();
+        dbAdd(key, o);
+    }
+    return o && o->type == OBJ_STREAM ? static_cast<Stream*>(o->ptr) : nullptr;
+}
+
+ZSet* StorageEngine::zsetRead(const std::string& key) {
+    Object* o = lookupRead(key);
+    return o && o->type == OBJ_ZSET ? static_cast<ZSet*>(o->ptr) : nullptr;
+}
+
+ZSet* StorageEngine::zsetWrite(const std::string& key, bool create) {
+    Object* o = lookupWrite(key);
+    if (!o && create) {
+        o = createZsetObject();
+        dbAdd(key, o);
+    }
+    return o && o->type == OBJ_ZSET ? static_cast<ZSet*>(o->ptr) : nullptr;
+}
+
+std::vector<std::string> StorageEngine::keysWithPrefix(const std::string& prefix, const std::string* after, size_t count) {
+    std::vector<std::string> keys;
+    if (cdict || count == 0) return keys;
+    const std::string& lo = after && *after > prefix ? *after : prefix;
+    auto visit = [&](const std::string& k, void*) {
+        if (k.compare(0, prefix.size(), prefix) != 0) return false;     //已经走出前缀范围
+        if (after && k == *after) return true;
+        keys.push_back(k);
+        return keys.size() < count;
+    };
+    if (db->keyIndex) {
+        db->keyIndex->walk(&lo, nullptr, false, visit);
+    } else {
+        for (auto& k : sortedKeys(&lo, nullptr))
+            if (!visit(k, nullptr)) break;
+    }
+    return keys;
+}
+
+std::vector<std::string> StorageEngine::keyRange(const std::string* lo, bool loExclusive, const std::string* hi,
+                                                 bool hiExclusive, size_t offset, size_t count) {
+    std::vector<std::string> keys;
+    if (cdict || count == 0) return keys;
+    auto visit = [&](const std::string& k, void*) {
+        if ((loExclusive && lo && k == *lo) || (hiExclusive && hi && k == *hi)) return true;
+        if (offset > 0) {
+            offset--;
+            return true;
+        }
+        keys.push_back(k);
+        return keys.size() < count;
+    };
+    if (db->keyIndex) {
+        db->keyIndex->walk(lo, hi, false, visit);
+    } else {
+        for (auto& k : sortedKeys(lo, hi))
+            if (!visit(k, nullptr)) break;
+    }
+    return keys;
+}
+
+void StorageEngine::enableSlotIndex() {
+    if (cdict || !db->slotKeys.empty()) return;
+    db->slotKeys.resize(CLUSTER_SLOTS);
+    db->dict->forEach([&](SDS* k, void*) {
+        auto& index = db->slotKeys[keyHashSlot(k->buf, k->len)];
+        if (!index) index.reset(new Dict());
+        index->set(sdsNewLen(k->buf, k->len), nullptr);
+    });
+}
+
+size_t StorageEngine::countKeysInSlot(int slot) {
+    if (db->slotKeys.empty() || !db->slotKeys[slot]) return 0;
+    return db->slotKeys[slot]->size();
+}
+
+std::vector<std::string> StorageEngine::getKeysInSlot(int slot, size_t count) {
+    std::vector<std::string> keys;
+    if (db->slotKeys.empty() || !db->slotKeys[slot]) return keys;
+    db->slotKeys[slot]->forEach([&](SDS* k, void*) {
+        if (keys.size() < count) keys.emplace_back(k->buf, k->len);
+    });
+    return keys;
+}
+
+std::string StorageEngine::dumpObject(const std::string& key) {
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    Object* o = lookupRead(key);
+    if (o && o->type == OBJ_HLL) return "H" + static_cast<HyperLogLog*>(o->ptr)->dump();
+    if (o && o->type == OBJ_BLOOM) return "B" + static_cast<BloomFilter*>(o->ptr)->dump();
+    return std::string();
+}
+
+bool StorageEngine::restoreObject(const std::string& key, const std::string& payload) {
+    if (payload.empty()) return false;
+    std::string data = payload.substr(1);
+    Object* o = nullptr;
+    if (payload[0] == 'H') {
+        o = createHllObject();
+        auto* h = static_cast<HyperLogLog*>(o->ptr);
+        if (!h->restore(data)) {
+            decrRefCount(o);
+            return false;
+        }
+        if (h->isDense()) o->encoding = OBJ_ENCODING_HLL_DENSE;
+    } else if (payload[0] == 'B') {
+        BloomFilter* bf = BloomFilter::restore(data);
+        if (!bf) return false;
+        o = createBloomObject(bf);
+    } else {
+        return false;
+    }
+    EpochGuard guard(concurrent());
+    auto lock = lockComplex();
+    dbAdd(key, o);
+    return true;
+}
+
+std::vector<std::vector<std::string>> StorageEngine::rebuildCommands(const std::string& key) {
+    std::vector<std::vector<std::string>> cmds;
+    std::string payload = dumpObject(key);
+    if (!payload.empty()) {
+        cmds.push_back({"RESTORE", key, "0", std::move(payload), "REPLACE"});
+        return cmds;
+    }
+    if (auto v = get(key)) {
+        cmds.push_back({"DEL", key});
+        cmds.push_back({"SET", key, *v});
+        return cmds;
+    }
+    //流只搬消息本身,消费组不迁移
+    if (Stream* s = streamRead(key)) {
+        cmds.push_back({"DEL", key});
+        for (auto& e : s->range(StreamID(), StreamID::max(), false, 0)) {
+            std::vector<std::string> xadd = {"XADD", key, e.id.toString()};
+            xadd.insert(xadd.end(), e.fields.begin(), e.fields.end());
+            cmds.push_back(std::move(xadd));
+        }
+        return cmds;
+    }
+    if (ZSet* z = zsetRead(key)) {
+        cmds.push_back({"DEL", key});
+        std::vector<std::string> zadd = {"ZADD", key};
+        for (auto& [member, score] : z->rangeByRank(0, z->size() - 1, false)) {
+            zadd.push_back(formatScore(score));
+            zadd.push_back(std::move(member));
+        }
+        cmds.push_back(std::move(zadd));
+        return cmds;
+    }
+    auto items = lrange(key, 0, -1);
+    if (!items.empty()) {
+        std::vector<std::string> rpush = {"RPUSH", key};
+        rpush.insert(rpush.end(), items.begin(), items.end());
+        cmds.push_back({"DEL", key});
+        cmds.push_back(std::move(rpush));
+        return cmds;
+    }
+    auto fields = hgetall(key);
+    if (fields.empty()) return cmds;
+    std::vector<std::string> hset = {"HSET", key};
+    for (auto& kv : fields) {
+        hset.push_back(std::move(kv.first));
+        hset.push_back(std::move(kv.second));
+    }
+    cmds.push_back({"DEL", key});
+    cmds.push_back(std::move(hset));
+    return cmds;
 }
@@ -1,14 +1,162 @@
 #pragma once
 #include <string>
 #include <optional>
+#include <vector>
+#include <utility>
+#include <memory>
+#include <mutex>
+#include <functional>
 #include "dict.h"
+#include "concurrent_dict.h"
+#include "object.h"
+#include "lazyfree.h"
+#include "rax.h"
+#include "stream.h"
+#include "zset.h"
+
+//Single:单线程使用(服务器事件循环)。Concurrent:进程内多线程直接调用,
+//字符串的 get 不加锁,set/del 分段加锁;其余命令之间用一把锁串行
+enum class StorageMode { Single, Concurrent };
+
+static const int DEFAULT_DBNUM = 16;    //逻辑库的个数,与 Redis 默认的 databases 相同
 
 class StorageEngine {
 public:
+    //单线程模式有 dbnum 个相互独立的逻辑库,所有命令都作用在 select 选中的库上;并发模式只有一个库
+    explicit StorageEngine(StorageMode mode = StorageMode::Single, int dbnum = DEFAULT_DBNUM);
+
+    //多库(只支持单线程模式)。编号越界返回 false
+    int dbCount() const { return (int)dbs.size(); }
+    bool select(int id);
+    bool swapdb(int a, int b);
+    // async 为 true 时旧表交给后台线程释放,命令立即返回
+    void flushdb(bool async);
+    void flushall(bool async);
+    size_t lazyfreePending() const;     //后台还没释放完的 key 数
+
     bool set(const std::string& key, const std::string& value);
-    std::optional<std::string> get(const std::string& key);
+    void setOwned(const std::string& key, SDS* value);   //接管 value,大值不再拷贝一次
+    std::optional<std::string> get(const std::string& key);      //压缩存放的值在这里解压
     bool del(const std::string& key);
+    bool exists(const std::string& key);
+    //字符串对象本身(不拷贝),不存在或不是字符串返回 nullptr;只能在单线程模式下用,
+    //要在下一次修改之后继续使用就得先 incrRefCount。编码可能是 LZ4,这时要用 stringObjectValue 取值
+    Object* getStringObject(const std::string& key);
+
+    //key 不存在或者类型就是 type 时返回 true;否则调用方应该回复 WRONGTYPE
+    bool checkType(const std::string& key, ObjType type);
+    const char* objectEncoding(const std::string& key);  // key 不存在返回 nullptr
+    const char* objectType(const std::string& key);      // key 不存在返回 nullptr
+
+    //键空间统计(只在单线程模式下统计,并发模式的无锁读不碰共享计数)
+    size_t dbsize();
+    size_t dbsize(int id);
+    uint64_t keyspaceHits() const { return hits; }
+    uint64_t keyspaceMisses() const { return misses; }
+    int objectFreq(const std::string& key);    // LFU 计数,key 不存在返回 -1
+    //从 cursor 开始遍历,至少看 count 个桶,把 key 放进 keys,返回下一个游标(0 表示结束)。
+    // type 非负时只返回 TYPE 名字和它相同的 key(所以 string 也包括 HLL);只支持单线程模式
+    size_t scan(size_t cursor, size_t count, std::vector<std::string>& keys, int type = -1);
+
+    //哈希:小哈希用 listpack 连续存放,超过阈值自动转成 Dict
+    int hset(const std::string& key, const std::string& field, const std::string& value);  //新字段返回 1,覆盖返回 0
+    std::optional<std::string> hget(const std::string& key, const std::string& field);
+    bool hdel(const std::string& key, const std::string& field);
+    size_t hlen(const std::string& key);
+    std::vector<std::pair<std::string, std::string>> hgetall(const std::string& key);
+    //listpack 阈值:字段数不超过 entries 且每个字段名/值都不超过 value 字节
+    void setHashListpackLimits(size_t entries, size_t value);
+
+    //列表:小列表用 listpack,元素个数或单个元素超过阈值后转成 deque;弹空了自动删除 key
+    size_t push(const std::string& key, const std::vector<std::string>& values, bool left);  //返回新长度
+    std::optional<std::string> pop(const std::string& key, bool left);
+    size_t llen(const std::string& key);
+    std::vector<std::string> lrange(const std::string& key, long long start, long long stop);
+
+    // HyperLogLog:不存在的 key 当作空集合;类型由调用方先用 checkType 检查
+    int pfadd(const std::string& key, const std::vector<std::string>& elements);  //有寄存器变化或新建 key 返回 1
+    uint64_t pfcount(const std::vector<std::string>& keys);    //多个 key 时估计并集的基数
+    void pfmerge(const std::string& dest, const std::vector<std::string>& sources);
+
+    // Bloom 过滤器
+    //参数不合法或位数组超过 BLOOM_MAX_BYTES 时返回 false;key 已存在由调用方检查
+    bool bfReserve(const std::string& key, double errorRate, uint64_t capacity);
+    int bfAdd(const std::string& key, const std::string& item);   // key 不存在时按默认参数创建
+    bool bfExists(const std::string& key, const std::string& item);
+
+    // Stream:命令的解析和消费组的逻辑都在 Stream 里,这里只负责找到(或创建)对象。
+    //只能在单线程模式下用;不存在或者类型不对返回 nullptr,streamWrite 在 create 时新建空流
+    Stream* streamRead(const std::string& key);
+    Stream* streamWrite(const std::string& key, bool create);
+    //有序集合(GEO 也存在这里),用法同 Stream;删光成员后由调用方 del
+    ZSet* zsetRead(const std::string& key);
+    ZSet* zsetWrite(const std::string& key, bool create);
+
+    //不小于 minSize 字节的字符串值尝试用 LZ4 压缩存放(压缩率太低的照常存原始值),0 表示关闭
+    void setStringCompression(size_t minSize) { compressMinSize = minSize; }
+
+    //每次 key 被写入、修改或删除后调用(服务器用它发客户端缓存的失效通知);
+    //并发模式下会在多个线程里被调用
+    void setKeyModifiedHook(std::function<void(const std::string&)> hook) { keyModified = std::move(hook); }
+
+    //按字典序的 key 索引(rax),所有库一起开启,之后随写入/删除同步维护;只支持单线程模式。
+    //下面两个查询在没开索引时退化成全表扫描加排序,结果相同
+    void enableKeyIndex();
+    bool keyIndexEnabled() const { return db->keyIndex != nullptr; }
+    size_t keyIndexBytes() const;      //所有库的索引节点占用的内存
+    //当前库里以 prefix 开头的 key,按字典序最多 count 个;after 非空时只返回大于它的(接着上一批往下取)
+    std::vector<std::string> keysWithPrefix(const std::string& prefix, const std::string* after, size_t count);
+    //字典序在 lo 和 hi 之间的 key(空指针表示这一端不限,exclusive 时不含端点),跳过前 offset 个
+    std::vector<std::string> keyRange(const std::string* lo, bool loExclusive, const std::string* hi,
+                                      bool hiExclusive, size_t offset, size_t count);
+
+    //集群模式:按哈希槽维护 key 索引,迁移槽时不用扫描整个库(只支持单线程模式)
+    void enableSlotIndex();
+    size_t countKeysInSlot(int slot);
+    std::vector<std::string> getKeysInSlot(int slot, size_t count);
+    //在另一个节点上重建这个 key 所需的命令(先 DEL 再写入),key 不存在返回空
+    std::vector<std::vector<std::string>> rebuildCommands(const std::string& key);
+    // HLL 和 Bloom 没有能重建它们的普通写命令,迁移时整体序列化成 RESTORE 的载荷:类型标记 + dump() 的内容。
+    //不是这两种类型(或 key 不存在)时 dumpObject 返回空串;restoreObject 覆盖已有的 key,载荷不对返回 false
+    std::string dumpObject(const std::string& key);
+    bool restoreObject(const std::string& key, const std::string& payload);
 
 private:
-    Dict dict;
+    //并发模式下 lookup 返回的对象只在调用方的 EpochGuard 内有效
+    Object* lookup(const std::string& key);
+    //读命令用 lookupRead(统计命中/未命中),写命令用 lookupWrite;单线程模式下两者都记一次 LFU 访问。
+    // lookupWrite 找到 key 就当作它要被修改,通知 keyModified;新建和删除由 dbAdd/dbDelete 通知
+    Object* lookupRead(const std::string& key);
+    Object* lookupWrite(const std::string& key);
+    //一个逻辑库:key 表,集群模式下按槽的 key 索引(每个槽一个只存 key 的 Dict,用到时才创建),
+    //以及可选的按字典序的 key 索引
+    struct Db {
+        std::unique_ptr<Dict> dict;
+        std::vector<std::unique_ptr<Dict>> slotKeys;
+        std::unique_ptr<Rax> keyIndex;
+    };
+    std::vector<std::string> sortedKeys(const std::string* lo, const std::string* hi);
+    void emptyDb(Db& d, bool async);
+    void dbAdd(const std::string& key, Object* o);
+    bool dbDelete(const std::string& key);
+    bool concurrent() const { return cdict != nullptr; }
+    std::unique_lock<std::mutex> lockComplex();
+    void hashConvertToDict(Object* o);
+    static size_t hashLength(Object* o);
+    void listConvertToDeque(Object* o);
+    static size_t listLength(Object* o);
+
+    std::vector<Db> dbs;
+    Db* db;                                   //当前选中的库
+    std::unique_ptr<ConcurrentDict> cdict;    //并发模式下代替 db->dict
+    std::mutex complexLock;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    std::function<void(const std::string&)> keyModified;
+    size_t hashMaxListpackEntries = 128;
+    size_t hashMaxListpackValue = 64;
+    size_t listMaxListpackEntries = 128;
+    size_t listMaxListpackValue = 64;
+    size_t compressMinSize = 0;
+    LazyFree lazyfree;      //最后声明,析构时先等后台释放完
 };
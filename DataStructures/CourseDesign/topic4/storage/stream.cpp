@@ -0,0 +1,517 @@
+#include "stream.h"
+#include "listpack.h"
+#include <cstdlib>
+#include <cstring>
+
+static const int STREAM_ITEM_DELETED = 1;
+static const int STREAM_ITEM_SAMEFIELDS = 2;
+
+bool StreamID::incr() {
+    if (seq < UINT64_MAX) {
+        seq++;
+    } else if (ms < UINT64_MAX) {
+        ms++;
+        seq = 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool StreamID::decr() {
+    if (seq > 0) {
+        seq--;
+    } else if (ms > 0) {
+        ms--;
+        seq = UINT64_MAX;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool parseU64(const char* s, size_t len, uint64_t& v) {
+    if (len == 0 || len > 20) return false;
+    v = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        uint64_t d = s[i] - '0';
+        if (v > (UINT64_MAX - d) / 10) return false;
+        v = v * 10 + d;
+    }
+    return true;
+}
+
+bool parseStreamID(const std::string& s, StreamID& id, uint64_t missingSeq, bool* seqGiven) {
+    if (seqGiven) *seqGiven = true;
+    if (s == "-") {
+        id = StreamID();
+        return true;
+    }
+    if (s == "+") {
+        id = StreamID::max();
+        return true;
+    }
+    size_t dash = s.find('-');
+    if (dash == std::string::npos) {
+        if (seqGiven) *seqGiven = false;
+        id.seq = missingSeq;
+        return parseU64(s.data(), s.size(), id.ms);
+    }
+    return parseU64(s.data(), dash, id.ms) && parseU64(s.data() + dash + 1, s.size() - dash - 1, id.seq);
+}
+
+//rax 的 key:ms、seq 各 8 字节大端,字典序和 ID 的大小顺序一致
+static std::string encodeId(const StreamID& id) {
+    std::string k(16, '\0');
+    for (int i = 0; i < 8; i++) {
+        k[i] = (char)(id.ms >> (56 - 8 * i));
+        k[8 + i] = (char)(id.seq >> (56 - 8 * i));
+    }
+    return k;
+}
+
+static StreamID decodeId(const std::string& k) {
+    StreamID id;
+    for (int i = 0; i < 8; i++) {
+        id.ms = (id.ms << 8) | (unsigned char)k[i];
+        id.seq = (id.seq << 8) | (unsigned char)k[8 + i];
+    }
+    return id;
+}
+
+//块的主项
+struct BlockHeader {
+    int64_t count;                      //没删除的消息数
+    int64_t deleted;
+    std::vector<std::string> fields;    //主字段
+    unsigned char* first;               //第一条消息的 flags,没有消息时为 nullptr
+};
+
+static void readHeader(unsigned char* lp, BlockHeader& h) {
+    unsigned char* p = lpFirst(lp);
+    h.count = lpGetInteger(p);
+    p = lpNext(lp, p);
+    h.deleted = lpGetInteger(p);
+    p = lpNext(lp, p);
+    int64_t n = lpGetInteger(p);
+    h.fields.clear();
+    for (int64_t i = 0; i < n; i++) {
+        p = lpNext(lp, p);
+        h.fields.push_back(lpGetString(p));
+    }
+    p = lpNext(lp, p);      //主项结尾的 0
+    h.first = lpNext(lp, p);
+}
+
+//解出 p 处(指向 flags)的一条消息,fields 为空时不取内容;返回下一条消息的 flags,没有了返回 nullptr
+static unsigned char* readEntry(unsigned char* lp, unsigned char* p, const BlockHeader& h, const StreamID& master,
+                                StreamID& id, int& flags, std::vector<std::string>* fields) {
+    flags = (int)lpGetInteger(p);
+    p = lpNext(lp, p);
+    id.ms = master.ms + (uint64_t)lpGetInteger(p);
+    p = lpNext(lp, p);
+    id.seq = master.seq + (uint64_t)lpGetInteger(p);
+    p = lpNext(lp, p);
+    size_t n = h.fields.size();
+    if (!(flags & STREAM_ITEM_SAMEFIELDS)) {
+        n = lpGetInteger(p);
+        p = lpNext(lp, p);
+    }
+    if (fields) fields->clear();
+    for (size_t i = 0; i < n; i++) {
+        if (flags & STREAM_ITEM_SAMEFIELDS) {
+            if (fields) fields->push_back(h.fields[i]);
+        } else {
+            if (fields) fields->push_back(lpGetString(p));
+            p = lpNext(lp, p);
+        }
+        if (fields) fields->push_back(lpGetString(p));
+        p = lpNext(lp, p);
+    }
+    return lpNext(lp, p);   //跳过 lp-count
+}
+
+//最后一条消息的 flags;块里没有消息时返回 nullptr
+static unsigned char* lastEntry(unsigned char* lp, const BlockHeader& h) {
+    if (!h.first) return nullptr;
+    unsigned char* p = lpLast(lp);
+    int64_t n = lpGetInteger(p);
+    for (int64_t i = 0; i < n; i++) p = lpPrev(lp, p);
+    return p;
+}
+
+//p 前面那条消息的 flags,p 已经是第一条时返回 nullptr
+static unsigned char* prevEntry(unsigned char* lp, unsigned char* p, const BlockHeader& h) {
+    if (p == h.first) return nullptr;
+    p = lpPrev(lp, p);
+    int64_t n = lpGetInteger(p);
+    for (int64_t i = 0; i < n; i++) p = lpPrev(lp, p);
+    return p;
+}
+
+static bool elementEquals(const unsigned char* p, const std::string& s) {
+    uint32_t len;
+    int64_t v;
+    const unsigned char* e = lpGet(p, &len, &v);
+    if (e) return len == s.size() && memcmp(e, s.data(), len) == 0;
+    return std::to_string(v) == s;
+}
+
+Stream::~Stream() {
+    rax.walk(nullptr, nullptr, false, [](const std::string&, void* lp) {
+        lpFree(static_cast<unsigned char*>(lp));
+        return true;
+    });
+    groups.walk(nullptr, nullptr, false, [this](const std::string&, void* g) {
+        freeGroup(static_cast<StreamGroup*>(g));
+        return true;
+    });
+}
+
+void Stream::freeGroup(StreamGroup* g) {
+    g->pel.walk(nullptr, nullptr, false, [](const std::string&, void* nack) {
+        delete static_cast<StreamNack*>(nack);
+        return true;
+    });
+    g->consumers.walk(nullptr, nullptr, false, [](const std::string&, void* c) {
+        delete static_cast<StreamConsumer*>(c);
+        return true;
+    });
+    delete g;
+}
+
+size_t Stream::bytes() const {
+    size_t total = rax.bytes();
+    rax.walk(nullptr, nullptr, false, [&](const std::string&, void* lp) {
+        total += lpBytes(static_cast<unsigned char*>(lp));
+        return true;
+    });
+    return total;
+}
+
+//块被 realloc 之后把新地址写回 rax
+void Stream::setBlock(const std::string& key, unsigned char* lp) {
+    rax.insert(key.data(), key.size(), lp);
+    if (key == tailKey) tail = lp;
+}
+
+bool Stream::nextId(uint64_t nowMs, StreamID& id) const {
+    if (nowMs > last.ms) {
+        id = {nowMs, 0};
+        return true;
+    }
+    id = last;
+    return id.incr();
+}
+
+void Stream::append(const StreamID& id, const std::vector<std::string>& fields) {
+    size_t nfields = fields.size() / 2;
+    //最后一块满了就开新块,新块的主字段取这条消息的字段
+    if (tail) {
+        unsigned char* p = lpFirst(tail);
+        int64_t live = lpGetInteger(p);
+        int64_t deleted = lpGetInteger(lpNext(tail, p));
+        if (lpBytes(tail) >= STREAM_NODE_MAX_BYTES || (size_t)(live + deleted) >= STREAM_NODE_MAX_ENTRIES) tail = nullptr;
+    }
+    if (!tail) {
+        unsigned char* lp = lpNew();
+        lp = lpAppendInteger(lp, 0);
+        lp = lpAppendInteger(lp, 0);
+        lp = lpAppendInteger(lp, nfields);
+        for (size_t i = 0; i < nfields; i++) lp = lpAppend(lp, fields[2 * i].data(), fields[2 * i].size());
+        lp = lpAppendInteger(lp, 0);
+        tailKey = encodeId(id);
+        tail = lp;
+        rax.insert(tailKey.data(), tailKey.size(), lp);
+    }
+
+    unsigned char* lp = tail;
+    StreamID master = decodeId(tailKey);
+    //和主字段逐个比较,字段相同只存值
+    unsigned char* p = lpNext(lp, lpNext(lp, lpFirst(lp)));
+    bool same = (size_t)lpGetInteger(p) == nfields;
+    for (size_t i = 0; same && i < nfields; i++) {
+        p = lpNext(lp, p);
+        same = elementEquals(p, fields[2 * i]);
+    }
+    //整条消息先拼好再一次追加
+    thread_local std::vector<std::string> items;
+    items.clear();
+    items.push_back(std::to_string(same ? STREAM_ITEM_SAMEFIELDS : 0));
+    items.push_back(std::to_string((int64_t)(id.ms - master.ms)));
+    items.push_back(std::to_string((int64_t)(id.seq - master.seq)));
+    if (same) {
+        for (size_t i = 0; i < nfields; i++) items.push_back(fields[2 * i + 1]);
+    } else {
+        items.push_back(std::to_string(nfields));
+        items.insert(items.end(), fields.begin(), fields.end());
+    }
+    items.push_back(std::to_string(items.size()));
+    lp = lpAppendBatch(lp, items.data(), items.size());
+    p = lpFirst(lp);
+    lp = lpReplaceInteger(lp, p - lp, lpGetInteger(p) + 1);
+    if (lp != tail) setBlock(tailKey, lp);
+    count++;
+    last = id;
+}
+
+//包含 id 的块(主 ID 不大于 id 的最后一块)的 key,id 比所有块都小时返回 false
+static bool blockFor(const Rax& rax, const StreamID& id, std::string& key) {
+    std::string hi = encodeId(id);
+    bool found = false;
+    rax.walk(nullptr, &hi, true, [&](const std::string& k, void*) {
+        key = k;
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+std::vector<StreamEntry> Stream::range(const StreamID& start, const StreamID& end, bool reverse, size_t limit) const {
+    std::vector<StreamEntry> out;
+    if (start > end) return out;
+    std::string lo, hi = encodeId(end);
+    bool hasLo = blockFor(rax, start, lo);
+    BlockHeader h;
+    int flags;
+    rax.walk(hasLo ? &lo : nullptr, &hi, reverse, [&](const std::string& key, void* v) {
+        auto* lp = static_cast<unsigned char*>(v);
+        StreamID master = decodeId(key);
+        readHeader(lp, h);
+        unsigned char* p = reverse ? lastEntry(lp, h) : h.first;
+        while (p) {
+            StreamID id;
+            unsigned char* next = readEntry(lp, p, h, master, id, flags, nullptr);
+            if (reverse) next = prevEntry(lp, p, h);
+            if (reverse ? id < start : id > end) return false;
+            if (!(flags & STREAM_ITEM_DELETED) && id >= start && id <= end) {
+                out.emplace_back();
+                readEntry(lp, p, h, master, out.back().id, flags, &out.back().fields);
+                if (limit && out.size() >= limit) return false;
+            }
+            p = next;
+        }
+        return true;
+    });
+    return out;
+}
+
+StreamID Stream::firstId() const {
+    auto first = range(StreamID(), StreamID::max(), false, 1);
+    return first.empty() ? StreamID() : first[0].id;
+}
+
+bool Stream::lookup(const StreamID& id, StreamEntry* out) const {
+    auto found = range(id, id, false, 1);
+    if (found.empty()) return false;
+    if (out) *out = std::move(found[0]);
+    return true;
+}
+
+//把块里偏移为 offsets 的消息标成删除。flags 和计数都是 7 位小整数,改写时长度不变,偏移一直有效
+static unsigned char* markDeleted(unsigned char* lp, const std::vector<size_t>& offsets) {
+    for (size_t off : offsets) lp = lpReplaceInteger(lp, off, lpGetInteger(lp + off) | STREAM_ITEM_DELETED);
+    unsigned char* p = lpFirst(lp);
+    lp = lpReplaceInteger(lp, p - lp, lpGetInteger(p) - offsets.size());
+    p = lpNext(lp, lpFirst(lp));
+    return lpReplaceInteger(lp, p - lp, lpGetInteger(p) + offsets.size());
+}
+
+bool Stream::remove(const StreamID& id) {
+    std::string key;
+    if (!blockFor(rax, id, key)) return false;
+    void* v;
+    rax.find(key.data(), key.size(), &v);
+    auto* lp = static_cast<unsigned char*>(v);
+    BlockHeader h;
+    readHeader(lp, h);
+    StreamID master = decodeId(key), cur;
+    int flags;
+    for (unsigned char* p = h.first; p; ) {
+        unsigned char* next = readEntry(lp, p, h, master, cur, flags, nullptr);
+        if (cur > id) break;
+        if (cur == id && !(flags & STREAM_ITEM_DELETED)) {
+            count--;
+            //整块删光就释放;最后一块也一样,下次追加会开新块
+            if (h.count == 1) {
+                rax.remove(key.data(), key.size());
+                lpFree(lp);
+                if (key == tailKey) {
+                    tail = nullptr;
+                    tailKey.clear();
+                }
+                return true;
+            }
+            unsigned char* nlp = markDeleted(lp, {(size_t)(p - lp)});
+            if (nlp != lp) setBlock(key, nlp);
+            return true;
+        }
+        p = next;
+    }
+    return false;
+}
+
+size_t Stream::trimMaxLen(size_t maxLen, bool approx) {
+    return trim(true, maxLen, StreamID(), approx);
+}
+
+size_t Stream::trimMinId(const StreamID& minId, bool approx) {
+    return trim(false, 0, minId, approx);
+}
+
+//从头一块一块地删:整块都该删的直接释放;遇到只需删一部分的块时,approx 就到此为止,否则标记删除
+size_t Stream::trim(bool byLen, size_t maxLen, const StreamID& minId, bool approx) {
+    size_t removed = 0;
+    while (count > 0) {
+        if (byLen && count <= maxLen) break;
+        std::string key;
+        unsigned char* lp = nullptr;
+        rax.walk(nullptr, nullptr, false, [&](const std::string& k, void* v) {
+            key = k;
+            lp = static_cast<unsigned char*>(v);
+            return false;
+        });
+        BlockHeader h;
+        readHeader(lp, h);
+        StreamID master = decodeId(key), cur;
+        int flags;
+        std::vector<size_t> offsets;
+        for (unsigned char* p = h.first; p; ) {
+            unsigned char* next = readEntry(lp, p, h, master, cur, flags, nullptr);
+            if (!(flags & STREAM_ITEM_DELETED)) {
+                if (byLen ? count - offsets.size() <= maxLen : cur >= minId) break;
+                offsets.push_back(p - lp);
+            }
+            p = next;
+        }
+        if ((int64_t)offsets.size() == h.count) {
+            rax.remove(key.data(), key.size());
+            lpFree(lp);
+            if (key == tailKey) {
+                tail = nullptr;
+                tailKey.clear();
+            }
+            count -= offsets.size();
+            removed += offsets.size();
+            continue;
+        }
+        if (!approx && !offsets.empty()) {
+            unsigned char* nlp = markDeleted(lp, offsets);
+            if (nlp != lp) setBlock(key, nlp);
+            count -= offsets.size();
+            removed += offsets.size();
+        }
+        break;
+    }
+    return removed;
+}
+
+StreamGroup* Stream::createGroup(const std::string& name, const StreamID& lastId) {
+    if (groups.find(name.data(), name.size())) return nullptr;
+    auto* g = new StreamGroup();
+    g->lastId = lastId;
+    groups.insert(name.data(), name.size(), g);
+    return g;
+}
+
+StreamGroup* Stream::group(const std::string& name) const {
+    void* g;
+    return groups.find(name.data(), name.size(), &g) ? static_cast<StreamGroup*>(g) : nullptr;
+}
+
+bool Stream::destroyGroup(const std::string& name) {
+    void* g;
+    if (!groups.remove(name.data(), name.size(), &g)) return false;
+    freeGroup(static_cast<StreamGroup*>(g));
+    return true;
+}
+
+StreamConsumer* Stream::consumer(StreamGroup* g, const std::string& name, bool create, bool* created) {
+    void* c;
+    if (created) *created = false;
+    if (g->consumers.find(name.data(), name.size(), &c)) return static_cast<StreamConsumer*>(c);
+    if (!create) return nullptr;
+    auto* nc = new StreamConsumer();
+    nc->name = name;
+    nc->seenTime = 0;
+    g->consumers.insert(name.data(), name.size(), nc);
+    if (created) *created = true;
+    return nc;
+}
+
+size_t Stream::deleteConsumer(StreamGroup* g, const std::string& name) {
+    void* v;
+    if (!g->consumers.remove(name.data(), name.size(), &v)) return 0;
+    auto* c = static_cast<StreamConsumer*>(v);
+    size_t pending = c->pel.size();
+    c->pel.walk(nullptr, nullptr, false, [&](const std::string& k, void* nack) {
+        g->pel.remove(k.data(), k.size());
+        delete static_cast<StreamNack*>(nack);
+        return true;
+    });
+    delete c;
+    return pending;
+}
+
+std::vector<StreamEntry> Stream::readGroup(StreamGroup* g, StreamConsumer* c, size_t limit, bool noack, uint64_t nowMs) {
+    c->seenTime = nowMs;
+    StreamID start = g->lastId;
+    if (!start.incr()) return {};
+    auto entries = range(start, StreamID::max(), false, limit);
+    for (auto& e : entries) {
+        g->lastId = e.id;
+        if (noack) continue;
+        std::string k = encodeId(e.id);
+        void* v;
+        //SETID 把组往回拨过,这条消息可能还在别的消费者的 PEL 里:转给当前消费者
+        if (g->pel.find(k.data(), k.size(), &v)) {
+            auto* nack = static_cast<StreamNack*>(v);
+            nack->consumer->pel.remove(k.data(), k.size());
+            *nack = {nowMs, 1, c};
+            c->pel.insert(k.data(), k.size(), nack);
+            continue;
+        }
+        auto* nack = new StreamNack{nowMs, 1, c};
+        g->pel.insert(k.data(), k.size(), nack);
+        c->pel.insert(k.data(), k.size(), nack);
+    }
+    return entries;
+}
+
+std::vector<StreamEntry> Stream::readPending(StreamConsumer* c, const StreamID& after, size_t limit, uint64_t nowMs) {
+    c->seenTime = nowMs;
+    std::vector<StreamEntry> out;
+    StreamID start = after;
+    if (!start.incr()) return out;
+    std::string lo = encodeId(start);
+    c->pel.walk(&lo, nullptr, false, [&](const std::string& k, void* v) {
+        auto* nack = static_cast<StreamNack*>(v);
+        StreamEntry e;
+        e.id = decodeId(k);
+        e.missing = !lookup(e.id, &e);
+        nack->deliveryTime = nowMs;
+        nack->deliveryCount++;
+        out.push_back(std::move(e));
+        return !limit || out.size() < limit;
+    });
+    return out;
+}
+
+bool Stream::ack(StreamGroup* g, const StreamID& id) {
+    std::string k = encodeId(id);
+    void* v;
+    if (!g->pel.remove(k.data(), k.size(), &v)) return false;
+    auto* nack = static_cast<StreamNack*>(v);
+    nack->consumer->pel.remove(k.data(), k.size());
+    delete nack;
+    return true;
+}
+
+void Stream::forEachPending(StreamGroup* g, StreamConsumer* c, const StreamID& start, const StreamID& end, bool reverse,
+                            const std::function<bool(const StreamID&, const StreamNack*)>& fn) const {
+    std::string lo = encodeId(start), hi = encodeId(end);
+    (c ? c->pel : g->pel).walk(&lo, &hi, reverse, [&](const std::string& k, void* v) {
+        return fn(decodeId(k), static_cast<StreamNack*>(v));
+    });
+}
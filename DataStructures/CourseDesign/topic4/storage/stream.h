@@ -0,0 +1,125 @@
+/*Stream:只追加的消息日志,每条消息有一个 <毫秒时间>-<序号> 的 ID,ID 严格递增。
+消息按块存放:每块是一个 listpack,装最多 STREAM_NODE_MAX_ENTRIES 条 / STREAM_NODE_MAX_BYTES 字节,
+块放在 rax 里,以块中第一条消息的 ID(16 字节大端,字典序 = 数值序)为 key。
+块的布局(参考 Redis t_stream.c):
+    主项:   <count> <deleted> <字段数 n> <字段1> ... <字段n> <0>
+    每条:   <flags> <ms 差> <seq 差> [值1 ... 值n | 字段数 <字段> <值> ...] <lp-count>
+ID 只存相对主 ID 的差;字段和主项完全相同的消息(flags 带 SAMEFIELDS)只存值,
+日志类数据的字段名几乎总是相同的,这样每条消息只多出几个字节。
+lp-count 是这条消息除它自己以外占的元素数,用来从后往前遍历。
+删除只打 DELETED 标记,整块都删光时才释放块。
+追加只碰最后一块;范围读先在 rax 里找到起点所在的块,再顺着块往后读。
+消费组:每组记录最后投递的 ID 和待确认列表(PEL),PEL 按 ID 放在 rax 里,
+组的 PEL 和消费者自己的 PEL 共用同一个 StreamNack*/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <functional>
+#include "rax.h"
+
+static const size_t STREAM_NODE_MAX_BYTES = 4096;
+static const size_t STREAM_NODE_MAX_ENTRIES = 100;
+
+struct StreamID {
+    uint64_t ms = 0;
+    uint64_t seq = 0;
+
+    bool operator==(const StreamID& o) const { return ms == o.ms && seq == o.seq; }
+    bool operator!=(const StreamID& o) const { return !(*this == o); }
+    bool operator<(const StreamID& o) const { return ms < o.ms || (ms == o.ms && seq < o.seq); }
+    bool operator<=(const StreamID& o) const { return !(o < *this); }
+    bool operator>(const StreamID& o) const { return o < *this; }
+    bool operator>=(const StreamID& o) const { return !(*this < o); }
+    std::string toString() const { return std::to_string(ms) + "-" + std::to_string(seq); }
+    bool incr();        //下一个 ID,已经是最大值时返回 false
+    bool decr();
+    static StreamID max() { return {UINT64_MAX, UINT64_MAX}; }
+};
+
+//"ms-seq" 或 "ms"(序号取 missingSeq),"-" 和 "+" 是最小/最大 ID;seqGiven 非空时写入是否给了序号
+bool parseStreamID(const std::string& s, StreamID& id, uint64_t missingSeq, bool* seqGiven = nullptr);
+
+struct StreamEntry {
+    StreamID id;
+    std::vector<std::string> fields;    //字段、值交替
+    bool missing = false;               //只在读消费者的历史 PEL 时出现:消息已经被删除了
+};
+
+struct StreamConsumer;
+
+struct StreamNack {
+    uint64_t deliveryTime;      //最近一次投递的时间(毫秒)
+    uint64_t deliveryCount;
+    StreamConsumer* consumer;
+};
+
+struct StreamConsumer {
+    std::string name;
+    uint64_t seenTime;
+    Rax pel;                    // ID -> StreamNack*,和组的 PEL 共享
+};
+
+struct StreamGroup {
+    StreamID lastId;            //最后投递给组内消费者的 ID
+    Rax pel;                    // ID -> StreamNack*
+    Rax consumers;              //名字 -> StreamConsumer*
+};
+
+class Stream {
+public:
+    Stream() = default;
+    ~Stream();
+    Stream(const Stream&) = delete;
+    Stream& operator=(const Stream&) = delete;
+
+    size_t length() const { return count; }
+    StreamID lastId() const { return last; }
+    StreamID firstId() const;       //空流返回 0-0
+    size_t blocks() const { return rax.size(); }
+    size_t bytes() const;           //块和 rax 节点占用的内存
+
+    //自动生成的 ID:当前时间比最后的 ID 大就用当前时间,否则在最后的 ID 上加一;溢出返回 false
+    bool nextId(uint64_t nowMs, StreamID& id) const;
+    //追加一条消息,id 必须大于 lastId(由调用方保证);fields 是字段、值交替
+    void append(const StreamID& id, const std::vector<std::string>& fields);
+    //[start, end] 内的消息,reverse 时从大到小,count 为 0 表示不限
+    std::vector<StreamEntry> range(const StreamID& start, const StreamID& end, bool reverse, size_t count) const;
+    bool remove(const StreamID& id);
+    //裁剪到最多 maxLen 条 / 删除所有小于 minId 的消息,返回删除的条数。
+    // approx 时只删除整块,可能多留一些,但不用改动块的内容
+    size_t trimMaxLen(size_t maxLen, bool approx);
+    size_t trimMinId(const StreamID& minId, bool approx);
+
+    //消费组。建组时组已存在返回 nullptr
+    StreamGroup* createGroup(const std::string& name, const StreamID& lastId);
+    StreamGroup* group(const std::string& name) const;
+    bool destroyGroup(const std::string& name);
+    size_t groupCount() const { return groups.size(); }
+    StreamConsumer* consumer(StreamGroup* g, const std::string& name, bool create, bool* created = nullptr);
+    size_t deleteConsumer(StreamGroup* g, const std::string& name);   //返回它还没确认的消息数
+
+    //读取组里的新消息(ID > lastId),投递给 consumer,不是 noack 时加入 PEL
+    std::vector<StreamEntry> readGroup(StreamGroup* g, StreamConsumer* c, size_t count, bool noack, uint64_t nowMs);
+    //重读 consumer 的 PEL 中 ID 大于 after 的消息,投递次数加一
+    std::vector<StreamEntry> readPending(StreamConsumer* c, const StreamID& after, size_t count, uint64_t nowMs);
+    bool ack(StreamGroup* g, const StreamID& id);
+    //按 ID 顺序遍历组的 PEL 中 [start, end] 内的项,c 非空时只看这个消费者的;fn 返回 false 时停止
+    void forEachPending(StreamGroup* g, StreamConsumer* c, const StreamID& start, const StreamID& end, bool reverse,
+                        const std::function<bool(const StreamID&, const StreamNack*)>& fn) const;
+
+private:
+    bool lookup(const StreamID& id, StreamEntry* out) const;
+    size_t trim(bool byLen, size_t maxLen, const StreamID& minId, bool approx);
+    void setBlock(const std::string& key, unsigned char* lp);
+    void freeGroup(StreamGroup* g);
+
+    Rax rax;                    //块的主 ID -> listpack
+    size_t count = 0;
+    StreamID last;
+    //最后一块:追加只发生在这里,记下来免得每次都去 rax 里找
+    std::string tailKey;
+    unsigned char* tail = nullptr;
+    Rax groups;                 //组名 -> StreamGroup*
+};
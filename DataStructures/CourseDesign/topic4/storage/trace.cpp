@@ -0,0 +1,107 @@
+#include "trace.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+struct TraceRing {
+    TraceEvent events[TRACE_RING_EVENTS];
+    std::atomic<uint64_t> head{0};      //写过的总条数,下一条写在 head % TRACE_RING_EVENTS
+    int tid;
+};
+
+std::mutex registryLock;
+std::vector<TraceRing*> rings;          //线程退出后缓冲区也留着,导出时还要用
+std::atomic<bool> enabled{true};
+thread_local TraceRing* localRing = nullptr;
+
+TraceRing* ring() {
+    if (!localRing) {
+        localRing = new TraceRing;
+        std::lock_guard<std::mutex> g(registryLock);
+        localRing->tid = rings.size() + 1;
+        rings.push_back(localRing);
+    }
+    return localRing;
+}
+
+}
+
+uint64_t traceNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void traceRecord(const char* name, uint64_t startNs, uint64_t durNs, const char* detail, size_t len) {
+    TraceRing* r = ring();
+    uint64_t h = r->head.load(std::memory_order_relaxed);
+    TraceEvent& e = r->events[h % TRACE_RING_EVENTS];
+    e.name = name;
+    e.startNs = startNs;
+    e.durNs = durNs;
+    len = std::min(len, sizeof(e.detail) - 1);
+    memcpy(e.detail, detail, len);
+    e.detail[len] = 0;
+    r->head.store(h + 1, std::memory_order_release);
+}
+
+void traceSetEnabled(bool on) {
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+bool traceEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void traceReset() {
+    std::lock_guard<std::mutex> g(registryLock);
+    for (TraceRing* r : rings) r->head.store(0, std::memory_order_release);
+}
+
+size_t traceEventCount() {
+    std::lock_guard<std::mutex> g(registryLock);
+    size_t n = 0;
+    for (TraceRing* r : rings) n += std::min<uint64_t>(r->head.load(std::memory_order_acquire), TRACE_RING_EVENTS);
+    return n;
+}
+
+static void writeEscaped(FILE* f, const char* s) {
+    for (; *s; s++) {
+        unsigned char ch = *s;
+        if (ch == '"' || ch == '\\') fprintf(f, "\\%c", ch);
+        else if (ch < 0x20) fprintf(f, "\\u%04x", ch);
+        else fputc(ch, f);
+    }
+}
+
+long long traceDumpChrome(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return -1;
+    std::lock_guard<std::mutex> g(registryLock);
+    long long n = 0;
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f);
+    for (TraceRing* r : rings) {
+        uint64_t head = r->head.load(std::memory_order_acquire);
+        uint64_t first = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+        for (uint64_t i = first; i < head; i++) {
+            const TraceEvent& e = r->events[i % TRACE_RING_EVENTS];
+            fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                    n ? "," : "", e.name, r->tid, e.startNs / 1000.0, e.durNs / 1000.0);
+            if (e.detail[0]) {
+                fputs(",\"args\":{\"detail\":\"", f);
+                writeEscaped(f, e.detail);
+                fputs("\"}", f);
+            }
+            fputc('}', f);
+            n++;
+        }
+    }
+    fputs("\n]}\n", f);
+    fclose(f);
+    return n;
+}
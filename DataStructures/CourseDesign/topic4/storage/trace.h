@@ -0,0 +1,57 @@
+/*热路径追踪:在 read/解析/执行命令/存储操作/write 周围打点,记下每一段的开始时间和耗时,
+导出成 Chrome trace JSON(chrome://tracing 或 Perfetto 打开),能看出慢请求慢在哪一段。
+编译时加 -DMINIREDIS_TRACE 才生效,不加时 TRACE_SCOPE 展开成空语句,热路径上没有任何代码。
+每个线程一个定长环形缓冲区(TRACE_RING_EVENTS 条),写满后覆盖最旧的;
+写入只碰本线程的缓冲区,不加锁,只有第一次打点时登记缓冲区要拿一次全局锁。
+导出时直接读各线程的缓冲区,正在写的那几条可能是半新半旧的,对分析没有影响*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+static const size_t TRACE_RING_EVENTS = 1 << 16;   //每个线程保留最近这么多段
+
+struct TraceEvent {
+    const char* name;       //必须是字符串字面量,只存指针
+    uint64_t startNs;
+    uint64_t durNs;
+    char detail[16];        //附加信息(比如命令名),截断到 15 个字节
+};
+
+uint64_t traceNowNs();
+void traceRecord(const char* name, uint64_t startNs, uint64_t durNs, const char* detail, size_t len);
+//运行时开关(默认开);关掉后打点只剩一次判断
+void traceSetEnabled(bool on);
+bool traceEnabled();
+void traceReset();
+size_t traceEventCount();
+//所有线程的事件写成 Chrome trace JSON("X" 完整事件,时间单位微秒),返回写出的条数,打不开文件返回 -1
+long long traceDumpChrome(const std::string& path);
+
+//作用域结束时记一段;detail 可以之后再设(比如解析完才知道命令名)
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), start(traceEnabled() ? traceNowNs() : 0) {}
+    TraceScope(const char* name, const std::string& d) : TraceScope(name) { setDetail(d); }
+    ~TraceScope() {
+        if (start) traceRecord(name, start, traceNowNs() - start, detail.data(), detail.size());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+    void setDetail(const std::string& d) { detail = d.substr(0, 15); }
+
+private:
+    const char* name;
+    uint64_t start;
+    std::string detail;
+};
+
+#ifdef MINIREDIS_TRACE
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_SCOPE_DETAIL(name, detail) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, detail)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_DETAIL(name, detail) ((void)0)
+#endif
@@ -0,0 +1,278 @@
+#include "zset.h"
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+struct ZSkipLevel {
+    ZSkipNode* forward;
+    size_t span;        //到 forward 跨过的节点数
+};
+
+struct ZSkipNode {
+    double score;
+    ZSkipNode* backward;
+    uint32_t len;       //成员的字节数
+    uint32_t levels;
+};
+
+static ZSkipLevel* levels(ZSkipNode* n) {
+    return reinterpret_cast<ZSkipLevel*>(n + 1);
+}
+
+static const char* memberOf(ZSkipNode* n) {
+    return reinterpret_cast<const char*>(levels(n) + n->levels);
+}
+
+//和 (score, member) 比较:n 排在前面返回负数
+static int compareNode(ZSkipNode* n, double score, const char* member, size_t len) {
+    if (n->score != score) return n->score < score ? -1 : 1;
+    int c = memcmp(memberOf(n), member, n->len < len ? n->len : len);
+    if (c) return c;
+    return n->len < len ? -1 : (n->len > len ? 1 : 0);
+}
+
+// xorshift:只用来决定层数,不需要好的随机性
+static int randomLevel() {
+    static thread_local uint64_t x = 0x9E3779B97F4A7C15ULL;
+    int level = 1;
+    while (true) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        if ((x & 0xFFFF) >= ZSKIPLIST_P * 0x10000 || level >= ZSKIPLIST_MAXLEVEL) return level;
+        level++;
+    }
+}
+
+std::string formatScore(double v) {
+    if (std::isinf(v)) return v > 0 ? "inf" : "-inf";
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%.17g", v);
+    return std::string(buf, n);
+}
+
+bool parseScore(const std::string& s, double& v) {
+    if (s.empty() || isspace((unsigned char)s[0])) return false;
+    char* end;
+    v = strtod(s.c_str(), &end);
+    return !*end && !std::isnan(v);
+}
+
+ZSet::ZSet() {
+    header = createNode(ZSKIPLIST_MAXLEVEL, 0, nullptr, 0);
+}
+
+ZSet::~ZSet() {
+    ZSkipNode* n = header;
+    while (n) {
+        ZSkipNode* next = levels(n)[0].forward;
+        freeNode(n);
+        n = next;
+    }
+}
+
+ZSkipNode* ZSet::createNode(int lvl, double score, const char* member, size_t len) {
+    size_t size = sizeof(ZSkipNode) + lvl * sizeof(ZSkipLevel) + len;
+    auto* n = static_cast<ZSkipNode*>(malloc(size));
+    n->score = score;
+    n->backward = nullptr;
+    n->len = len;
+    n->levels = lvl;
+    for (int i = 0; i < lvl; i++) levels(n)[i] = {nullptr, 0};
+    if (len) memcpy(const_cast<char*>(memberOf(n)), member, len);
+    allocBytes += size;
+    return n;
+}
+
+void ZSet::freeNode(ZSkipNode* n) {
+    allocBytes -= sizeof(ZSkipNode) + n->levels * sizeof(ZSkipLevel) + n->len;
+    free(n);
+}
+
+ZSkipNode* ZSet::insertNode(double score, const char* member, size_t len) {
+    ZSkipNode* update[ZSKIPLIST_MAXLEVEL];
+    size_t rank[ZSKIPLIST_MAXLEVEL];
+    ZSkipNode* x = header;
+    for (int i = level - 1; i >= 0; i--) {
+        rank[i] = i == level - 1 ? 0 : rank[i + 1];
+        while (levels(x)[i].forward && compareNode(levels(x)[i].forward, score, member, len) < 0) {
+            rank[i] += levels(x)[i].span;
+            x = levels(x)[i].forward;
+        }
+        update[i] = x;
+    }
+    int lvl = randomLevel();
+    if (lvl > level) {
+        for (int i = level; i < lvl; i++) {
+            rank[i] = 0;
+            update[i] = header;
+            levels(header)[i].span = length;
+        }
+        level = lvl;
+    }
+    x = createNode(lvl, score, member, len);
+    for (int i = 0; i < lvl; i++) {
+        levels(x)[i].forward = levels(update[i])[i].forward;
+        levels(update[i])[i].forward = x;
+        // update[i] 到 x 跨过 rank[0] - rank[i] 个节点,原来的 span 分给前后两段
+        levels(x)[i].span = levels(update[i])[i].span - (rank[0] - rank[i]);
+        levels(update[i])[i].span = rank[0] - rank[i] + 1;
+    }
+    for (int i = lvl; i < level; i++) levels(update[i])[i].span++;
+    x->backward = update[0] == header ? nullptr : update[0];
+    if (levels(x)[0].forward) levels(x)[0].forward->backward = x;
+    else tail = x;
+    length++;
+    return x;
+}
+
+void ZSet::deleteNode(ZSkipNode* x, ZSkipNode** update) {
+    for (int i = 0; i < level; i++) {
+        if (levels(update[i])[i].forward == x) {
+            levels(update[i])[i].span += levels(x)[i].span - 1;
+            levels(update[i])[i].forward = levels(x)[i].forward;
+        } else {
+            levels(update[i])[i].span--;
+        }
+    }
+    if (levels(x)[0].forward) levels(x)[0].forward->backward = x->backward;
+    else tail = x->backward;
+    while (level > 1 && !levels(header)[level - 1].forward) level--;
+    length--;
+}
+
+bool ZSet::removeNode(double score, const char* member, size_t len) {
+    ZSkipNode* update[ZSKIPLIST_MAXLEVEL];
+    ZSkipNode* x = header;
+    for (int i = level - 1; i >= 0; i--) {
+        while (levels(x)[i].forward && compareNode(levels(x)[i].forward, score, member, len) < 0)
+            x = levels(x)[i].forward;
+        update[i] = x;
+    }
+    x = levels(x)[0].forward;
+    if (!x || compareNode(x, score, member, len) != 0) return false;
+    deleteNode(x, update);
+    freeNode(x);
+    return true;
+}
+
+bool ZSet::add(const std::string& member, double score) {
+    auto* n = static_cast<ZSkipNode*>(dict.get(member.data(), member.size()));
+    if (n) {
+        if (n->score == score) return false;
+        //新分数不改变它和前后节点的先后顺序时原地改,否则删掉重插
+        ZSkipNode* next = levels(n)[0].forward;
+        if ((!n->backward || n->backward->score < score) && (!next || next->score > score)) {
+            n->score = score;
+            return false;
+        }
+        removeNode(n->score, member.data(), member.size());
+    }
+    ZSkipNode* x = insertNode(score, member.data(), member.size());
+    dict.set(sdsNewLen(member.data(), member.size()), x);
+    return !n;
+}
+
+bool ZSet::remove(const std::string& member) {
+    auto* n = static_cast<ZSkipNode*>(dict.get(member.data(), member.size()));
+    if (!n) return false;
+    removeNode(n->score, member.data(), member.size());
+    dict.del(member.data(), member.size());
+    return true;
+}
+
+bool ZSet::score(const std::string& member, double& out) {
+    auto* n = static_cast<ZSkipNode*>(dict.get(member.data(), member.size()));
+    if (!n) return false;
+    out = n->score;
+    return true;
+}
+
+size_t ZSet::rankOf(double score, const char* member, size_t len) const {
+    size_t rank = 0;
+    ZSkipNode* x = header;
+    for (int i = level - 1; i >= 0; i--) {
+        while (levels(x)[i].forward && compareNode(levels(x)[i].forward, score, member, len) <= 0) {
+            rank += levels(x)[i].span;
+            x = levels(x)[i].forward;
+        }
+        if (x != header && compareNode(x, score, member, len) == 0) return rank;
+    }
+    return 0;
+}
+
+long long ZSet::rank(const std::string& member, bool reverse) {
+    auto* n = static_cast<ZSkipNode*>(dict.get(member.data(), member.size()));
+    if (!n) return -1;
+    size_t r = rankOf(n->score, member.data(), member.size());
+    return reverse ? length - r : r - 1;
+}
+
+ZSkipNode* ZSet::nodeByRank(size_t rank) const {
+    size_t traversed = 0;
+    ZSkipNode* x = header;
+    for (int i = level - 1; i >= 0; i--) {
+        while (levels(x)[i].forward && traversed + levels(x)[i].span <= rank) {
+            traversed += levels(x)[i].span;
+            x = levels(x)[i].forward;
+        }
+        if (traversed == rank) return x;
+    }
+    return nullptr;
+}
+
+ZSkipNode* ZSet::firstInRange(const ZRangeSpec& range) const {
+    ZSkipNode* x = header;
+    for (int i = level - 1; i >= 0; i--)
+        while (levels(x)[i].forward && !range.aboveMin(levels(x)[i].forward->score)) x = levels(x)[i].forward;
+    x = levels(x)[0].forward;
+    return x && range.belowMax(x->score) ? x : nullptr;
+}
+
+ZSkipNode* ZSet::lastInRange(const ZRangeSpec& range) const {
+    ZSkipNode* x = header;
+    for (int i = level - 1; i >= 0; i--)
+        while (levels(x)[i].forward && range.belowMax(levels(x)[i].forward->score)) x = levels(x)[i].forward;
+    return x != header && range.aboveMin(x->score) ? x : nullptr;
+}
+
+std::vector<std::pair<std::string, double>> ZSet::rangeByRank(size_t start, size_t end, bool reverse) const {
+    std::vector<std::pair<std::string, double>> out;
+    if (start >= length || start > end) return out;
+    if (end >= length) end = length - 1;
+    out.reserve(end - start + 1);
+    ZSkipNode* x = nodeByRank(reverse ? length - start : start + 1);
+    for (size_t i = start; i <= end; i++) {
+        out.emplace_back(std::string(memberOf(x), x->len), x->score);
+        x = reverse ? x->backward : levels(x)[0].forward;
+    }
+    return out;
+}
+
+std::vector<std::pair<std::string, double>> ZSet::rangeByScore(const ZRangeSpec& range, bool reverse, size_t offset,
+                                                               size_t count) const {
+    std::vector<std::pair<std::string, double>> out;
+    ZSkipNode* x = reverse ? lastInRange(range) : firstInRange(range);
+    for (; x && offset; offset--) x = reverse ? x->backward : levels(x)[0].forward;
+    while (x && (reverse ? range.aboveMin(x->score) : range.belowMax(x->score))) {
+        out.emplace_back(std::string(memberOf(x), x->len), x->score);
+        if (count && out.size() >= count) break;
+        x = reverse ? x->backward : levels(x)[0].forward;
+    }
+    return out;
+}
+
+//首尾两个节点的排名相减,不用逐个数
+size_t ZSet::count(const ZRangeSpec& range) const {
+    ZSkipNode* first = firstInRange(range);
+    if (!first) return 0;
+    ZSkipNode* last = lastInRange(range);
+    return rankOf(last->score, memberOf(last), last->len) - rankOf(first->score, memberOf(first), first->len) + 1;
+}
+
+void ZSet::forEachInRange(const ZRangeSpec& range,
+                          const std::function<bool(const char*, size_t, double)>& fn) const {
+    for (ZSkipNode* x = firstInRange(range); x && range.belowMax(x->score); x = levels(x)[0].forward)
+        if (!fn(memberOf(x), x->len, x->score)) return;
+}
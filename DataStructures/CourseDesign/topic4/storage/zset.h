@@ -0,0 +1,75 @@
+/*有序集合:成员 -> 分数,按 (分数, 成员) 排序。和 Redis 一样用跳表加哈希表:
+哈希表(Dict)按成员找到跳表节点,O(1) 取分数;跳表按分数排好序,按分数/排名的范围查找都是 O(log n)。
+跳表每层的 span 记录这一步跨过多少个节点,沿路加起来就是排名。
+节点是一块连续内存:<头部> <各层的 forward/span> <成员的字节>,层数随机(每层 1/4 的概率再升一层)*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include "dict.h"
+
+static const int ZSKIPLIST_MAXLEVEL = 32;
+static const double ZSKIPLIST_P = 0.25;
+
+struct ZSkipNode;
+
+//分数区间,minex/maxex 表示不含端点
+struct ZRangeSpec {
+    double min, max;
+    bool minex = false, maxex = false;
+    bool aboveMin(double v) const { return minex ? v > min : v >= min; }
+    bool belowMax(double v) const { return maxex ? v < max : v <= max; }
+};
+
+//分数和字符串互转:输出用 %.17g(能原样读回),输入接受 inf/+inf/-inf,NaN 算非法
+std::string formatScore(double v);
+bool parseScore(const std::string& s, double& v);
+
+class ZSet {
+public:
+    ZSet();
+    ~ZSet();
+    ZSet(const ZSet&) = delete;
+    ZSet& operator=(const ZSet&) = delete;
+
+    size_t size() const { return length; }
+    size_t bytes() const { return allocBytes; }     //跳表节点占用的内存(不含 Dict)
+
+    //新成员返回 true;成员已存在时改分数
+    bool add(const std::string& member, double score);
+    bool remove(const std::string& member);
+    bool score(const std::string& member, double& out);
+    //从 0 开始的排名,reverse 时从大到小排;不存在返回 -1
+    long long rank(const std::string& member, bool reverse);
+
+    //排名在 [start, end] 内的成员(已经换算成非负下标,end 会截到最后一个)
+    std::vector<std::pair<std::string, double>> rangeByRank(size_t start, size_t end, bool reverse) const;
+    //分数在 range 内的成员,跳过前 offset 个,count 为 0 表示不限
+    std::vector<std::pair<std::string, double>> rangeByScore(const ZRangeSpec& range, bool reverse, size_t offset,
+                                                             size_t count) const;
+    size_t count(const ZRangeSpec& range) const;
+    //从小到大遍历分数在 range 内的成员,fn 返回 false 时停止;不分配内存,GEO 搜索用它扫分数区间
+    void forEachInRange(const ZRangeSpec& range,
+                        const std::function<bool(const char* member, size_t len, double score)>& fn) const;
+
+private:
+    ZSkipNode* createNode(int level, double score, const char* member, size_t len);
+    void freeNode(ZSkipNode* n);
+    ZSkipNode* insertNode(double score, const char* member, size_t len);
+    void deleteNode(ZSkipNode* x, ZSkipNode** update);
+    bool removeNode(double score, const char* member, size_t len);
+    ZSkipNode* firstInRange(const ZRangeSpec& range) const;
+    ZSkipNode* lastInRange(const ZRangeSpec& range) const;
+    ZSkipNode* nodeByRank(size_t rank) const;      //从 1 开始
+    size_t rankOf(double score, const char* member, size_t len) const;
+
+    ZSkipNode* header;
+    ZSkipNode* tail = nullptr;
+    int level = 1;
+    size_t length = 0;
+    size_t allocBytes = 0;
+    Dict dict;              //成员 -> ZSkipNode*
+};